@@ -1277,6 +1277,20 @@ extern List slurmdb_events_get(void *db_conn,
  */
 extern List slurmdb_jobs_get(void *db_conn, slurmdb_job_cond_t *job_cond);
 
+/*
+ * get info from the storage one job at a time, so that all the jobs
+ * never need to be held in memory at once
+ * IN:  callback - called with each slurmdb_job_rec_t * as it arrives, the
+ *      job is freed when it returns.  Returning anything but
+ *      SLURM_SUCCESS stops the query.
+ * IN:  arg - passed on to callback
+ * RET: SLURM_SUCCESS on success SLURM_ERROR else
+ */
+extern int slurmdb_jobs_get_cb(void *db_conn, slurmdb_job_cond_t *job_cond,
+			       int (*callback) (slurmdb_job_rec_t *job,
+						void *arg),
+			       void *arg);
+
 /*
  * get info from the storage
  * IN:  slurmdb_assoc_cond_t *
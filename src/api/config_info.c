@@ -480,6 +480,11 @@ extern void *slurm_ctl_conf_2_key_pairs (slurm_ctl_conf_t* slurm_ctl_conf_ptr)
 	key_pair->value = xstrdup(slurm_ctl_conf_ptr->cluster_name);
 	list_append(ret_list, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("CommunicationParameters");
+	key_pair->value = xstrdup(slurm_ctl_conf_ptr->comm_params);
+	list_append(ret_list, key_pair);
+
 	snprintf(tmp_str, sizeof(tmp_str), "%u sec",
 		 slurm_ctl_conf_ptr->complete_wait);
 	key_pair = xmalloc(sizeof(config_key_pair_t));
@@ -1686,6 +1691,9 @@ void slurm_print_slurmd_status (FILE* out,
 	} else
 		fprintf(out, "Last slurmctld msg time  = NONE\n");
 
+	if (slurmd_status_ptr->script_stats)
+		fprintf(out, "Prolog/Epilog Scripts    = %s\n",
+			slurmd_status_ptr->script_stats);
 	fprintf(out, "Slurmd PID               = %u\n",
 		slurmd_status_ptr->pid);
 	fprintf(out, "Slurmd Debug             = %u\n",
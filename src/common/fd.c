@@ -44,11 +44,15 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "src/common/macros.h"
 #include "src/common/fd.h"
 #include "src/common/log.h"
+#include "src/common/xmalloc.h"
 
 /*
  * Define slurm-specific aliases for use by plugins, see slurm_xlator.h 
@@ -335,3 +339,66 @@ extern int wait_fd_readable(int fd, int time_limit)
 		}
 	}
 }
+
+/* Send the cnt file descriptors in fds over the unix domain socket sock,
+ * along with one byte of data. Return 0 on success or -1 on error */
+extern int fd_send_fds(int sock, int *fds, int cnt)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	char c = 0, *cbuf;
+	int rc;
+
+	cbuf = xmalloc(CMSG_SPACE(sizeof(int) * cnt));
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &c;
+	iov.iov_len = 1;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * cnt);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * cnt);
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * cnt);
+
+	while (((rc = sendmsg(sock, &msg, 0)) < 0) && (errno == EINTR))
+		;
+	xfree(cbuf);
+	return (rc == 1) ? 0 : -1;
+}
+
+/* Receive cnt file descriptors sent by fd_send_fds() on sock into fds.
+ * Return 0 on success, -1 on error or if sock was closed by its peer */
+extern int fd_recv_fds(int sock, int *fds, int cnt)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	struct cmsghdr *cmsg;
+	char c, *cbuf;
+	int rc;
+
+	cbuf = xmalloc(CMSG_SPACE(sizeof(int) * cnt));
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &c;
+	iov.iov_len = 1;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * cnt);
+
+	while (((rc = recvmsg(sock, &msg, 0)) < 0) && (errno == EINTR))
+		;
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if ((rc != 1) || !cmsg || (cmsg->cmsg_level != SOL_SOCKET) ||
+	    (cmsg->cmsg_type != SCM_RIGHTS) ||
+	    (cmsg->cmsg_len != CMSG_LEN(sizeof(int) * cnt))) {
+		xfree(cbuf);
+		return -1;
+	}
+	memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * cnt);
+	xfree(cbuf);
+	return 0;
+}
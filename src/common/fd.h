@@ -163,4 +163,12 @@ extern int wait_fd_readable(int fd, int time_limit);
 /* Wait for a file descriptor to be readable (up to time_limit seconds).
  * Return 0 when readable or -1 on error */
 
+extern int fd_send_fds(int sock, int *fds, int cnt);
+/* Send the cnt file descriptors in fds over the unix domain socket sock,
+ * along with one byte of data. Return 0 on success or -1 on error */
+
+extern int fd_recv_fds(int sock, int *fds, int cnt);
+/* Receive cnt file descriptors sent by fd_send_fds() on sock into fds.
+ * Return 0 on success, -1 on error or if sock was closed by its peer */
+
 #endif /* !_FD_H */
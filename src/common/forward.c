@@ -46,16 +46,26 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
 
 #include "slurm/slurm.h"
 
+#include "src/common/fd.h"
 #include "src/common/forward.h"
+#include "src/common/macros.h"
+#include "src/common/pack.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/common/slurm_auth.h"
 #include "src/common/slurm_route.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/slurm_protocol_pack.h"
 
 #ifdef WITH_PTHREADS
 #  include <pthread.h>
@@ -63,545 +73,702 @@
 
 #define MAX_RETRIES 3
 
-typedef struct {
-	pthread_cond_t *notify;
-	int            *p_thr_count;
-	slurm_msg_t *orig_msg;
-	List ret_list;
-	int timeout;
-	hostlist_t tree_hl;
-	pthread_mutex_t *tree_mutex;
-} fwd_tree_t;
-
-static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
-				     fwd_tree_t *fwd_tree_in,
-				     int hl_count);
-static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
-				  forward_struct_t *fwd_struct,
-				  header_t *header, int timeout,
-				  int hl_count);
-
-void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
+/*
+ * Forwarding engine
+ *
+ * Messages are forwarded to the head node of every subtree over
+ * non-blocking connections, all of them driven by a single poll() loop in
+ * _fwd_io(). Responses are authenticated and merged into the caller's
+ * ret_list by a small pool of _fwd_worker() threads as they arrive, so a
+ * wide broadcast costs a fixed number of threads rather than one per
+ * subtree. The threads are created on first use and shared by every
+ * forward_msg(), start_msg_tree() and forward_msg_nodes() call of the
+ * process.
+ */
+#define FWD_CONN_CNT	512	/* maximum concurrent connections */
+#define FWD_WORKER_CNT	4	/* threads processing responses */
+#define FWD_MAX_MSG_SIZE (1024*1024*1024)
+
+typedef enum {
+	FWD_DELAY,	/* Waiting to retry a refused connection */
+	FWD_CONNECT,	/* Waiting for connect() to complete */
+	FWD_SEND,	/* Writing message */
+	FWD_RECV_LEN,	/* Reading response length */
+	FWD_RECV,	/* Reading response body */
+	FWD_DONE	/* Response received or connection failed */
+} fwd_state_t;
+
+typedef struct fwd_job {
+	header_t header;	/* header of message being forwarded */
+	char *buf;		/* auth credential and body of message */
+	int buf_len;
+	int timeout;		/* msec to wait for a response per hop */
+	bool conn_retry;	/* retry refused connections for a while */
+	List ret_list;		/* responses, protected by mutex */
+	pthread_mutex_t *mutex;
+	pthread_cond_t *notify;	/* signaled as responses arrive */
+	int active;		/* connections in progress */
+	bool free_job;		/* free job once active reaches zero */
+	slurm_msg_t *msg;	/* if set, packed anew for each connection
+				 * rather than sending buf, only used while
+				 * the connections are queued */
+	forward_node_cb_t callback; /* if set, given each node's ret_list
+				 * rather than adding it to ret_list */
+	void *cb_arg;
+	pthread_mutex_t job_mutex; /* mutex of a forward_msg_nodes() job */
+} fwd_job_t;
+
+typedef struct fwd_conn {
+	fwd_job_t *job;
+	char *name;		/* node the message is sent to */
+	hostlist_t hl;		/* nodes it forwards the message to */
+	int node_inx;		/* index of name for job->callback */
+	Buf buffer;		/* message with length prefix */
+	int fd;
+	fwd_state_t state;
+	int64_t deadline;	/* msec time of next timeout or retry */
+	int timeout;		/* msec to wait for the response */
+	int refused_cnt;	/* connections refused so far */
+	uint32_t len;		/* response length, network order at first */
+	uint32_t offset;	/* bytes transferred in this state */
+	char *data;		/* response body */
+	int err;		/* reason for failure */
+} fwd_conn_t;
+
+static pthread_mutex_t fwd_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  fwd_done_cond = PTHREAD_COND_INITIALIZER;
+static List fwd_start_list = NULL;	/* fwd_conn_t to be started */
+static List fwd_done_list = NULL;	/* fwd_conn_t to be processed */
+static int  fwd_wake_fd[2] = {-1, -1};	/* wake up _fwd_io() */
+static bool fwd_started = false;
+static uint16_t fwd_conn_timeout = 0;	/* seconds to retry connections */
+
+static int64_t _now_msec(void)
 {
-	if (fwd_tree) {
-		if (fwd_tree->tree_hl)
-			hostlist_destroy(fwd_tree->tree_hl);
+	struct timeval tv;
 
-		/*
-		 * Lock and decrease thread counter, start_msg_tree is waiting
-		 * for a null thread count to exit its main loop
-		 */
-		slurm_mutex_lock(fwd_tree->tree_mutex);
-		(*(fwd_tree->p_thr_count))--;
-		pthread_cond_signal(fwd_tree->notify);
-		slurm_mutex_unlock(fwd_tree->tree_mutex);
+	gettimeofday(&tv, NULL);
+	return ((int64_t) tv.tv_sec * 1000) + (tv.tv_usec / 1000);
+}
 
-		xfree(fwd_tree);
+/* Discard engine state inherited from a parent which had started it */
+static void _fwd_atfork_child(void)
+{
+	slurm_mutex_init(&fwd_mutex);
+	pthread_cond_init(&fwd_done_cond, NULL);
+	fwd_start_list = NULL;
+	fwd_done_list = NULL;
+	if (fwd_wake_fd[0] >= 0) {
+		(void) close(fwd_wake_fd[0]);
+		(void) close(fwd_wake_fd[1]);
+		fwd_wake_fd[0] = fwd_wake_fd[1] = -1;
 	}
+	fwd_started = false;
 }
 
-void *_forward_thread(void *arg)
+static void _fwd_job_destroy(fwd_job_t *job)
 {
-	forward_msg_t *fwd_msg = (forward_msg_t *)arg;
-	forward_struct_t *fwd_struct = fwd_msg->fwd_struct;
-	Buf buffer = init_buf(BUF_SIZE);	/* probably enough for header */
-	List ret_list = NULL;
-	slurm_fd_t fd = -1;
-	ret_data_info_t *ret_data_info = NULL;
-	char *name = NULL;
-	hostlist_t hl = hostlist_create(fwd_msg->header.forward.nodelist);
-	slurm_addr_t addr;
-	char *buf = NULL;
-	int steps = 0;
-	int start_timeout = fwd_msg->timeout;
-
-	/* repeat until we are sure the message was sent */
-	while ((name = hostlist_shift(hl))) {
-		if (slurm_conf_get_addr(name, &addr) == SLURM_ERROR) {
-			error("forward_thread: can't find address for host "
-			      "%s, check slurm.conf", name);
-			slurm_mutex_lock(&fwd_struct->forward_mutex);
-			mark_as_failed_forward(&fwd_struct->ret_list, name,
-					       SLURM_UNKNOWN_FORWARD_ADDR);
- 			free(name);
-			if (hostlist_count(hl) > 0) {
-				slurm_mutex_unlock(&fwd_struct->forward_mutex);
-				continue;
-			}
-			goto cleanup;
-		}
-		if ((fd = slurm_open_msg_conn(&addr)) < 0) {
-			error("forward_thread to %s: %m", name);
+	destroy_forward(&job->header.forward);
+	if (job->mutex == &job->job_mutex)
+		slurm_mutex_destroy(&job->job_mutex);
+	xfree(job->buf);
+	xfree(job);
+}
 
-			slurm_mutex_lock(&fwd_struct->forward_mutex);
-			mark_as_failed_forward(
-				&fwd_struct->ret_list, name,
-				SLURM_COMMUNICATIONS_CONNECTION_ERROR);
-			free(name);
-			if (hostlist_count(hl) > 0) {
-				slurm_mutex_unlock(&fwd_struct->forward_mutex);
-				/* Abandon tree. This way if all the
-				 * nodes in the branch are down we
-				 * don't have to time out for each
-				 * node serially.
-				 */
-				_forward_msg_internal(hl, NULL, fwd_struct,
-						      &fwd_msg->header, 0,
-						      hostlist_count(hl));
-				continue;
-			}
-			goto cleanup;
-		}
-		buf = hostlist_ranged_string_xmalloc(hl);
-
-		xfree(fwd_msg->header.forward.nodelist);
-		fwd_msg->header.forward.nodelist = buf;
-		fwd_msg->header.forward.cnt = hostlist_count(hl);
-#if 0
-		info("sending %d forwards (%s) to %s",
-		     fwd_msg->header.forward.cnt,
-		     fwd_msg->header.forward.nodelist, name);
-#endif
-		if (fwd_msg->header.forward.nodelist[0]) {
-			debug3("forward: send to %s along with %s",
-			       name, fwd_msg->header.forward.nodelist);
-		} else
-			debug3("forward: send to %s ", name);
-
-		pack_header(&fwd_msg->header, buffer);
-
-		/* add forward data to buffer */
-		if (remaining_buf(buffer) < fwd_struct->buf_len) {
-			int new_size = buffer->processed + fwd_struct->buf_len;
-			new_size += 1024; /* padded for paranoia */
-			xrealloc_nz(buffer->head, new_size);
-			buffer->size = new_size;
-		}
-		if (fwd_struct->buf_len) {
-			memcpy(&buffer->head[buffer->processed],
-			       fwd_struct->buf, fwd_struct->buf_len);
-			buffer->processed += fwd_struct->buf_len;
-		}
+static void _fwd_conn_destroy(fwd_conn_t *conn)
+{
+	if (conn->fd >= 0)
+		(void) close(conn->fd);
+	if (conn->hl)
+		hostlist_destroy(conn->hl);
+	if (conn->buffer)
+		free_buf(conn->buffer);
+	free(conn->name);
+	xfree(conn->data);
+	xfree(conn);
+}
 
-		/*
-		 * forward message
-		 */
-		if (slurm_msg_sendto(fd,
-				     get_buf_data(buffer),
-				     get_buf_offset(buffer),
-				     SLURM_PROTOCOL_NO_SEND_RECV_FLAGS ) < 0) {
-			error("forward_thread: slurm_msg_sendto: %m");
-
-			slurm_mutex_lock(&fwd_struct->forward_mutex);
-			mark_as_failed_forward(&fwd_struct->ret_list, name,
-					       errno);
-			free(name);
-			if (hostlist_count(hl) > 0) {
-				free_buf(buffer);
-				buffer = init_buf(fwd_struct->buf_len);
-				slurm_mutex_unlock(&fwd_struct->forward_mutex);
-				slurm_close(fd);
-				fd = -1;
-				/* Abandon tree. This way if all the
-				 * nodes in the branch are down we
-				 * don't have to time out for each
-				 * node serially.
-				 */
-				_forward_msg_internal(hl, NULL, fwd_struct,
-						      &fwd_msg->header, 0,
-						      hostlist_count(hl));
-				continue;
-			}
-			goto cleanup;
-		}
+/* Pack the job's message, with a new credential, for a connection which
+ * does not forward it any further */
+static int _fwd_conn_pack_msg(fwd_conn_t *conn)
+{
+	fwd_job_t *job = conn->job;
+	Buf msg_buf;
+	uint32_t len;
 
-		if ((fwd_msg->header.msg_type == REQUEST_SHUTDOWN) ||
-		    (fwd_msg->header.msg_type == REQUEST_RECONFIGURE) ||
-		    (fwd_msg->header.msg_type == REQUEST_REBOOT_NODES)) {
-			slurm_mutex_lock(&fwd_struct->forward_mutex);
-			ret_data_info = xmalloc(sizeof(ret_data_info_t));
-			list_push(fwd_struct->ret_list, ret_data_info);
-			ret_data_info->node_name = xstrdup(name);
-			free(name);
-			while ((name = hostlist_shift(hl))) {
-				ret_data_info =
-					xmalloc(sizeof(ret_data_info_t));
-				list_push(fwd_struct->ret_list, ret_data_info);
-				ret_data_info->node_name = xstrdup(name);
-				free(name);
-			}
-			goto cleanup;
-		}
+	if (!(msg_buf = slurm_pack_node_msg(job->msg))) {
+		error("forward: unable to pack %s for %s",
+		      rpc_num2string(job->msg->msg_type), conn->name);
+		return SLURM_ERROR;
+	}
+	len = get_buf_offset(msg_buf);
+	conn->buffer = init_buf(len + sizeof(uint32_t));
+	pack32(len, conn->buffer);
+	memcpy(&conn->buffer->head[conn->buffer->processed],
+	       get_buf_data(msg_buf), len);
+	conn->buffer->processed += len;
+	free_buf(msg_buf);
+	conn->timeout = job->timeout;
+	debug3("forward: send to %s ", conn->name);
 
-		if (fwd_msg->header.forward.cnt > 0) {
-			static int message_timeout = -1;
-			if (message_timeout < 0)
-				message_timeout =
-					slurm_get_msg_timeout() * 1000;
-			steps = (fwd_msg->header.forward.cnt+1) /
-				slurm_get_tree_width();
-			fwd_msg->timeout = (message_timeout*steps);
-			/* info("got %d * %d = %d", message_timeout, */
-			/*      steps, fwd_msg->timeout); */
-			steps++;
-			fwd_msg->timeout += (start_timeout*steps);
-			/* info("now  + %d*%d = %d", start_timeout, */
-			/*      steps, fwd_msg->timeout); */
-		}
+	return SLURM_SUCCESS;
+}
 
-		ret_list = slurm_receive_msgs(fd, steps, fwd_msg->timeout);
-		/* info("sent %d forwards got %d back", */
-		/*      fwd_msg->header.forward.cnt, list_count(ret_list)); */
+/* Pack the job's message for conn, forwarding it to conn->hl */
+static int _fwd_conn_pack(fwd_conn_t *conn)
+{
+	fwd_job_t *job = conn->job;
+	header_t header;
+	uint32_t len;
+
+	if (job->msg)
+		return _fwd_conn_pack_msg(conn);
+
+	memcpy(&header, &job->header, sizeof(header_t));
+	forward_init(&header.forward, NULL);
+	header.ret_cnt = 0;
+	header.ret_list = NULL;
+	if (conn->hl && (header.forward.cnt = hostlist_count(conn->hl))) {
+		header.forward.nodelist =
+			hostlist_ranged_string_xmalloc(conn->hl);
+		header.forward.timeout = job->timeout;
+		debug3("forward: send to %s along with %s",
+		       conn->name, header.forward.nodelist);
+	} else
+		debug3("forward: send to %s ", conn->name);
+
+	conn->buffer = init_buf(BUF_SIZE + job->buf_len);
+	pack32(0, conn->buffer);	/* length, filled in below */
+	pack_header(&header, conn->buffer);
+	if (remaining_buf(conn->buffer) < job->buf_len) {
+		conn->buffer->size = conn->buffer->processed + job->buf_len;
+		xrealloc_nz(conn->buffer->head, conn->buffer->size);
+	}
+	memcpy(&conn->buffer->head[conn->buffer->processed],
+	       job->buf, job->buf_len);
+	conn->buffer->processed += job->buf_len;
+
+	len = get_buf_offset(conn->buffer);
+	set_buf_offset(conn->buffer, 0);
+	pack32(len - sizeof(uint32_t), conn->buffer);
+	set_buf_offset(conn->buffer, len);
+
+	/* Time to wait for our children, message_timeout plus the hop
+	 * timeout per level of the tree below us */
+	if (header.forward.cnt > 0) {
+		int message_timeout = slurm_get_msg_timeout() * 1000;
+		int width = slurm_get_tree_width();
+		int steps = header.forward.cnt + 1;
+
+		if (width)
+			steps /= width;
+		conn->timeout = message_timeout * steps;
+		conn->timeout += job->timeout * (steps + 1);
+	} else
+		conn->timeout = job->timeout;
+	destroy_forward(&header.forward);
 
-		if (!ret_list || (fwd_msg->header.forward.cnt != 0
-				  && list_count(ret_list) <= 1)) {
-			slurm_mutex_lock(&fwd_struct->forward_mutex);
-			mark_as_failed_forward(&fwd_struct->ret_list, name,
-					       errno);
-			free(name);
-			if (ret_list)
-				list_destroy(ret_list);
-			if (hostlist_count(hl) > 0) {
-				free_buf(buffer);
-				buffer = init_buf(fwd_struct->buf_len);
-				slurm_mutex_unlock(&fwd_struct->forward_mutex);
-				slurm_close(fd);
-				fd = -1;
-				continue;
-			}
-			goto cleanup;
-		} else if ((fwd_msg->header.forward.cnt+1)
-			  != list_count(ret_list)) {
-			/* this should never be called since the above
-			   should catch the failed forwards and pipe
-			   them back down, but this is here so we
-			   never have to worry about a locked
-			   mutex */
-			ListIterator itr = NULL;
-			char *tmp = NULL;
-			int first_node_found = 0;
-			hostlist_iterator_t host_itr
-				= hostlist_iterator_create(hl);
-			error("We shouldn't be here.  We forwarded to %d "
-			      "but only got %d back",
-			      (fwd_msg->header.forward.cnt+1),
-			      list_count(ret_list));
-			while ((tmp = hostlist_next(host_itr))) {
-				int node_found = 0;
-				itr = list_iterator_create(ret_list);
-				while ((ret_data_info = list_next(itr))) {
-					if (!ret_data_info->node_name) {
-						first_node_found = 1;
-						ret_data_info->node_name =
-							xstrdup(name);
-					}
-					if (!strcmp(tmp,
-						   ret_data_info->node_name)) {
-						node_found = 1;
-						break;
-					}
-				}
-				list_iterator_destroy(itr);
-				if (!node_found) {
-					mark_as_failed_forward(
-						&fwd_struct->ret_list,
-						tmp,
-						SLURM_COMMUNICATIONS_CONNECTION_ERROR);
-				}
-				free(tmp);
-			}
-			hostlist_iterator_destroy(host_itr);
-			if (!first_node_found) {
-				mark_as_failed_forward(
-					&fwd_struct->ret_list,
-					name,
-					SLURM_COMMUNICATIONS_CONNECTION_ERROR);
-			}
+	return SLURM_SUCCESS;
+}
+
+/* Open a non-blocking connection to conn->name */
+static void _fwd_conn_connect(fwd_conn_t *conn, int64_t now)
+{
+	slurm_addr_t addr;
+
+	conn->state = FWD_DONE;
+	conn->offset = 0;
+	if (slurm_conf_get_addr(conn->name, &addr) == SLURM_ERROR) {
+		error("forward: can't find address for host %s, "
+		      "check slurm.conf", conn->name);
+		conn->err = SLURM_UNKNOWN_FORWARD_ADDR;
+		return;
+	}
+	if ((conn->fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0) {
+		error("forward: socket: %m");
+		conn->err = SLURM_COMMUNICATIONS_CONNECTION_ERROR;
+		return;
+	}
+	fd_set_nonblocking(conn->fd);
+	fd_set_close_on_exec(conn->fd);
+	if (connect(conn->fd, (struct sockaddr *) &addr, sizeof(addr)) == 0)
+		conn->state = FWD_SEND;
+	else if (errno == EINPROGRESS)
+		conn->state = FWD_CONNECT;
+	else
+		conn->err = errno;
+	conn->deadline = now + (slurm_get_msg_timeout() * 1000);
+}
+
+/* Handle a failed connection attempt, retrying a refused one once a
+ * second for a while to survive slurmd restarts */
+static void _fwd_conn_failed(fwd_conn_t *conn, int err, int64_t now)
+{
+	(void) close(conn->fd);
+	conn->fd = -1;
+	if (conn->job->conn_retry && (err == ECONNREFUSED) &&
+	    (conn->refused_cnt++ < fwd_conn_timeout)) {
+		if (conn->refused_cnt == 1)
+			debug3("connect refused, retrying");
+		conn->state = FWD_DELAY;
+		conn->deadline = now + 1000;
+		return;
+	}
+	debug2("forward: connect to %s: %s", conn->name, strerror(err));
+	conn->err = SLURM_COMMUNICATIONS_CONNECTION_ERROR;
+	conn->state = FWD_DONE;
+}
+
+/* Write as much of the message as the socket accepts */
+static void _fwd_conn_send(fwd_conn_t *conn, int64_t now)
+{
+	uint32_t size = get_buf_offset(conn->buffer);
+	ssize_t n;
+
+	while (conn->offset < size) {
+		n = send(conn->fd, get_buf_data(conn->buffer) + conn->offset,
+			 size - conn->offset, MSG_NOSIGNAL);
+		if (n < 0) {
+			if ((errno == EINTR) || (errno == EAGAIN) ||
+			    (errno == EWOULDBLOCK))
+				return;
+			error("forward: send to %s: %m", conn->name);
+			conn->err = errno;
+			conn->state = FWD_DONE;
+			return;
 		}
-		break;
+		conn->offset += n;
 	}
-	slurm_mutex_lock(&fwd_struct->forward_mutex);
-	if (ret_list) {
-		while ((ret_data_info = list_pop(ret_list)) != NULL) {
-			if (!ret_data_info->node_name) {
-				ret_data_info->node_name = xstrdup(name);
-			}
-			list_push(fwd_struct->ret_list, ret_data_info);
-			debug3("got response from %s",
-			       ret_data_info->node_name);
+	free_buf(conn->buffer);
+	conn->buffer = NULL;
+
+	if ((conn->job->header.msg_type == REQUEST_SHUTDOWN) ||
+	    (conn->job->header.msg_type == REQUEST_RECONFIGURE) ||
+	    (conn->job->header.msg_type == REQUEST_REBOOT_NODES)) {
+		/* No response expected */
+		conn->state = FWD_DONE;
+		return;
+	}
+	conn->deadline = now + conn->timeout;
+	conn->offset = 0;
+	conn->state = FWD_RECV_LEN;
+}
+
+/* Read as much of the response as is available */
+static void _fwd_conn_recv(fwd_conn_t *conn)
+{
+	ssize_t n;
+
+	while (conn->state == FWD_RECV_LEN) {
+		n = recv(conn->fd, (char *) &conn->len + conn->offset,
+			 sizeof(conn->len) - conn->offset, 0);
+		if ((n < 0) && ((errno == EINTR) || (errno == EAGAIN) ||
+				(errno == EWOULDBLOCK)))
+			return;
+		if (n <= 0) {
+			conn->err = n ? errno :
+				SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+			conn->state = FWD_DONE;
+			return;
 		}
-		list_destroy(ret_list);
+		conn->offset += n;
+		if (conn->offset < sizeof(conn->len))
+			continue;
+		conn->len = ntohl(conn->len);
+		if (conn->len > FWD_MAX_MSG_SIZE) {
+			conn->err = SLURM_PROTOCOL_INSANE_MSG_LENGTH;
+			conn->state = FWD_DONE;
+			return;
+		}
+		conn->data = xmalloc_nz(conn->len);
+		conn->offset = 0;
+		conn->state = FWD_RECV;
 	}
-	free(name);
-cleanup:
-	if ((fd >= 0) && slurm_close(fd) < 0)
-		error ("close(%d): %m", fd);
-	hostlist_destroy(hl);
-	destroy_forward(&fwd_msg->header.forward);
-	free_buf(buffer);
-	pthread_cond_signal(&fwd_struct->notify);
-	slurm_mutex_unlock(&fwd_struct->forward_mutex);
-	xfree(fwd_msg);
 
-	return (NULL);
+	while (conn->offset < conn->len) {
+		n = recv(conn->fd, conn->data + conn->offset,
+			 conn->len - conn->offset, 0);
+		if ((n < 0) && ((errno == EINTR) || (errno == EAGAIN) ||
+				(errno == EWOULDBLOCK)))
+			return;
+		if (n <= 0) {
+			conn->err = n ? errno :
+				SLURM_COMMUNICATIONS_RECEIVE_ERROR;
+			xfree(conn->data);
+			conn->state = FWD_DONE;
+			return;
+		}
+		conn->offset += n;
+	}
+	conn->state = FWD_DONE;
 }
 
-void *_fwd_tree_thread(void *arg)
+/* Advance a connection's state given the poll() events on it */
+static void _fwd_conn_io(fwd_conn_t *conn, short revents, int64_t now)
 {
-	fwd_tree_t *fwd_tree = (fwd_tree_t *)arg;
-	List ret_list = NULL;
-	char *name = NULL;
-	char *buf = NULL;
-	slurm_msg_t send_msg;
+	int err = 0;
+	socklen_t len = sizeof(err);
+
+	if (conn->state == FWD_CONNECT) {
+		if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0)
+			err = errno;
+		if (err) {
+			_fwd_conn_failed(conn, err, now);
+			return;
+		}
+		conn->state = FWD_SEND;
+	}
+	if (conn->state == FWD_SEND)
+		_fwd_conn_send(conn, now);
+	else if (revents & (POLLIN | POLLHUP | POLLERR))
+		_fwd_conn_recv(conn);
+}
 
-	slurm_msg_t_init(&send_msg);
-	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
-	send_msg.data = fwd_tree->orig_msg->data;
-	send_msg.protocol_version = fwd_tree->orig_msg->protocol_version;
-
-	/* repeat until we are sure the message was sent */
-	while ((name = hostlist_shift(fwd_tree->tree_hl))) {
-		if (slurm_conf_get_addr(name, &send_msg.address)
-		    == SLURM_ERROR) {
-			error("fwd_tree_thread: can't find address for host "
-			      "%s, check slurm.conf", name);
-			slurm_mutex_lock(fwd_tree->tree_mutex);
-			mark_as_failed_forward(&fwd_tree->ret_list, name,
-					       SLURM_UNKNOWN_FORWARD_ADDR);
- 			pthread_cond_signal(fwd_tree->notify);
-			slurm_mutex_unlock(fwd_tree->tree_mutex);
-			free(name);
+/*
+ * _fwd_io - Forwarding engine I/O thread. Connects to the nodes of queued
+ *	connections, sends them their message and reads their response,
+ *	passing every finished connection to _fwd_worker().
+ */
+static void *_fwd_io(void *args)
+{
+	fwd_conn_t **conns, *conn;
+	struct pollfd *pfds;
+	struct rlimit rlim;
+	int64_t now;
+	int conn_cnt = 0, max_conns = FWD_CONN_CNT, timeout, i;
+	char buf[64];
+
+	/* Leave most of the available file descriptors for other use */
+	if ((getrlimit(RLIMIT_NOFILE, &rlim) == 0) &&
+	    (rlim.rlim_cur != RLIM_INFINITY) &&
+	    (rlim.rlim_cur / 4 < max_conns))
+		max_conns = MAX(rlim.rlim_cur / 4, 1);
+	conns = xmalloc(sizeof(fwd_conn_t *) * max_conns);
+	pfds  = xmalloc(sizeof(struct pollfd) * (max_conns + 1));
+
+	while (1) {
+		now = _now_msec();
+
+		slurm_mutex_lock(&fwd_mutex);
+		while ((conn_cnt < max_conns) &&
+		       (conn = list_dequeue(fwd_start_list))) {
+			if (conn->buffer)
+				_fwd_conn_connect(conn, now);
+			else
+				conn->state = FWD_DONE;
+			conns[conn_cnt++] = conn;
+		}
+		slurm_mutex_unlock(&fwd_mutex);
+
+		timeout = 1000;
+		pfds[0].fd = fwd_wake_fd[0];
+		pfds[0].events = POLLIN;
+		for (i = 0; i < conn_cnt; i++) {
+			conn = conns[i];
+			pfds[i + 1].revents = 0;
+			if ((conn->state == FWD_DONE) ||
+			    (conn->state == FWD_DELAY))
+				pfds[i + 1].fd = -1;
+			else
+				pfds[i + 1].fd = conn->fd;
+			if (conn->state <= FWD_SEND)
+				pfds[i + 1].events = POLLOUT;
+			else
+				pfds[i + 1].events = POLLIN;
+			if (conn->state == FWD_DONE)
+				timeout = 0;
+			else if (conn->deadline - now < timeout)
+				timeout = MAX(conn->deadline - now, 0);
+		}
 
+		if ((poll(pfds, conn_cnt + 1, timeout) < 0) &&
+		    (errno != EINTR)) {
+			error("forward: poll: %m");
 			continue;
 		}
+		if (pfds[0].revents & POLLIN) {
+			while (read(fwd_wake_fd[0], buf, sizeof(buf)) > 0)
+				;
+		}
 
-		send_msg.forward.timeout = fwd_tree->timeout;
-		if ((send_msg.forward.cnt = hostlist_count(fwd_tree->tree_hl))){
-			buf = hostlist_ranged_string_xmalloc(
-					fwd_tree->tree_hl);
-			send_msg.forward.nodelist = buf;
-		} else
-			send_msg.forward.nodelist = NULL;
-
-		if (send_msg.forward.nodelist && send_msg.forward.nodelist[0]) {
-			debug3("Tree sending to %s along with %s",
-			       name, send_msg.forward.nodelist);
-		} else
-			debug3("Tree sending to %s", name);
-
-		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
-						     fwd_tree->timeout);
-
-		xfree(send_msg.forward.nodelist);
-
-		if (ret_list) {
-			int ret_cnt = list_count(ret_list);
-			/* This is most common if a slurmd is running
-			   an older version of Slurm than the
-			   originator of the message.
-			*/
-			if ((ret_cnt <= send_msg.forward.cnt) &&
-			    (errno != SLURM_COMMUNICATIONS_CONNECTION_ERROR)) {
-				error("fwd_tree_thread: %s failed to forward "
-				      "the message, expecting %d ret got only "
-				      "%d",
-				      name, send_msg.forward.cnt + 1, ret_cnt);
-				if (ret_cnt > 1) { /* not likely */
-					ret_data_info_t *ret_data_info = NULL;
-					ListIterator itr =
-						list_iterator_create(ret_list);
-					while ((ret_data_info =
-						list_next(itr))) {
-						if (strcmp(ret_data_info->
-							   node_name, name))
-							hostlist_delete_host(
-								fwd_tree->
-								tree_hl,
-								ret_data_info->
-								node_name);
-					}
-					list_iterator_destroy(itr);
-				}
+		now = _now_msec();
+		for (i = 0; i < conn_cnt; i++) {
+			conn = conns[i];
+			if (conn->state == FWD_DONE)
+				continue;
+			if (conn->state == FWD_DELAY) {
+				if (now >= conn->deadline)
+					_fwd_conn_connect(conn, now);
+				continue;
+			}
+			if (pfds[i + 1].revents)
+				_fwd_conn_io(conn, pfds[i + 1].revents, now);
+			if ((conn->state != FWD_DONE) &&
+			    (conn->state != FWD_DELAY) &&
+			    (now >= conn->deadline)) {
+				debug2("forward: %s timed out", conn->name);
+				if (conn->state == FWD_CONNECT)
+					conn->err = ETIMEDOUT;
+				else
+					conn->err =
+					    SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT;
+				conn->state = FWD_DONE;
 			}
+		}
 
-			slurm_mutex_lock(fwd_tree->tree_mutex);
-			list_transfer(fwd_tree->ret_list, ret_list);
-			pthread_cond_signal(fwd_tree->notify);
-			slurm_mutex_unlock(fwd_tree->tree_mutex);
-			list_destroy(ret_list);
-			/* try next node */
-			if (ret_cnt <= send_msg.forward.cnt) {
-				free(name);
-				/* Abandon tree. This way if all the
-				 * nodes in the branch are down we
-				 * don't have to time out for each
-				 * node serially.
-				 */
-				_start_msg_tree_internal(
-					fwd_tree->tree_hl, NULL,
-					fwd_tree,
-					hostlist_count(fwd_tree->tree_hl));
+		/* Hand completed connections to _fwd_worker() */
+		slurm_mutex_lock(&fwd_mutex);
+		for (i = 0; i < conn_cnt; ) {
+			conn = conns[i];
+			if (conn->state != FWD_DONE) {
+				i++;
 				continue;
 			}
-		} else {
-			/* This should never happen (when this was
-			 * written slurm_send_addr_recv_msgs always
-			 * returned a list */
-			error("fwd_tree_thread: no return list given from "
-			      "slurm_send_addr_recv_msgs spawned for %s",
-			      name);
-			slurm_mutex_lock(fwd_tree->tree_mutex);
-			mark_as_failed_forward(
-				&fwd_tree->ret_list, name,
-				SLURM_COMMUNICATIONS_CONNECTION_ERROR);
- 			pthread_cond_signal(fwd_tree->notify);
-			slurm_mutex_unlock(fwd_tree->tree_mutex);
-			free(name);
-
-			continue;
+			if (conn->fd >= 0) {
+				(void) close(conn->fd);
+				conn->fd = -1;
+			}
+			list_append(fwd_done_list, conn);
+			pthread_cond_signal(&fwd_done_cond);
+			conns[i] = conns[--conn_cnt];
 		}
+		slurm_mutex_unlock(&fwd_mutex);
+	}
 
-		free(name);
+	return NULL;
+}
 
-		/* check for error and try again */
-		if (errno == SLURM_COMMUNICATIONS_CONNECTION_ERROR)
- 			continue;
+/* Queue a connection sending job's message to name, which forwards it
+ * to hl. Call with job->mutex locked.
+ * The message is packed here, in the caller's thread, so that creating
+ * its credential never holds up the connections driven by _fwd_io(). */
+static void _fwd_queue(fwd_job_t *job, char *name, hostlist_t hl,
+		       int node_inx)
+{
+	fwd_conn_t *conn = xmalloc(sizeof(fwd_conn_t));
+	char c = 0;
+
+	conn->job = job;
+	conn->name = name;
+	conn->hl = hl;
+	conn->node_inx = node_inx;
+	conn->fd = -1;
+	if (_fwd_conn_pack(conn) != SLURM_SUCCESS)
+		conn->err = SLURM_COMMUNICATIONS_SEND_ERROR;
+	job->active++;
+
+	slurm_mutex_lock(&fwd_mutex);
+	list_append(fwd_start_list, conn);
+	slurm_mutex_unlock(&fwd_mutex);
+	if ((write(fwd_wake_fd[1], &c, 1) < 0) &&
+	    (errno != EAGAIN) && (errno != EWOULDBLOCK))
+		error("forward: write: %m");
+}
 
-		break;
+/*
+ * Return the number of nodes whose response is in ret_list. A reply merging
+ * the responses of a subtree (see SLURM_MSG_AGGR_RESP) counts for each of
+ * its nodes.
+ */
+static int _ret_node_cnt(List ret_list)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	int cnt = 0;
+
+	if (!ret_list)
+		return 0;
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if ((ret_data_info->type == RESPONSE_PING_SLURMD_LIST) &&
+		    ret_data_info->data)
+			cnt += ((ping_slurmd_resp_list_msg_t *)
+				ret_data_info->data)->node_cnt;
+		else
+			cnt++;
 	}
+	list_iterator_destroy(itr);
+	return cnt;
+}
 
-	_destroy_tree_fwd(fwd_tree);
+/*
+ * Merge the response of a finished connection into the job's ret_list.
+ * If the subtree's head failed, or did not account for all of the nodes it
+ * forwarded to, the tree is abandoned and every remaining node is sent
+ * the message individually. This way if all the nodes in the branch are
+ * down we don't have to time out for each node serially.
+ */
+static void _fwd_conn_finish(fwd_conn_t *conn)
+{
+	fwd_job_t *job = conn->job;
+	List ret_list = NULL;
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	int fwd_cnt = conn->hl ? hostlist_count(conn->hl) : 0;
+	int ret_cnt, err = conn->err;
+	char *name;
+	bool got_resp = false, free_job;
+	forward_node_cb_t callback = job->callback;
+	void *cb_arg = job->cb_arg;
+
+	if (conn->data) {
+		ret_list = slurm_unpack_received_msgs(
+			-1, create_buf(conn->data, conn->len));
+		conn->data = NULL;
+		if (ret_list)
+			got_resp = true;
+		else
+			err = errno;
+	} else if (!err) {
+		/* Message sent, no response expected */
+		ret_list = list_create(destroy_data_info);
+		ret_data_info = xmalloc(sizeof(ret_data_info_t));
+		ret_data_info->node_name = xstrdup(conn->name);
+		list_push(ret_list, ret_data_info);
+		while (fwd_cnt && (name = hostlist_shift(conn->hl))) {
+			ret_data_info = xmalloc(sizeof(ret_data_info_t));
+			ret_data_info->node_name = xstrdup(name);
+			list_push(ret_list, ret_data_info);
+			free(name);
+		}
+	}
+	if (!ret_list)
+		mark_as_failed_forward(&ret_list, conn->name,
+				       err ? err :
+				       SLURM_COMMUNICATIONS_CONNECTION_ERROR);
+
+	ret_cnt = _ret_node_cnt(ret_list);
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if (!ret_data_info->node_name)
+			ret_data_info->node_name = xstrdup(conn->name);
+		debug3("got response from %s", ret_data_info->node_name);
+		if (ret_cnt > fwd_cnt)
+			continue;
+		if (ret_data_info->type == RESPONSE_PING_SLURMD_LIST)
+			hostlist_delete(conn->hl, ((ping_slurmd_resp_list_msg_t *)
+					ret_data_info->data)->node_list);
+		else if (strcmp(ret_data_info->node_name, conn->name))
+			hostlist_delete_host(conn->hl,
+					     ret_data_info->node_name);
+	}
+	list_iterator_destroy(itr);
+	/* This is most common if a slurmd is running an older version of
+	 * Slurm than the originator of the message */
+	if (got_resp && (ret_cnt <= fwd_cnt)) {
+		error("forward: %s failed to forward the message, "
+		      "expecting %d ret got only %d",
+		      conn->name, fwd_cnt + 1, ret_cnt);
+	}
 
-	return NULL;
+	slurm_mutex_lock(job->mutex);
+	if (!callback)
+		list_transfer(job->ret_list, ret_list);
+	if (ret_cnt <= fwd_cnt) {
+		while ((name = hostlist_shift(conn->hl)))
+			_fwd_queue(job, name, NULL, -1);
+	}
+	job->active--;
+	free_job = job->free_job && (job->active == 0);
+	if (job->notify)
+		pthread_cond_broadcast(job->notify);
+	slurm_mutex_unlock(job->mutex);
+
+	/* job may be gone once unlocked unless free_job */
+	if (callback)
+		(callback)(conn->node_inx, ret_list, cb_arg);
+	else
+		list_destroy(ret_list);
+	if (free_job)
+		_fwd_job_destroy(job);
+	_fwd_conn_destroy(conn);
 }
 
-static void _start_msg_tree_internal(hostlist_t hl, hostlist_t* sp_hl,
-				     fwd_tree_t *fwd_tree_in,
-				     int hl_count)
+/* _fwd_worker - Forwarding engine thread processing responses */
+static void *_fwd_worker(void *args)
 {
-	int j;
-	fwd_tree_t *fwd_tree;
+	fwd_conn_t *conn;
 
-	xassert((hl || sp_hl) && !(hl && sp_hl));
-	xassert(fwd_tree_in);
-	xassert(fwd_tree_in->p_thr_count);
-	xassert(fwd_tree_in->tree_mutex);
-	xassert(fwd_tree_in->notify);
-	xassert(fwd_tree_in->ret_list);
+	while (1) {
+		slurm_mutex_lock(&fwd_mutex);
+		while (!(conn = list_dequeue(fwd_done_list)))
+			pthread_cond_wait(&fwd_done_cond, &fwd_mutex);
+		slurm_mutex_unlock(&fwd_mutex);
 
-	if (hl)
-		xassert(hl_count == hostlist_count(hl));
-
-	if (fwd_tree_in->timeout <= 0)
-		/* convert secs to msec */
-		fwd_tree_in->timeout  = slurm_get_msg_timeout() * 1000;
+		_fwd_conn_finish(conn);
+	}
 
-	for (j = 0; j < hl_count; j++) {
-		pthread_attr_t attr_agent;
-		pthread_t thread_agent;
-		int retries = 0;
-
-		slurm_attr_init(&attr_agent);
-		if (pthread_attr_setdetachstate
-		    (&attr_agent, PTHREAD_CREATE_DETACHED))
-			error("pthread_attr_setdetachstate error %m");
-
-		fwd_tree = xmalloc(sizeof(fwd_tree_t));
-		memcpy(fwd_tree, fwd_tree_in, sizeof(fwd_tree_t));
-
-		if (sp_hl) {
-			fwd_tree->tree_hl = sp_hl[j];
-			sp_hl[j] = NULL;
-		} else if (hl) {
-			char *name = hostlist_shift(hl);
-			fwd_tree->tree_hl = hostlist_create(name);
-			free(name);
-		}
+	return NULL;
+}
 
-		/*
-		 * Lock and increase thread counter, we need that to protect
-		 * the start_msg_tree waiting loop that was originally designed
-		 * around a "while ((count < host_count))" loop. In case where a
-		 * fwd thread was not able to get all the return codes from
-		 * children, the waiting loop was deadlocked.
-		 */
-		slurm_mutex_lock(fwd_tree->tree_mutex);
-		(*fwd_tree->p_thr_count)++;
-		slurm_mutex_unlock(fwd_tree->tree_mutex);
-
-		while (pthread_create(&thread_agent, &attr_agent,
-				      _fwd_tree_thread, (void *)fwd_tree)) {
+/* Start the forwarding engine's threads if not already running */
+static void _fwd_start(void)
+{
+	static bool atfork_set = false;
+	pthread_attr_t attr;
+	pthread_t thread_id;
+	int i, retries;
+
+	slurm_mutex_lock(&fwd_mutex);
+	if (fwd_started) {
+		slurm_mutex_unlock(&fwd_mutex);
+		return;
+	}
+	if (!atfork_set) {
+		pthread_atfork(NULL, NULL, _fwd_atfork_child);
+		atfork_set = true;
+	}
+	if (pipe(fwd_wake_fd) < 0)
+		fatal("forward: pipe: %m");
+	fd_set_nonblocking(fwd_wake_fd[0]);
+	fd_set_nonblocking(fwd_wake_fd[1]);
+	fd_set_close_on_exec(fwd_wake_fd[0]);
+	fd_set_close_on_exec(fwd_wake_fd[1]);
+	fwd_start_list = list_create(NULL);
+	fwd_done_list  = list_create(NULL);
+	fwd_conn_timeout = MIN(slurm_get_msg_timeout(), 10);
+
+	slurm_attr_init(&attr);
+	if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED))
+		error("pthread_attr_setdetachstate error %m");
+	for (i = 0; i <= FWD_WORKER_CNT; i++) {
+		retries = 0;
+		while (pthread_create(&thread_id, &attr,
+				      i ? _fwd_worker : _fwd_io, NULL)) {
 			error("pthread_create error %m");
 			if (++retries > MAX_RETRIES)
 				fatal("Can't create pthread");
 			usleep(100000);	/* sleep and try again */
 		}
-		slurm_attr_destroy(&attr_agent);
-
 	}
+	slurm_attr_destroy(&attr);
+	fwd_started = true;
+	slurm_mutex_unlock(&fwd_mutex);
 }
 
-static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
-				  forward_struct_t *fwd_struct,
-				  header_t *header, int timeout,
-				  int hl_count)
+/*
+ * Send a job's message to the head of each subtree in sp_hl, which
+ * forwards it to the rest of its subtree. The hostlists are consumed.
+ */
+static void _fwd_job_start(fwd_job_t *job, hostlist_t *sp_hl, int hl_count)
 {
+	char *name;
 	int j;
-	forward_msg_t *fwd_msg = NULL;
-	char *buf = NULL, *tmp_char = NULL;
-	pthread_attr_t attr_agent;
-	pthread_t thread_agent;
 
-	if (timeout <= 0)
+	if (job->timeout <= 0)
 		/* convert secs to msec */
-		timeout  = slurm_get_msg_timeout() * 1000;
+		job->timeout = slurm_get_msg_timeout() * 1000;
 
+	_fwd_start();
+	slurm_mutex_lock(job->mutex);
 	for (j = 0; j < hl_count; j++) {
-		int retries = 0;
-
-		slurm_attr_init(&attr_agent);
-		if (pthread_attr_setdetachstate
-		    (&attr_agent, PTHREAD_CREATE_DETACHED))
-			error("pthread_attr_setdetachstate error %m");
-
-		fwd_msg = xmalloc(sizeof(forward_msg_t));
-
-		fwd_msg->fwd_struct = fwd_struct;
-
-		fwd_msg->timeout = timeout;
-
-		memcpy(&fwd_msg->header.orig_addr,
-		       &header->orig_addr,
-		       sizeof(slurm_addr_t));
-
-		fwd_msg->header.version = header->version;
-		fwd_msg->header.flags = header->flags;
-		fwd_msg->header.msg_type = header->msg_type;
-		fwd_msg->header.body_length = header->body_length;
-		fwd_msg->header.ret_list = NULL;
-		fwd_msg->header.ret_cnt = 0;
-
-		if (sp_hl) {
-			buf = hostlist_ranged_string_xmalloc(sp_hl[j]);
+		if (!(name = hostlist_shift(sp_hl[j]))) {
 			hostlist_destroy(sp_hl[j]);
-		} else {
-			tmp_char = hostlist_shift(hl);
-			buf = xstrdup(tmp_char);
-			free(tmp_char);
-		}
-
-		forward_init(&fwd_msg->header.forward, NULL);
-		fwd_msg->header.forward.nodelist = buf;
-		while (pthread_create(&thread_agent, &attr_agent,
-				     _forward_thread,
-				     (void *)fwd_msg)) {
-			error("pthread_create error %m");
-			if (++retries > MAX_RETRIES)
-				fatal("Can't create pthread");
-			usleep(100000);	/* sleep and try again */
+			continue;
 		}
-		slurm_attr_destroy(&attr_agent);
+		_fwd_queue(job, name, sp_hl[j], -1);
 	}
+	slurm_mutex_unlock(job->mutex);
 }
 
 /*
@@ -643,6 +810,7 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
 	hostlist_t hl = NULL;
 	hostlist_t* sp_hl;
 	int hl_count = 0;
+	fwd_job_t *job;
 
 	if (!forward_struct->ret_list) {
 		error("didn't get a ret_list from forward_struct");
@@ -656,12 +824,25 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
 		hostlist_destroy(hl);
 		return SLURM_ERROR;
 	}
+	hostlist_destroy(hl);
 
-	_forward_msg_internal(NULL, sp_hl, forward_struct, header,
-			      forward_struct->timeout, hl_count);
+	/* forward_wait() tracks completion by counting the responses in
+	 * ret_list, so the engine frees the job once it is done with it */
+	job = xmalloc(sizeof(fwd_job_t));
+	memcpy(&job->header, header, sizeof(header_t));
+	forward_init(&job->header.forward, NULL);
+	job->buf = xmalloc(forward_struct->buf_len);
+	memcpy(job->buf, forward_struct->buf, forward_struct->buf_len);
+	job->buf_len = forward_struct->buf_len;
+	job->timeout = forward_struct->timeout;
+	job->ret_list = forward_struct->ret_list;
+	job->mutex = &forward_struct->forward_mutex;
+	job->notify = &forward_struct->notify;
+	job->free_job = true;
+
+	_fwd_job_start(job, sp_hl, hl_count);
 
 	xfree(sp_hl);
-	hostlist_destroy(hl);
 	return SLURM_SUCCESS;
 }
 
@@ -679,15 +860,18 @@ extern int forward_msg(forward_struct_t *forward_struct, header_t *header)
  */
 extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 {
-	fwd_tree_t fwd_tree;
+	fwd_job_t job;
 	pthread_mutex_t tree_mutex;
 	pthread_cond_t notify;
 	int count = 0;
 	List ret_list = NULL;
-	int thr_count = 0;
 	int host_count = 0;
 	hostlist_t* sp_hl;
-	int hl_count = 0;
+	int hl_count = 0, j;
+	slurm_msg_t send_msg;
+	Buf buffer;
+	uint32_t end = 0;
+	char *name;
 
 	xassert(hl);
 	xassert(msg);
@@ -699,42 +883,120 @@ extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout)
 		error("unable to split forward hostlist");
 		return NULL;
 	}
-	slurm_mutex_init(&tree_mutex);
-	pthread_cond_init(&notify, NULL);
-
 	ret_list = list_create(destroy_data_info);
 
-	memset(&fwd_tree, 0, sizeof(fwd_tree));
-	fwd_tree.orig_msg = msg;
-	fwd_tree.ret_list = ret_list;
-	fwd_tree.timeout = timeout;
-	fwd_tree.notify = &notify;
-	fwd_tree.p_thr_count = &thr_count;
-	fwd_tree.tree_mutex = &tree_mutex;
+	/* Pack the message once, every subtree is sent the same bytes
+	 * following a header naming the nodes it is to forward to */
+	slurm_msg_t_init(&send_msg);
+	send_msg.msg_type = msg->msg_type;
+	send_msg.flags = msg->flags & SLURM_MSG_AGGR_RESP;
+	send_msg.data = msg->data;
+	send_msg.protocol_version = msg->protocol_version;
+	memset(&job, 0, sizeof(fwd_job_t));
+	if ((buffer = slurm_pack_node_msg(&send_msg))) {
+		/* Reread the header, leaving what follows it */
+		end = get_buf_offset(buffer);
+		set_buf_offset(buffer, 0);
+	}
+	if (!buffer || (unpack_header(&job.header, buffer) != SLURM_SUCCESS)) {
+		error("start_msg_tree: unable to pack %s",
+		      rpc_num2string(msg->msg_type));
+		while ((name = hostlist_shift(hl))) {
+			mark_as_failed_forward(&ret_list, name,
+					       SLURM_COMMUNICATIONS_SEND_ERROR);
+			free(name);
+		}
+		for (j = 0; j < hl_count; j++)
+			hostlist_destroy(sp_hl[j]);
+		xfree(sp_hl);
+		if (buffer)
+			free_buf(buffer);
+		return ret_list;
+	}
+	job.buf_len = end - get_buf_offset(buffer);
+	job.buf = xmalloc(job.buf_len);
+	memcpy(job.buf, &buffer->head[buffer->processed], job.buf_len);
+	free_buf(buffer);
+
+	slurm_mutex_init(&tree_mutex);
+	pthread_cond_init(&notify, NULL);
+	job.timeout = timeout;
+	job.conn_retry = true;
+	job.ret_list = ret_list;
+	job.mutex = &tree_mutex;
+	job.notify = &notify;
 
-	_start_msg_tree_internal(NULL, sp_hl, &fwd_tree, hl_count);
+	_fwd_job_start(&job, sp_hl, hl_count);
 
 	xfree(sp_hl);
 
 	slurm_mutex_lock(&tree_mutex);
 
-	count = list_count(ret_list);
+	count = _ret_node_cnt(ret_list);
 	debug2("Tree head got back %d looking for %d", count, host_count);
-	while (thr_count > 0) {
+	while (job.active > 0) {
 		pthread_cond_wait(&notify, &tree_mutex);
-		count = list_count(ret_list);
+		count = _ret_node_cnt(ret_list);
 		debug2("Tree head got back %d", count);
 	}
 	xassert(count >= host_count);	/* Tree head did not get all responses,
-					 * but no more active fwd threads!*/
+					 * but no more active connections! */
 	slurm_mutex_unlock(&tree_mutex);
 
 	slurm_mutex_destroy(&tree_mutex);
 	pthread_cond_destroy(&notify);
+	destroy_forward(&job.header.forward);
+	xfree(job.buf);
 
 	return ret_list;
 }
 
+/*
+ * forward_msg_nodes - send a message directly to each node, without having
+ *	any of them forward it, and return without waiting for the responses
+ * IN: node_names  - char **        - nodes to send the message to
+ * IN: node_cnt    - int            - number of node_names
+ * IN: msg         - slurm_msg_t *  - message to send, packed with a new
+ *                                    credential as each node's connection
+ *                                    opens, so it must remain valid until
+ *                                    callback has been called for every node
+ * IN: timeout     - int            - msec to wait for each response, zero
+ *                                    for MessageTimeout
+ * IN: callback    - forward_node_cb_t - called from an engine thread with
+ *                                    the index in node_names and the
+ *                                    ret_list of each node as it completes,
+ *                                    the ret_list is the callback's to free
+ * IN: arg         - void *         - passed to callback
+ */
+extern void forward_msg_nodes(char **node_names, int node_cnt,
+			      slurm_msg_t *msg, int timeout,
+			      forward_node_cb_t callback, void *arg)
+{
+	fwd_job_t *job;
+	int i;
+
+	if (node_cnt <= 0)
+		return;
+
+	job = xmalloc(sizeof(fwd_job_t));
+	forward_init(&job->header.forward, NULL);
+	job->header.msg_type = msg->msg_type;
+	job->msg = msg;
+	job->callback = callback;
+	job->cb_arg = arg;
+	job->timeout = (timeout > 0) ? timeout :
+		       (slurm_get_msg_timeout() * 1000);
+	slurm_mutex_init(&job->job_mutex);
+	job->mutex = &job->job_mutex;
+	job->free_job = true;
+
+	_fwd_start();
+	slurm_mutex_lock(job->mutex);
+	for (i = 0; i < node_cnt; i++)
+		_fwd_queue(job, strdup(node_names[i]), NULL, i);
+	slurm_mutex_unlock(job->mutex);
+}
+
 /*
  * mark_as_failed_forward- mark a node as failed and add it to "ret_list"
  *
@@ -768,18 +1030,14 @@ extern void forward_wait(slurm_msg_t * msg)
 	if (msg->forward_struct) {
 		debug2("looking for %d", msg->forward_struct->fwd_cnt);
 		slurm_mutex_lock(&msg->forward_struct->forward_mutex);
-		count = 0;
-		if (msg->ret_list != NULL)
-			count = list_count(msg->ret_list);
+		count = _ret_node_cnt(msg->ret_list);
 
 		debug2("Got back %d", count);
 		while ((count < msg->forward_struct->fwd_cnt)) {
 			pthread_cond_wait(&msg->forward_struct->notify,
 					  &msg->forward_struct->forward_mutex);
 
-			if (msg->ret_list != NULL) {
-				count = list_count(msg->ret_list);
-			}
+			count = _ret_node_cnt(msg->ret_list);
 			debug2("Got back %d", count);
 		}
 		debug2("Got them all");
@@ -103,6 +103,30 @@ extern int forward_msg(forward_struct_t *forward_struct,
  */
 extern List start_msg_tree(hostlist_t hl, slurm_msg_t *msg, int timeout);
 
+/* Called with the responses of each node of forward_msg_nodes() */
+typedef void (*forward_node_cb_t) (int node_inx, List ret_list, void *arg);
+
+/*
+ * forward_msg_nodes - send a message directly to each node, without having
+ *	any of them forward it, and return without waiting for the responses
+ * IN: node_names  - char **        - nodes to send the message to
+ * IN: node_cnt    - int            - number of node_names
+ * IN: msg         - slurm_msg_t *  - message to send, packed with a new
+ *                                    credential as each node's connection
+ *                                    opens, so it must remain valid until
+ *                                    callback has been called for every node
+ * IN: timeout     - int            - msec to wait for each response, zero
+ *                                    for MessageTimeout
+ * IN: callback    - forward_node_cb_t - called from an engine thread with
+ *                                    the index in node_names and the
+ *                                    ret_list of each node as it completes,
+ *                                    the ret_list is the callback's to free
+ * IN: arg         - void *         - passed to callback
+ */
+extern void forward_msg_nodes(char **node_names, int node_cnt,
+			      slurm_msg_t *msg, int timeout,
+			      forward_node_cb_t callback, void *arg);
+
 /*
  * mark_as_failed_forward- mark a node as failed and add it to "ret_list"
  *
@@ -1139,25 +1139,16 @@ extern int gres_plugin_node_config_pack(Buf buffer)
 	return rc;
 }
 
-/*
- * Unpack this node's configuration from a buffer (built/packed by slurmd)
- * IN/OUT buffer - message buffer to unpack
- * IN node_name - name of node whose data is being unpacked
- */
-extern int gres_plugin_node_config_unpack(Buf buffer, char* node_name)
+/* Unpack a node's configuration records from buffer onto conf_list */
+static int _node_config_unpack(Buf buffer, char *node_name, List conf_list)
 {
-	int i, j, rc;
+	int i, j;
 	uint32_t count, cpu_cnt, magic, plugin_id, utmp32;
 	uint16_t rec_cnt, version;
 	uint8_t has_file;
 	char *tmp_cpus, *tmp_name, *tmp_type;
 	gres_slurmd_conf_t *p;
 
-	rc = gres_plugin_init();
-
-	FREE_NULL_LIST(gres_conf_list);
-	gres_conf_list = list_create(_destroy_gres_slurmd_conf);
-
 	safe_unpack16(&version, buffer);
 
 	safe_unpack16(&rec_cnt, buffer);
@@ -1236,7 +1227,7 @@ extern int gres_plugin_node_config_unpack(Buf buffer, char* node_name)
 			p->type = tmp_type;
 			tmp_type = NULL;	/* Nothing left to xfree */
 			p->plugin_id = plugin_id;
-			list_append(gres_conf_list, p);
+			list_append(conf_list, p);
 		}
 	} else {
 		for (i = 0; i < rec_cnt; i++) {
@@ -1306,11 +1297,11 @@ extern int gres_plugin_node_config_unpack(Buf buffer, char* node_name)
 			tmp_cpus = NULL;	/* Nothing left to xfree */
 			p->name = tmp_name;     /* Preserve for accounting! */
 			p->plugin_id = plugin_id;
-			list_append(gres_conf_list, p);
+			list_append(conf_list, p);
 		}
 	}
 	slurm_mutex_unlock(&gres_context_lock);
-	return rc;
+	return SLURM_SUCCESS;
 
 unpack_error:
 	error("gres_plugin_node_config_unpack: unpack error from node %s",
@@ -1321,6 +1312,62 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/*
+ * Unpack this node's configuration from a buffer (built/packed by slurmd)
+ * IN/OUT buffer - message buffer to unpack
+ * IN node_name - name of node whose data is being unpacked
+ */
+extern int gres_plugin_node_config_unpack(Buf buffer, char* node_name)
+{
+	int rc;
+
+	rc = gres_plugin_init();
+
+	FREE_NULL_LIST(gres_conf_list);
+	gres_conf_list = list_create(_destroy_gres_slurmd_conf);
+	if (_node_config_unpack(buffer, node_name, gres_conf_list) !=
+	    SLURM_SUCCESS)
+		return SLURM_ERROR;
+	return rc;
+}
+
+/*
+ * Unpack this node's configuration from a buffer (built/packed by slurmd)
+ *	onto a new list rather than the configuration to be validated next,
+ *	so several nodes' data may be unpacked concurrently
+ * IN/OUT buffer - message buffer to unpack
+ * IN node_name - name of node whose data is being unpacked
+ * OUT conf_list - unpacked configuration, pass to
+ *	gres_plugin_node_config_load_list(), set to NULL on error
+ */
+extern int gres_plugin_node_config_unpack_list(Buf buffer, char *node_name,
+					       List *conf_list)
+{
+	int rc;
+
+	rc = gres_plugin_init();
+
+	*conf_list = list_create(_destroy_gres_slurmd_conf);
+	if (_node_config_unpack(buffer, node_name, *conf_list) !=
+	    SLURM_SUCCESS) {
+		FREE_NULL_LIST(*conf_list);
+		return SLURM_ERROR;
+	}
+	return rc;
+}
+
+/*
+ * Make a configuration from gres_plugin_node_config_unpack_list() the one
+ *	validated by the next gres_plugin_node_config_validate(), as if
+ *	gres_plugin_node_config_unpack() had just unpacked it
+ * IN conf_list - unpacked configuration, consumed
+ */
+extern void gres_plugin_node_config_load_list(List conf_list)
+{
+	FREE_NULL_LIST(gres_conf_list);
+	gres_conf_list = conf_list;
+}
+
 /*
  * Delete an element placed on gres_list by _node_config_validate()
  * free associated memory
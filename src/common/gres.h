@@ -261,6 +261,26 @@ extern int gres_plugin_init_node_config(char *node_name, char *orig_config,
  */
 extern int gres_plugin_node_config_unpack(Buf buffer, char *node_name);
 
+/*
+ * Unpack this node's configuration from a buffer (built/packed by slurmd)
+ *	onto a new list rather than the configuration to be validated next,
+ *	so several nodes' data may be unpacked concurrently
+ * IN/OUT buffer - message buffer to unpack
+ * IN node_name - name of node whose data is being unpacked
+ * OUT conf_list - unpacked configuration, pass to
+ *	gres_plugin_node_config_load_list(), set to NULL on error
+ */
+extern int gres_plugin_node_config_unpack_list(Buf buffer, char *node_name,
+					       List *conf_list);
+
+/*
+ * Make a configuration from gres_plugin_node_config_unpack_list() the one
+ *	validated by the next gres_plugin_node_config_validate(), as if
+ *	gres_plugin_node_config_unpack() had just unpacked it
+ * IN conf_list - unpacked configuration, consumed
+ */
+extern void gres_plugin_node_config_load_list(List conf_list);
+
 /*
  * Validate a node's configuration and put a gres record onto a list
  *	(expected to be an element of slurmctld's node record).
@@ -399,7 +399,6 @@ static hostlist_iterator_t hostlist_iterator_new(void);
 static void               _iterator_advance(hostlist_iterator_t);
 static void               _iterator_advance_range(hostlist_iterator_t);
 
-static int hostset_find_host(hostset_t, const char *);
 
 /* ------[ macros ]------ */
 
@@ -1378,12 +1377,15 @@ static int hostlist_resize(hostlist_t hl, size_t newsize)
 	return 1;
 }
 
-/* Resize hostlist by one HOSTLIST_CHUNK
+/* Resize hostlist by at least one HOSTLIST_CHUNK, doubling the size of
+ * large lists so that building a list of N ranges stays O(N)
  * Assumes that hostlist hl is locked by caller
  */
 static int hostlist_expand(hostlist_t hl)
 {
-	if (!hostlist_resize(hl, hl->size + HOSTLIST_CHUNK))
+	size_t grow = MAX(hl->size, HOSTLIST_CHUNK);
+
+	if (!hostlist_resize(hl, hl->size + grow))
 		return 0;
 	else
 		return 1;
@@ -1449,8 +1451,6 @@ hostlist_push_hr(hostlist_t hl, char *prefix, unsigned long lo,
  */
 static int hostlist_insert_range(hostlist_t hl, hostrange_t hr, int n)
 {
-	int i;
-	hostrange_t tmp;
 	hostlist_iterator_t hli;
 
 	assert(hl != NULL);
@@ -1463,16 +1463,11 @@ static int hostlist_insert_range(hostlist_t hl, hostrange_t hr, int n)
 	if (hl->size == hl->nranges && !hostlist_expand(hl))
 		return 0;
 
-	/* copy new hostrange into slot "n" in array */
-	tmp = hl->hr[n];
+	/* push remaining hostrange entries up and copy new hostrange
+	 * into slot "n" in array */
+	memmove(&hl->hr[n + 1], &hl->hr[n],
+		(hl->nranges - n) * sizeof(hostrange_t));
 	hl->hr[n] = hostrange_copy(hr);
-
-	/* push remaining hostrange entries up */
-	for (i = n + 1; i < hl->nranges + 1; i++) {
-		hostrange_t last = hl->hr[i];
-		hl->hr[i] = tmp;
-		tmp = last;
-	}
 	hl->nranges++;
 
 	/* adjust hostlist iterators if needed */
@@ -1489,7 +1484,6 @@ static int hostlist_insert_range(hostlist_t hl, hostrange_t hr, int n)
  */
 static void hostlist_delete_range(hostlist_t hl, int n)
 {
-	int i;
 	hostrange_t old;
 
 	assert(hl != NULL);
@@ -1497,8 +1491,8 @@ static void hostlist_delete_range(hostlist_t hl, int n)
 	assert(n < hl->nranges && n >= 0);
 
 	old = hl->hr[n];
-	for (i = n; i < hl->nranges - 1; i++)
-		hl->hr[i] = hl->hr[i + 1];
+	memmove(&hl->hr[n], &hl->hr[n + 1],
+		(hl->nranges - n - 1) * sizeof(hostrange_t));
 	hl->nranges--;
 	hl->hr[hl->nranges] = NULL;
 	hostlist_shift_iterators(hl, n, 0, 1);
@@ -2074,6 +2068,46 @@ int hostlist_push(hostlist_t hl, const char *hosts)
 	return retval;
 }
 
+/* Append host str to the last range of hl if it directly follows it,
+ * without allocating a hostname or hostrange object. This is the common
+ * case when building a hostlist from a node bitmap.
+ * Returns 1 if the host was appended, 0 otherwise */
+static int _push_host_to_tail(hostlist_t hl, const char *str, int dims)
+{
+	hostrange_t tail;
+	unsigned long num;
+	char *p;
+	int idx, len, width, base = hostlist_get_base(dims);
+	int rc = 0;
+
+	len = strlen(str);
+	idx = host_prefix_end(str, dims) + 1;
+	width = len - idx;
+	if (width == 0)
+		return 0;
+	if ((dims > 1) && (width != dims))
+		base = 10;
+	num = strtoul(str + idx, &p, base);
+	if (*p != '\0')
+		return 0;
+
+	LOCK_HOSTLIST(hl);
+	if (hl->nranges > 0) {
+		tail = hl->hr[hl->nranges - 1];
+		if (!tail->singlehost && (tail->hi + 1 == num) &&
+		    !strncmp(tail->prefix, str, idx) &&
+		    (tail->prefix[idx] == '\0') &&
+		    _width_equiv(tail->lo, &tail->width, num, &width)) {
+			tail->hi = num;
+			hl->nhosts++;
+			rc = 1;
+		}
+	}
+	UNLOCK_HOSTLIST(hl);
+
+	return rc;
+}
+
 int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims)
 {
 	hostrange_t hr;
@@ -2085,6 +2119,9 @@ int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims)
 	if (!dims)
 		dims = slurmdb_setup_cluster_name_dims();
 
+	if (_push_host_to_tail(hl, str, dims))
+		return 1;
+
 	hn = hostname_create_dims(str, dims);
 
 	if (hostname_suffix_is_valid(hn))
@@ -3430,10 +3467,8 @@ static void _iterator_advance_range(hostlist_iterator_t i)
 	}
 }
 
-char *hostlist_next_dims(hostlist_iterator_t i, int dims)
+int hostlist_next_buf(hostlist_iterator_t i, int dims, char *buf, int size)
 {
-	char buf[MAXHOSTNAMELEN + 16];
-	const int size = sizeof(buf);
 	int len = 0;
 
 	assert(i != NULL);
@@ -3462,17 +3497,27 @@ char *hostlist_next_dims(hostlist_iterator_t i, int dims)
 				buf[len++] = alpha_num[coord[i2++]];
 			buf[len] = '\0';
 		} else {
-			len = snprintf(buf + len, size - len, "%0*lu",
-				       i->hr->width, i->hr->lo + i->depth);
-			if (len < 0 || len >= size)
+			int n = snprintf(buf + len, size - len, "%0*lu",
+					 i->hr->width, i->hr->lo + i->depth);
+			if (n < 0 || len + n >= size)
 				goto no_next;
+			len += n;
 		}
 	}
 	UNLOCK_HOSTLIST(i->hl);
-	return strdup(buf);
+	return len;
 no_next:
 	UNLOCK_HOSTLIST(i->hl);
-	return NULL;
+	return 0;
+}
+
+char *hostlist_next_dims(hostlist_iterator_t i, int dims)
+{
+	char buf[MAXHOSTNAMELEN + 16];
+
+	if (hostlist_next_buf(i, dims, buf, sizeof(buf)) <= 0)
+		return NULL;
+	return strdup(buf);
 }
 
 char *hostlist_next(hostlist_iterator_t i)
@@ -3583,55 +3628,113 @@ void hostset_destroy(hostset_t set)
 	free(set);
 }
 
+/* Return the index of the first range of the sorted hostset hl that does
+ * not sort before hr, or hl->nranges if there is none.
+ * Assumes that the hostlist hl has been locked by caller
+ */
+static int _hostset_lower_bound(hostlist_t hl, hostrange_t hr)
+{
+	int lo = 0, hi = hl->nranges, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (hostrange_cmp(hr, hl->hr[mid]) > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* return 1 if the single host held in hostrange key is within hostrange hr
+ */
+static int _hostrange_host_within(hostrange_t hr, hostrange_t key)
+{
+	if (hr->singlehost || key->singlehost) {
+		return (hr->singlehost && key->singlehost &&
+			!strcmp(hr->prefix, key->prefix));
+	}
+	if ((key->lo < hr->lo) || (key->lo > hr->hi) ||
+	    strcmp(hr->prefix, key->prefix))
+		return 0;
+	return _width_equiv(hr->lo, &hr->width, key->lo, &key->width);
+}
+
+/* Return the index of the range of hostset hl holding the single host in
+ * hostrange key, or -1 if the host is not in the set. O(log N) in the
+ * number of ranges.
+ * Assumes that the hostlist hl has been locked by caller
+ */
+static int _hostset_find_key(hostlist_t hl, hostrange_t key)
+{
+	struct hostrange_components shifted;
+	char prefix[MAXHOSTNAMELEN + 16];
+	int i, ldiff, plen;
+
+	i = _hostset_lower_bound(hl, key);
+	if ((i < hl->nranges) && _hostrange_host_within(hl->hr[i], key))
+		return i;
+	if ((i > 0) && _hostrange_host_within(hl->hr[i - 1], key))
+		return i - 1;
+
+	/* Ranges such as nid0000[2-7] keep leading digits of the suffix in
+	 * their prefix (see hostrange_hn_within), look for those too */
+	if (key->singlehost || (key->width < 2) ||
+	    (slurmdb_setup_cluster_name_dims() != 1))
+		return -1;
+	plen = snprintf(prefix, sizeof(prefix), "%s%0*lu",
+			key->prefix, key->width, key->lo);
+	if ((plen < 0) || (plen >= sizeof(prefix)))
+		return -1;
+	shifted.prefix = prefix;
+	shifted.singlehost = 0;
+	for (ldiff = 1; ldiff < key->width; ldiff++) {
+		plen = strlen(key->prefix) + ldiff;
+		shifted.lo = shifted.hi = strtoul(prefix + plen, NULL, 10);
+		shifted.width = key->width - ldiff;
+		prefix[plen] = '\0';
+		i = _hostset_lower_bound(hl, &shifted);
+		if ((i < hl->nranges) &&
+		    _hostrange_host_within(hl->hr[i], &shifted))
+			return i;
+		if ((i > 0) && _hostrange_host_within(hl->hr[i - 1], &shifted))
+			return i - 1;
+		snprintf(prefix, sizeof(prefix), "%s%0*lu",
+			 key->prefix, key->width, key->lo);
+	}
+	return -1;
+}
+
 /* inserts a single range object into a hostset
  * Assumes that the set->hl lock is already held
  * Updates hl->nhosts
  */
 static int hostset_insert_range(hostset_t set, hostrange_t hr)
 {
-	int i = 0;
-	int inserted = 0;
-	int nhosts = 0;
-	int ndups = 0;
+	int i, ndup, nhosts, ndups = 0;
 	hostlist_t hl;
 
 	hl = set->hl;
 
-	if (hl->size == hl->nranges && !hostlist_expand(hl))
-		return 0;
-
 	nhosts = hostrange_count(hr);
 
-	for (i = 0; i < hl->nranges; i++) {
-		if (hostrange_cmp(hr, hl->hr[i]) <= 0) {
-
-			if ((ndups = hostrange_join(hr, hl->hr[i])) >= 0)
-				hostlist_delete_range(hl, i);
-			else if (ndups < 0)
-				ndups = 0;
-
-			hostlist_insert_range(hl, hr, i);
+	/* binary search for the insert position, then join the new range
+	 * with its predecessor and with as many successors as it reaches */
+	i = _hostset_lower_bound(hl, hr);
+	if (!hostlist_insert_range(hl, hr, i))
+		return 0;
 
-			/* now attempt to join hr[i] and hr[i-1] */
-			if (i > 0) {
-				int m;
-				if ((m = _attempt_range_join(hl, i)) > 0)
-					ndups += m;
-			}
-			hl->nhosts += nhosts - ndups;
-			inserted = 1;
-			break;
-		}
+	if ((i > 0) && ((ndup = hostrange_join(hl->hr[i - 1], hl->hr[i])) >= 0)) {
+		hostlist_delete_range(hl, i);
+		ndups += ndup;
+		i--;
 	}
-
-	if (inserted == 0) {
-		hl->hr[hl->nranges++] = hostrange_copy(hr);
-		hl->nhosts += nhosts;
-		if (hl->nranges > 1) {
-			if ((ndups = _attempt_range_join(hl, hl->nranges - 1)) <= 0)
-				ndups = 0;
-		}
+	while ((i + 1 < hl->nranges) &&
+	       ((ndup = hostrange_join(hl->hr[i], hl->hr[i + 1])) >= 0)) {
+		hostlist_delete_range(hl, i + 1);
+		ndups += ndup;
 	}
+	hl->nhosts += nhosts - ndups;
 
 	/*
 	 *  Return the number of unique hosts inserted
@@ -3655,44 +3758,59 @@ int hostset_insert(hostset_t set, const char *hosts)
 	return n;
 }
 
-
-/* linear search through N ranges for hostname "host"
- * */
-static int hostset_find_host(hostset_t set, const char *host)
+/* Count the hosts of range hr found in hostset set. Stop at the first
+ * host found if stop_found is set, or at the first one missing if
+ * stop_missing is set.
+ * Each lookup is a binary search, and all hosts of hr held by the same
+ * range of the set are counted at once.
+ */
+static int _hostset_count_range(hostset_t set, hostrange_t hr,
+				bool stop_found, bool stop_missing)
 {
-	int i;
-	int retval = 0;
-	hostname_t hn;
+	struct hostrange_components key;
+	hostrange_t found;
+	unsigned long num = hr->lo;
+	int i, nfound = 0;
+
+	key.prefix = hr->prefix;
+	key.singlehost = hr->singlehost;
 	LOCK_HOSTLIST(set->hl);
-	hn = hostname_create(host);
-	for (i = 0; i < set->hl->nranges; i++) {
-		if (hostrange_hn_within(set->hl->hr[i], hn)) {
-			retval = 1;
-			goto done;
+	do {
+		key.lo = key.hi = num;
+		key.width = hr->width;
+		if ((i = _hostset_find_key(set->hl, &key)) < 0) {
+			if (stop_missing)
+				break;
+			num++;
+			continue;
 		}
-	}
-done:
+		found = set->hl->hr[i];
+		if (hr->singlehost || strcmp(found->prefix, hr->prefix)) {
+			nfound++;
+			num++;
+		} else {
+			nfound += MIN(found->hi, hr->hi) - num + 1;
+			num = found->hi + 1;
+		}
+		if (stop_found)
+			break;
+	} while ((num <= hr->hi) && (num != 0));
 	UNLOCK_HOSTLIST(set->hl);
-	hostname_destroy(hn);
-	return retval;
+
+	return nfound;
 }
 
 int hostset_intersects(hostset_t set, const char *hosts)
 {
-	int retval = 0;
+	int i, retval = 0;
 	hostlist_t hl;
-	char *hostname;
 
 	assert(set->hl->magic == HOSTLIST_MAGIC);
 
-	hl = hostlist_create(hosts);
-	while ((hostname = hostlist_pop(hl)) != NULL) {
-		retval += hostset_find_host(set, hostname);
-		free(hostname);
-		if (retval)
-			break;
-	}
-
+	if (!(hl = hostlist_create(hosts)))
+		return 0;
+	for (i = 0; (i < hl->nranges) && !retval; i++)
+		retval = _hostset_count_range(set, hl->hr[i], true, false);
 	hostlist_destroy(hl);
 
 	return retval;
@@ -3700,9 +3818,8 @@ int hostset_intersects(hostset_t set, const char *hosts)
 
 int hostset_within(hostset_t set, const char *hosts)
 {
-	int nhosts, nfound;
+	int i, n, nhosts, nfound;
 	hostlist_t hl;
-	char *hostname;
 
 	assert(set->hl->magic == HOSTLIST_MAGIC);
 
@@ -3711,9 +3828,11 @@ int hostset_within(hostset_t set, const char *hosts)
 	nhosts = hostlist_count(hl);
 	nfound = 0;
 
-	while ((hostname = hostlist_pop(hl)) != NULL) {
-		nfound += hostset_find_host(set, hostname);
-		free(hostname);
+	for (i = 0; i < hl->nranges; i++) {
+		n = hostrange_count(hl->hr[i]);
+		if (_hostset_count_range(set, hl->hr[i], false, true) < n)
+			break;
+		nfound += n;
 	}
 
 	hostlist_destroy(hl);
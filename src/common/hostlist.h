@@ -446,6 +446,16 @@ void hostlist_iterator_reset(hostlist_iterator_t i);
 char * hostlist_next_dims(hostlist_iterator_t i, int dims);
 char * hostlist_next(hostlist_iterator_t i);
 
+/* hostlist_next_buf():
+ *
+ * Same as hostlist_next_dims(), but copies the next hostname into buf,
+ * which holds size bytes, rather than allocating memory for it.
+ *
+ * Returns the length of the hostname or 0 at the end of the list or if
+ * the hostname does not fit into buf.
+ */
+int hostlist_next_buf(hostlist_iterator_t i, int dims, char *buf, int size);
+
 
 /* hostlist_next_range():
  *
@@ -219,6 +219,46 @@
          }                                                                    \
      } _STMT_END
 
+#  define slurm_rwlock_destroy(rwlock)                                        \
+     _STMT_START {                                                            \
+         int err = pthread_rwlock_destroy(rwlock);                            \
+         if (err) {                                                           \
+             errno = err;                                                     \
+             error("%s:%d %s: pthread_rwlock_destroy(): %m",                  \
+                   __FILE__, __LINE__, __CURRENT_FUNC__);                     \
+         }                                                                    \
+     } _STMT_END
+
+#  define slurm_rwlock_rdlock(rwlock)                                         \
+     _STMT_START {                                                            \
+         int err = pthread_rwlock_rdlock(rwlock);                             \
+         if (err) {                                                           \
+             errno = err;                                                     \
+             error("%s:%d %s: pthread_rwlock_rdlock(): %m",                   \
+                   __FILE__, __LINE__, __CURRENT_FUNC__);                     \
+         }                                                                    \
+     } _STMT_END
+
+#  define slurm_rwlock_wrlock(rwlock)                                         \
+     _STMT_START {                                                            \
+         int err = pthread_rwlock_wrlock(rwlock);                             \
+         if (err) {                                                           \
+             errno = err;                                                     \
+             error("%s:%d %s: pthread_rwlock_wrlock(): %m",                   \
+                   __FILE__, __LINE__, __CURRENT_FUNC__);                     \
+         }                                                                    \
+     } _STMT_END
+
+#  define slurm_rwlock_unlock(rwlock)                                         \
+     _STMT_START {                                                            \
+         int err = pthread_rwlock_unlock(rwlock);                             \
+         if (err) {                                                           \
+             errno = err;                                                     \
+             error("%s:%d %s: pthread_rwlock_unlock(): %m",                   \
+                   __FILE__, __LINE__, __CURRENT_FUNC__);                     \
+         }                                                                    \
+     } _STMT_END
+
 #  ifdef PTHREAD_SCOPE_SYSTEM
 #  define slurm_attr_init(attr)                                               \
      _STMT_START {                                                            \
@@ -252,6 +292,10 @@
 #  define slurm_mutex_destroy(mutex)
 #  define slurm_mutex_lock(mutex)
 #  define slurm_mutex_unlock(mutex)
+#  define slurm_rwlock_destroy(rwlock)
+#  define slurm_rwlock_rdlock(rwlock)
+#  define slurm_rwlock_wrlock(rwlock)
+#  define slurm_rwlock_unlock(rwlock)
 #  define slurm_attr_init(attr)
 #  define slurm_attr_destroy(attr)
 
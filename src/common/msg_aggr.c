@@ -59,9 +59,13 @@
 #  include <pthread.h>
 #endif /* WITH_PTHREADS */
 
+/* Smallest collection window in msec, see _adapt_window() */
+#define MSG_AGGR_WINDOW_MIN 1
+
 typedef struct {
 	pthread_mutex_t	aggr_mutex;
 	pthread_cond_t	cond;
+	uint64_t        cur_window;
 	uint32_t        debug_flags;
 	bool		max_msgs;
 	uint64_t        max_msg_cnt;
@@ -189,12 +193,39 @@ static int _send_to_next_collector(slurm_msg_t *msg)
 	return rc;
 }
 
+/*
+ *  Adapt the collection window to the size of the batch just sent.
+ *  A window which collected more than the message that opened it shows
+ *  messages are arriving faster than they can be sent individually, so
+ *  the next window is doubled, up to the configured WindowTime. A window
+ *  which only delayed its single message is halved, down to
+ *  MSG_AGGR_WINDOW_MIN, so an idle node sends almost immediately.
+ *  Caller must hold msg_collection.mutex.
+ */
+static void _adapt_window(int count)
+{
+	uint64_t window = msg_collection.cur_window;
+
+	if (count > 1)
+		window = MIN(window * 2, msg_collection.window);
+	else
+		window /= 2;
+	window = MAX(window, MIN(MSG_AGGR_WINDOW_MIN, msg_collection.window));
+
+	if ((window != msg_collection.cur_window) &&
+	    (msg_collection.debug_flags & DEBUG_FLAG_ROUTE))
+		info("msg aggr: sent %d msgs, window now %"PRIu64" msec",
+		     count, window);
+	msg_collection.cur_window = window;
+}
+
 /*
  * _msg_aggregation_sender()
  *
  *  Start and terminate message collection windows.
  *  Send collected msgs to next collector node or final destination
- *  at window expiration.
+ *  at window expiration, or as soon as max_msg_cnt msgs are collected.
+ *  The window length adapts to the load, see _adapt_window().
  */
 static void * _msg_aggregation_sender(void *arg)
 {
@@ -202,6 +233,7 @@ static void * _msg_aggregation_sender(void *arg)
 	struct timespec timeout;
 	slurm_msg_t msg;
 	composite_msg_t cmp;
+	int count;
 
 	msg_collection.running = 1;
 
@@ -218,14 +250,19 @@ static void * _msg_aggregation_sender(void *arg)
 
 		/* A msg has been collected; start new window */
 		gettimeofday(&now, NULL);
-		timeout.tv_sec = now.tv_sec + (msg_collection.window / 1000);
+		timeout.tv_sec = now.tv_sec +
+			(msg_collection.cur_window / 1000);
 		timeout.tv_nsec = (now.tv_usec * 1000) +
-			(1000000 * (msg_collection.window % 1000));
+			(1000000 * (msg_collection.cur_window % 1000));
 		timeout.tv_sec += timeout.tv_nsec / 1000000000;
 		timeout.tv_nsec %= 1000000000;
 
-		pthread_cond_timedwait(&msg_collection.cond,
-				       &msg_collection.mutex, &timeout);
+		while (!msg_collection.max_msgs && msg_collection.running) {
+			if (pthread_cond_timedwait(&msg_collection.cond,
+						   &msg_collection.mutex,
+						   &timeout) == ETIMEDOUT)
+				break;
+		}
 
 		if (!msg_collection.running &&
 		    !list_count(msg_collection.msg_list))
@@ -241,10 +278,12 @@ static void * _msg_aggregation_sender(void *arg)
 		memcpy(&cmp.sender, &msg_collection.node_addr,
 		       sizeof(slurm_addr_t));
 		cmp.msg_list = msg_collection.msg_list;
+		count = list_count(cmp.msg_list);
 
 		msg_collection.msg_list =
 			list_create(slurm_free_comp_msg_list);
 		msg_collection.max_msgs = false;
+		_adapt_window(count);
 
 		slurm_msg_t_init(&msg);
 		msg.msg_type = MESSAGE_COMPOSITE;
@@ -283,6 +322,7 @@ extern void msg_aggr_sender_init(char *host, uint16_t port, uint64_t window,
 	pthread_cond_init(&msg_collection.cond, NULL);
 	slurm_set_addr(&msg_collection.node_addr, port, host);
 	msg_collection.window = window;
+	msg_collection.cur_window = window;
 	msg_collection.max_msg_cnt = max_msg_cnt;
 	msg_collection.msg_aggr_list = list_create(_msg_aggr_free);
 	msg_collection.msg_list = list_create(slurm_free_comp_msg_list);
@@ -309,6 +349,8 @@ extern void msg_aggr_sender_reconfig(uint64_t window, uint64_t max_msg_cnt)
 	if (msg_collection.running) {
 		slurm_mutex_lock(&msg_collection.mutex);
 		msg_collection.window = window;
+		msg_collection.cur_window = MIN(msg_collection.cur_window,
+						window);
 		msg_collection.max_msg_cnt = max_msg_cnt;
 		msg_collection.debug_flags = slurm_get_debug_flags();
 		slurm_mutex_unlock(&msg_collection.mutex);
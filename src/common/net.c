@@ -241,6 +241,20 @@ extern int net_set_keep_alive(int sock)
 	return 0;
 }
 
+/* disable Nagle's algorithm on socket */
+extern int net_set_nodelay(int sock)
+{
+	int opt_int = 1;
+
+	if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt_int,
+		       sizeof(opt_int)) < 0) {
+		error("Unable to set TCP_NODELAY socket option: %m");
+		return -1;
+	}
+
+	return 0;
+}
+
 /* net_stream_listen_ports()
  */
 int
@@ -65,6 +65,10 @@ extern int net_set_low_water(int sock, socklen_t size);
 /* set keep alive time on socket */
 extern int net_set_keep_alive(int sock);
 
+/* disable Nagle's algorithm on socket, used for connections carrying many
+ * small request/response exchanges */
+extern int net_set_nodelay(int sock);
+
 extern int net_stream_listen_ports(int *, uint16_t *, uint16_t *);
 
 #endif /* !_NET_H */
@@ -59,6 +59,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/param.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -975,9 +976,10 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 			     bitstr_t **bitmap)
 {
 	int rc = SLURM_SUCCESS;
-	char *this_node_name;
+	char this_node_name[MAXHOSTNAMELEN + 16];
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
+	hostlist_iterator_t hi;
 
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
@@ -995,7 +997,10 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
-	while ( (this_node_name = hostlist_shift (host_list)) ) {
+	/* Copy each name to a local buffer, no allocation per node */
+	hi = hostlist_iterator_create(host_list);
+	while (hostlist_next_buf(hi, 0, this_node_name,
+				 sizeof(this_node_name))) {
 		struct node_record *node_ptr;
 		node_ptr = _find_node_record(this_node_name, best_effort, true);
 		if (node_ptr) {
@@ -1007,8 +1012,8 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 			if (!best_effort)
 				rc = EINVAL;
 		}
-		free (this_node_name);
 	}
+	hostlist_iterator_destroy(hi);
 	hostlist_destroy (host_list);
 
 	return rc;
@@ -1025,7 +1030,7 @@ extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 {
 	int rc = SLURM_SUCCESS;
 	bitstr_t *my_bitmap;
-	char *name;
+	char name[MAXHOSTNAMELEN + 16];
 	hostlist_iterator_t hi;
 
 	FREE_NULL_BITMAP(*bitmap);
@@ -1033,7 +1038,7 @@ extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 	*bitmap = my_bitmap;
 
 	hi = hostlist_iterator_create(hl);
-	while ((name = hostlist_next(hi)) != NULL) {
+	while (hostlist_next_buf(hi, 0, name, sizeof(name))) {
 		struct node_record *node_ptr;
 		node_ptr = _find_node_record(name, best_effort, true);
 		if (node_ptr) {
@@ -1045,7 +1050,6 @@ extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 			if (!best_effort)
 				rc = EINVAL;
 		}
-		free (name);
 	}
 
 	hostlist_iterator_destroy(hi);
@@ -66,6 +66,7 @@ strong_alias(free_buf,		slurm_free_buf);
 strong_alias(grow_buf,		slurm_grow_buf);
 strong_alias(init_buf,		slurm_init_buf);
 strong_alias(xfer_buf_data,	slurm_xfer_buf_data);
+strong_alias(try_grow_buf_remaining, slurm_try_grow_buf_remaining);
 strong_alias(pack_time,		slurm_pack_time);
 strong_alias(unpack_time,	slurm_unpack_time);
 strong_alias(packdouble,	slurm_packdouble);
@@ -155,6 +156,27 @@ Buf init_buf(int size)
 	return my_buf;
 }
 
+/*
+ * try_grow_buf_remaining - make sure at least "size" bytes are available
+ * past the current offset, growing the buffer once if needed.
+ * RET SLURM_SUCCESS or SLURM_ERROR if the buffer size limit would be exceeded
+ */
+int try_grow_buf_remaining(Buf buffer, uint32_t size)
+{
+	if (remaining_buf(buffer) >= size)
+		return SLURM_SUCCESS;
+
+	if (((uint64_t) buffer->size + size + BUF_SIZE) > MAX_BUF_SIZE) {
+		error("%s: Buffer size limit exceeded (%"PRIu64" > %u)",
+		      __func__, ((uint64_t) buffer->size + size + BUF_SIZE),
+		      MAX_BUF_SIZE);
+		return SLURM_ERROR;
+	}
+	buffer->size += (size + BUF_SIZE);
+	xrealloc_nz(buffer->head, buffer->size);
+	return SLURM_SUCCESS;
+}
+
 /* xfer_buf_data - return a pointer to the buffer's data and release the
  * buffer's structure */
 void *xfer_buf_data(Buf my_buf)
@@ -360,6 +382,10 @@ int unpack16_array(uint16_t ** valp, uint32_t * size_val, Buf buffer)
 	if (unpack32(size_val, buffer))
 		return SLURM_ERROR;
 
+	/* Validate the whole array once rather than per element */
+	if ((remaining_buf(buffer) / sizeof(uint16_t)) < *size_val)
+		return SLURM_ERROR;
+
 	*valp = xmalloc_nz((*size_val) * sizeof(uint16_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack16((*valp) + i, buffer))
@@ -389,6 +415,10 @@ int unpack32_array(uint32_t ** valp, uint32_t * size_val, Buf buffer)
 	if (unpack32(size_val, buffer))
 		return SLURM_ERROR;
 
+	/* Validate the whole array once rather than per element */
+	if ((remaining_buf(buffer) / sizeof(uint32_t)) < *size_val)
+		return SLURM_ERROR;
+
 	*valp = xmalloc_nz((*size_val) * sizeof(uint32_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack32((*valp) + i, buffer))
@@ -418,6 +448,10 @@ int unpack64_array(uint64_t ** valp, uint32_t * size_val, Buf buffer)
 	if (unpack32(size_val, buffer))
 		return SLURM_ERROR;
 
+	/* Validate the whole array once rather than per element */
+	if ((remaining_buf(buffer) / sizeof(uint64_t)) < *size_val)
+		return SLURM_ERROR;
+
 	*valp = xmalloc_nz((*size_val) * sizeof(uint64_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack64((*valp) + i, buffer))
@@ -277,6 +277,14 @@ static const char *syms[] = {
 };
 
 static slurm_acct_storage_ops_t ops;
+/* Optional, only plugins able to return jobs a few at a time define
+ * jobacct_storage_p_get_jobs_cond_cb, see
+ * jobacct_storage_g_get_jobs_cond_cb() */
+static int (*get_jobs_cond_cb) (void *db_conn, uint32_t uid,
+				slurmdb_job_cond_t *job_cond,
+				int (*callback) (slurmdb_job_rec_t *job,
+						 void *arg),
+				void *arg) = NULL;
 static plugin_context_t *plugin_context = NULL;
 static pthread_mutex_t plugin_context_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool init_run = false;
@@ -325,6 +333,8 @@ extern int slurm_acct_storage_init(char *loc)
 		retval = SLURM_ERROR;
 		goto done;
 	}
+	get_jobs_cond_cb = plugin_get_sym(plugin_context->cur_plugin,
+					  "jobacct_storage_p_get_jobs_cond_cb");
 	init_run = true;
 	enforce = slurm_get_accounting_storage_enforce();
 done:
@@ -341,6 +351,7 @@ extern int slurm_acct_storage_fini(void)
 		return SLURM_SUCCESS;
 
 	init_run = false;
+	get_jobs_cond_cb = NULL;
 //	(*(ops.acct_storage_fini))();
 	rc = plugin_context_destroy(plugin_context);
 	plugin_context = NULL;
@@ -940,6 +951,60 @@ extern List jobacct_storage_g_get_jobs_cond(void *db_conn, uint32_t uid,
 	return (*(ops.get_jobs_cond))(db_conn, uid, job_cond);
 }
 
+/*
+ * call callback for each job_rec_t * in job_list, stopping at the first
+ * return other than SLURM_SUCCESS, which is returned
+ */
+extern int jobacct_storage_job_list_cb(
+	List job_list, int (*callback) (slurmdb_job_rec_t *job, void *arg),
+	void *arg)
+{
+	ListIterator itr;
+	slurmdb_job_rec_t *job;
+	int rc = SLURM_SUCCESS;
+
+	itr = list_iterator_create(job_list);
+	while ((job = list_next(itr))) {
+		if ((rc = (*callback)(job, arg)) != SLURM_SUCCESS)
+			break;
+	}
+	list_iterator_destroy(itr);
+
+	return rc;
+}
+
+/*
+ * get info from the storage, calling callback for each job_rec_t *
+ * found.  The job is freed when callback returns, and a return other
+ * than SLURM_SUCCESS from callback ends the query.  Plugins without
+ * jobacct_storage_p_get_jobs_cond_cb, or which fail it with
+ * ESLURM_NOT_SUPPORTED, have their whole job list walked instead.
+ */
+extern int jobacct_storage_g_get_jobs_cond_cb(
+	void *db_conn, uint32_t uid, slurmdb_job_cond_t *job_cond,
+	int (*callback) (slurmdb_job_rec_t *job, void *arg), void *arg)
+{
+	List job_list;
+	int rc;
+
+	if (slurm_acct_storage_init(NULL) < 0)
+		return SLURM_ERROR;
+	if (get_jobs_cond_cb) {
+		rc = (*get_jobs_cond_cb)(db_conn, uid, job_cond,
+					 callback, arg);
+		if ((rc != SLURM_ERROR) ||
+		    (slurm_get_errno() != ESLURM_NOT_SUPPORTED))
+			return rc;
+	}
+
+	if (!(job_list = (*(ops.get_jobs_cond))(db_conn, uid, job_cond)))
+		return SLURM_ERROR;
+	rc = jobacct_storage_job_list_cb(job_list, callback, arg);
+	list_destroy(job_list);
+
+	return rc;
+}
+
 /*
  * expire old info from the storage
  */
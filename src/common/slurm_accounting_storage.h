@@ -558,6 +558,24 @@ extern int jobacct_storage_g_job_suspend(void *db_conn,
 extern List jobacct_storage_g_get_jobs_cond(void *db_conn, uint32_t uid,
 					    slurmdb_job_cond_t *job_cond);
 
+/*
+ * call callback for each slurmdb_job_rec_t * of job_list, stopping at and
+ * returning the first return other than SLURM_SUCCESS
+ */
+extern int jobacct_storage_job_list_cb(
+	List job_list, int (*callback) (slurmdb_job_rec_t *job, void *arg),
+	void *arg);
+
+/*
+ * get info from the storage, calling callback for each slurmdb_job_rec_t *
+ * note the job is freed when callback returns, a return other than
+ * SLURM_SUCCESS from callback ends the query
+ * RET: SLURM_SUCCESS, SLURM_ERROR with errno set, or callback's return
+ */
+extern int jobacct_storage_g_get_jobs_cond_cb(
+	void *db_conn, uint32_t uid, slurmdb_job_cond_t *job_cond,
+	int (*callback) (slurmdb_job_rec_t *job, void *arg), void *arg);
+
 /*
  * expire old info from the storage
  */
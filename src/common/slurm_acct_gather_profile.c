@@ -145,8 +145,17 @@ static void *_timer_thread(void *args)
 			/* info ("%d is %d and %d", i, */
 			/*       acct_gather_profile_timer[i].freq, */
 			/*       diff); */
-			if (!acct_gather_profile_timer[i].freq
-			    || (diff < acct_gather_profile_timer[i].freq))
+			if (!acct_gather_profile_timer[i].freq)
+				continue;
+			if (i == PROFILE_TASK) {
+				/* Poll on multiples of the frequency so that
+				 * every step of the node polls at the same
+				 * time and can share one read of /proc */
+				if ((now / acct_gather_profile_timer[i].freq) ==
+				    (acct_gather_profile_timer[i].last_notify /
+				     acct_gather_profile_timer[i].freq))
+					continue;
+			} else if (diff < acct_gather_profile_timer[i].freq)
 				continue;
 			debug2("profile signalling type %s",
 			       acct_gather_profile_type_t_name(i));
@@ -51,6 +51,7 @@
 #include "src/common/plugin.h"
 #include "src/common/plugrack.h"
 #include "src/common/arg_desc.h"
+#include "src/common/timers.h"
 
 static bool auth_dummy = false;	/* for security testing */
 static bool init_run = false;
@@ -98,6 +99,9 @@ static slurm_auth_ops_t ops;
 static plugin_context_t *g_context = NULL;
 static pthread_mutex_t      context_lock = PTHREAD_MUTEX_INITIALIZER;
 
+static slurm_auth_stats_t   auth_stats;
+static pthread_mutex_t      auth_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static void **
 _slurm_auth_marshal_args(void *hosts, int timeout)
 {
@@ -208,6 +212,7 @@ g_slurm_auth_create( void *hosts, int timeout, char *auth_info )
 {
         void **argv;
         void *ret;
+	DEF_TIMERS;
 
 	if ( slurm_auth_init(NULL) < 0 )
 		return NULL;
@@ -219,8 +224,16 @@ g_slurm_auth_create( void *hosts, int timeout, char *auth_info )
                 return NULL;
         }
 
+	START_TIMER;
         ret = (*(ops.create))( argv, auth_info );
+	END_TIMER;
         xfree( argv );
+
+	slurm_mutex_lock(&auth_stats_lock);
+	auth_stats.create_cnt++;
+	auth_stats.create_time += DELTA_TIMER;
+	slurm_mutex_unlock(&auth_stats_lock);
+
         return ret;
 }
 
@@ -240,6 +253,7 @@ int
 g_slurm_auth_verify( void *cred, void *hosts, int timeout, char *auth_info )
 {
         int ret;
+	DEF_TIMERS;
 
         if ( slurm_auth_init(NULL) < 0 )
                 return SLURM_ERROR;
@@ -247,7 +261,17 @@ g_slurm_auth_verify( void *cred, void *hosts, int timeout, char *auth_info )
 	if ( auth_dummy )
 		return SLURM_SUCCESS;
 
+	START_TIMER;
         ret = (*(ops.verify))( cred, auth_info );
+	END_TIMER;
+
+	slurm_mutex_lock(&auth_stats_lock);
+	auth_stats.verify_cnt++;
+	auth_stats.verify_time += DELTA_TIMER;
+	if (auth_stats.verify_max < DELTA_TIMER)
+		auth_stats.verify_max = DELTA_TIMER;
+	slurm_mutex_unlock(&auth_stats_lock);
+
         return ret;
 }
 
@@ -325,3 +349,24 @@ g_slurm_auth_errstr( int slurm_errno )
 
         return (*(ops.sa_errstr))( slurm_errno );
 }
+
+extern void slurm_auth_get_stats(slurm_auth_stats_t *stats)
+{
+	slurm_mutex_lock(&auth_stats_lock);
+	memcpy(stats, &auth_stats, sizeof(slurm_auth_stats_t));
+	slurm_mutex_unlock(&auth_stats_lock);
+}
+
+extern void slurm_auth_reset_stats(void)
+{
+	slurm_mutex_lock(&auth_stats_lock);
+	memset(&auth_stats, 0, sizeof(slurm_auth_stats_t));
+	slurm_mutex_unlock(&auth_stats_lock);
+}
+
+extern void slurm_auth_session_used(void)
+{
+	slurm_mutex_lock(&auth_stats_lock);
+	auth_stats.session_cnt++;
+	slurm_mutex_unlock(&auth_stats_lock);
+}
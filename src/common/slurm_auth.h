@@ -163,4 +163,24 @@ int	g_slurm_auth_print( void *cred, FILE *fp );
 int	g_slurm_auth_errno( void *cred );
 const char *g_slurm_auth_errstr( int slurm_errno );
 
+/*
+ * Authentication statistics for this process, reported by sdiag.
+ * Times are in microseconds.
+ */
+typedef struct slurm_auth_stats {
+	uint32_t create_cnt;	/* credentials created */
+	uint64_t create_time;	/* total time creating credentials */
+	uint32_t verify_cnt;	/* credentials verified */
+	uint64_t verify_time;	/* total time verifying credentials */
+	uint32_t verify_max;	/* longest credential verification */
+	uint32_t session_cnt;	/* messages authenticated by the session
+				 * of a persistent connection instead of a
+				 * credential */
+} slurm_auth_stats_t;
+
+extern void slurm_auth_get_stats(slurm_auth_stats_t *stats);
+extern void slurm_auth_reset_stats(void);
+/* Note a message authenticated by its connection's session */
+extern void slurm_auth_session_used(void);
+
 #endif /*__SLURM_AUTHENTICATION_H__*/
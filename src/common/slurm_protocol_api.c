@@ -58,6 +58,12 @@
 #include <time.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <poll.h>
+
+#if defined(HAVE_ZLIB) && defined(HAVE_ZLIB_H)
+#  include <zlib.h>
+#  define USE_MSG_COMPRESSION 1
+#endif
 
 /* PROJECT INCLUDES */
 #include "src/common/fd.h"
@@ -71,11 +77,14 @@
 #include "src/common/slurm_protocol_common.h"
 #include "src/common/slurm_protocol_pack.h"
 #include "src/common/slurm_route.h"
+#include "src/common/slurm_strcasestr.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/common/log.h"
 #include "src/common/forward.h"
 #include "src/common/msg_aggr.h"
+#include "src/common/net.h"
 #include "src/slurmdbd/read_config.h"
 #include "src/common/slurm_accounting_storage.h"
 
@@ -84,6 +93,9 @@
 /* #DEFINES */
 #define _DEBUG	0
 #define MAX_SHUTDOWN_RETRY 5
+/* Default minimum message body size to compress, see
+ * CommunicationParameters=compress_threshold= */
+#define DEFAULT_COMPRESS_THRESHOLD (1024 * 1024)
 
 /* STATIC VARIABLES */
 /* static pthread_mutex_t config_lock = PTHREAD_MUTEX_INITIALIZER; */
@@ -92,11 +104,38 @@ static slurm_protocol_config_t *proto_conf = &proto_conf_default;
 /* static slurm_ctl_conf_t slurmctld_conf; */
 static int message_timeout = -1;
 
+/* Connection to slurmctld kept open between RPCs when configured with
+ * CommunicationParameters=persist_conn */
+static pthread_mutex_t persist_conn_lock = PTHREAD_MUTEX_INITIALIZER;
+static slurm_fd_t persist_conn_fd = -1;
+static pid_t persist_conn_pid = 0;
+static int persist_conn_replies = 0;	/* replies received on connection */
+static void *persist_conn_cred = NULL;	/* slurmctld's verified credential */
+static uid_t persist_conn_uid = 0;	/* uid of our last credential sent */
+static time_t persist_conn_auth_time = 0; /* time our last credential sent */
+
+/* CommunicationParameters options checked on every message, parsed once
+ * and again after slurm_reset_comm_params() */
+static pthread_mutex_t comm_params_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t comm_params_gen = 0;	/* bumped on each reset */
+static bool comm_params_set = false;
+static uint32_t comm_compress_threshold = DEFAULT_COMPRESS_THRESHOLD;
+static bool comm_persist_conn = false;
+static uint16_t comm_flags = 0;		/* COMM_FLAG_* */
+
 /* STATIC FUNCTIONS */
 static char *_global_auth_key(void);
 static void  _remap_slurmctld_errno(void);
 static int   _unpack_msg_uid(Buf buffer);
 static bool  _is_port_ok(int, uint16_t);
+static void  _compress_msg_body(slurm_msg_t *msg, header_t *header,
+				Buf buffer, uint32_t body_offset);
+static int   _uncompress_msg_body(header_t *header, Buf *buffer);
+static int   _persist_conn_get(slurm_fd_t *fd);
+static void  _persist_conn_release(bool close_conn);
+static void  _persist_conn_reset(void);
+static void  _persist_conn_close(void);
+static int   _persist_conn_open(void);
 
 #if _DEBUG
 static void _print_data(char *data, int len);
@@ -2027,6 +2066,94 @@ uint16_t slurm_get_kill_wait(void)
 	return kill_wait;
 }
 
+/* slurm_get_comm_params
+ * get comm_params from slurmctld_conf object
+ * RET char *   - comm_params, MUST be xfreed by caller
+ */
+char *slurm_get_comm_params(void)
+{
+	char *comm_params = NULL;
+	slurm_ctl_conf_t *conf;
+
+	if (slurmdbd_conf) {
+	} else {
+		conf = slurm_conf_lock();
+		comm_params = xstrdup(conf->comm_params);
+		slurm_conf_unlock();
+	}
+	return comm_params;
+}
+
+/* slurm_reset_comm_params
+ * discard the cached CommunicationParameters options so they are parsed
+ * again from the configuration on next use
+ */
+void slurm_reset_comm_params(void)
+{
+	slurm_mutex_lock(&comm_params_lock);
+	comm_params_gen++;
+	comm_params_set = false;
+	slurm_mutex_unlock(&comm_params_lock);
+}
+
+/* Parse the CommunicationParameters options used here if not yet cached.
+ * The configuration is read without comm_params_lock held so that lock
+ * never nests with the conf lock. */
+static void _load_comm_params(void)
+{
+	uint32_t gen, threshold = DEFAULT_COMPRESS_THRESHOLD;
+	bool persist_conn = false;
+	uint16_t flags = 0;
+	char *comm_params, *tmp_ptr;
+
+	slurm_mutex_lock(&comm_params_lock);
+	if (comm_params_set) {
+		slurm_mutex_unlock(&comm_params_lock);
+		return;
+	}
+	gen = comm_params_gen;
+	slurm_mutex_unlock(&comm_params_lock);
+
+	comm_params = slurm_get_comm_params();
+	if (comm_params &&
+	    (tmp_ptr = slurm_strcasestr(comm_params, "compress_threshold=")))
+		threshold = strtoul(tmp_ptr + 19, NULL, 10);
+	if (comm_params && slurm_strcasestr(comm_params, "persist_conn"))
+		persist_conn = true;
+	if (comm_params && slurm_strcasestr(comm_params, "mux_agent"))
+		flags |= COMM_FLAG_MUX_AGENT;
+	if (comm_params && slurm_strcasestr(comm_params, "ping_tree"))
+		flags |= COMM_FLAG_PING_TREE;
+	if (comm_params && slurm_strcasestr(comm_params, "agent_coalesce"))
+		flags |= COMM_FLAG_AGENT_COALESCE;
+	xfree(comm_params);
+
+	slurm_mutex_lock(&comm_params_lock);
+	if (gen == comm_params_gen) {	/* no reset while parsing */
+		comm_compress_threshold = threshold;
+		comm_persist_conn = persist_conn;
+		comm_flags = flags;
+		comm_params_set = true;
+	}
+	slurm_mutex_unlock(&comm_params_lock);
+}
+
+/* slurm_get_comm_flags
+ * get the CommunicationParameters options kept in the cache
+ * RET uint16_t - COMM_FLAG_* of the options set
+ */
+uint16_t slurm_get_comm_flags(void)
+{
+	uint16_t flags;
+
+	_load_comm_params();
+	slurm_mutex_lock(&comm_params_lock);
+	flags = comm_flags;
+	slurm_mutex_unlock(&comm_params_lock);
+
+	return flags;
+}
+
 /* slurm_get_launch_params
  * get launch_params from slurmctld_conf object
  * RET char *   - launch_params, MUST be xfreed by caller
@@ -2807,49 +2934,25 @@ slurm_fd_t slurm_open_controller_conn_spec(enum controller_id dest)
  */
 int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 {
-	char *buf = NULL;
-	size_t buflen = 0;
+	return slurm_receive_session_msg(fd, msg, timeout, NULL);
+}
+
+/*
+ * Authenticate and unpack a message received on fd into msg. The buffer
+ * is always consumed. session_cred authenticates messages sent without a
+ * credential of their own, see slurm_receive_session_msg().
+ * RET SLURM_SUCCESS or an error code
+ */
+static int _unpack_received_msg(slurm_msg_t *msg, slurm_fd_t fd, Buf buffer,
+				void *session_cred)
+{
 	header_t header;
 	int rc;
 	void *auth_cred = NULL;
-	Buf buffer;
-
-	xassert(fd >= 0);
-	slurm_msg_t_init(msg);
-	msg->conn_fd = fd;
-
-	if (timeout <= 0)
-		/* convert secs to msec */
-		timeout  = slurm_get_msg_timeout() * 1000;
-
-	else if (timeout > (slurm_get_msg_timeout() * 10000)) {
-		debug("%s: You are receiving a message with very long "
-		      "timeout of %d seconds", __func__, (timeout/1000));
-	} else if (timeout < 1000) {
-		error("%s: You are receiving a message with a very short "
-		      "timeout of %d msecs", __func__, timeout);
-	}
-
-	/*
-	 * Receive a msg. slurm_msg_recvfrom() will read the message
-	 *  length and allocate space on the heap for a buffer containing
-	 *  the message.
-	 */
-	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
-		forward_init(&header.forward, NULL);
-		rc = errno;
-		goto total_return;
-	}
-
-#if	_DEBUG
-	_print_data (buf, buflen);
-#endif
-	buffer = create_buf(buf, buflen);
 
 	if (unpack_header(&header, buffer) == SLURM_ERROR) {
 		free_buf(buffer);
-		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
-		goto total_return;
+		return SLURM_COMMUNICATIONS_RECEIVE_ERROR;
 	}
 
 	if (check_header_version(&header) < 0) {
@@ -2857,7 +2960,7 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 		char addr_str[32];
 		int uid = _unpack_msg_uid(buffer);
 
-		if (!slurm_get_peer_addr(fd, &resp_addr)) {
+		if ((fd >= 0) && !slurm_get_peer_addr(fd, &resp_addr)) {
 			slurm_print_slurm_addr(
 				&resp_addr, addr_str, sizeof(addr_str));
 			error("%s: Invalid Protocol Version %u from uid=%d at %s",
@@ -2887,29 +2990,53 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 		      "slurm_receive_msg_and_forward instead", __func__);
 	}
 
-	if ((auth_cred = g_slurm_auth_unpack(buffer)) == NULL) {
+	if (header.flags & SLURM_MSG_SESSION_AUTH) {
+		/* No credential, the sender relies on the identity
+		 * established earlier on this connection */
+		if (!session_cred) {
+			error("%s: %s has no session to authenticate it",
+			      __func__, rpc_num2string(header.msg_type));
+			free_buf(buffer);
+			rc = SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+			goto total_return;
+		}
+		auth_cred = session_cred;
+		slurm_auth_session_used();
+	} else if ((auth_cred = g_slurm_auth_unpack(buffer)) == NULL) {
 		error("%s: authentication: %s ", __func__,
 		       g_slurm_auth_errstr(g_slurm_auth_errno(NULL)));
 		free_buf(buffer);
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
-	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _global_auth_key() );
 	} else {
-		char *auth_info = slurm_get_auth_info();
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2, auth_info );
-		xfree(auth_info);
+		if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
+			rc = g_slurm_auth_verify( auth_cred, NULL, 2,
+						  _global_auth_key() );
+		} else {
+			char *auth_info = slurm_get_auth_info();
+			rc = g_slurm_auth_verify( auth_cred, NULL, 2,
+						  auth_info );
+			xfree(auth_info);
+		}
+
+		if (rc != SLURM_SUCCESS) {
+			error("%s: %s has authentication error: %s ",
+			      __func__, rpc_num2string(header.msg_type),
+			      g_slurm_auth_errstr(
+				      g_slurm_auth_errno(auth_cred)));
+			(void) g_slurm_auth_destroy(auth_cred);
+			free_buf(buffer);
+			rc = SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+			goto total_return;
+		}
 	}
 
-	if (rc != SLURM_SUCCESS) {
-		error("%s: %s has authentication error: %s ", __func__,
-		      rpc_num2string(header.msg_type),
-		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
-		(void) g_slurm_auth_destroy(auth_cred);
+	if ((header.flags & SLURM_MSG_COMPRESSED) &&
+	    (_uncompress_msg_body(&header, &buffer) != SLURM_SUCCESS)) {
+		if (auth_cred != session_cred)
+			(void) g_slurm_auth_destroy(auth_cred);
 		free_buf(buffer);
-		rc = SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
 
@@ -2923,7 +3050,8 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 	if ((header.body_length > remaining_buf(buffer)) ||
 	    (unpack_msg(msg, buffer) != SLURM_SUCCESS)) {
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
-		(void) g_slurm_auth_destroy(auth_cred);
+		if (auth_cred != session_cred)
+			(void) g_slurm_auth_destroy(auth_cred);
 		free_buf(buffer);
 		goto total_return;
 	}
@@ -2935,6 +3063,47 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 
 total_return:
 	destroy_forward(&header.forward);
+	return rc;
+}
+
+int slurm_receive_session_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout,
+			      void *session_cred)
+{
+	char *buf = NULL;
+	size_t buflen = 0;
+	int rc;
+	Buf buffer;
+
+	xassert(fd >= 0);
+	slurm_msg_t_init(msg);
+	msg->conn_fd = fd;
+
+	if (timeout <= 0)
+		/* convert secs to msec */
+		timeout  = slurm_get_msg_timeout() * 1000;
+
+	else if (timeout > (slurm_get_msg_timeout() * 10000)) {
+		debug("%s: You are receiving a message with very long "
+		      "timeout of %d seconds", __func__, (timeout/1000));
+	} else if (timeout < 1000) {
+		error("%s: You are receiving a message with a very short "
+		      "timeout of %d msecs", __func__, timeout);
+	}
+
+	/*
+	 * Receive a msg. slurm_msg_recvfrom() will read the message
+	 *  length and allocate space on the heap for a buffer containing
+	 *  the message.
+	 */
+	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
+		rc = errno;
+	} else {
+#if	_DEBUG
+		_print_data (buf, buflen);
+#endif
+		buffer = create_buf(buf, buflen);
+		rc = _unpack_received_msg(msg, fd, buffer, session_cred);
+	}
 
 	slurm_seterrno(rc);
 	if (rc != SLURM_SUCCESS) {
@@ -2963,20 +3132,10 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 {
 	char *buf = NULL;
 	size_t buflen = 0;
-	header_t header;
-	int rc;
-	void *auth_cred = NULL;
-	slurm_msg_t msg;
-	Buf buffer;
-	ret_data_info_t *ret_data_info = NULL;
-	List ret_list = NULL;
 	int orig_timeout = timeout;
 
 	xassert(fd >= 0);
 
-	slurm_msg_t_init(&msg);
-	msg.conn_fd = fd;
-
 	if (timeout <= 0) {
 		/* convert secs to msec */
 		timeout  = slurm_get_msg_timeout() * 1000;
@@ -3015,15 +3174,40 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 	 *  the message.
 	 */
 	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
-		forward_init(&header.forward, NULL);
-		rc = errno;
-		goto total_return;
+		int rc = errno;
+		error("slurm_receive_msgs: %s", slurm_strerror(rc));
+		usleep(10000);	/* Discourage brute force attack */
+		errno = rc;
+		return NULL;
 	}
 
 #if	_DEBUG
 	_print_data (buf, buflen);
 #endif
-	buffer = create_buf(buf, buflen);
+	return slurm_unpack_received_msgs(fd, create_buf(buf, buflen));
+}
+
+/*
+ * slurm_unpack_received_msgs - authenticate and unpack a message read by
+ *	the caller, less its length prefix, as slurm_receive_msgs() would
+ * IN fd	- connection the message came from, for error messages only,
+ *		  may be -1
+ * IN buffer	- the message, always consumed
+ * RET List	- List containing the responses of the children (if any)
+ *		  and the message itself (ret_data_info_t), NULL on error
+ *		  with errno set
+ */
+List slurm_unpack_received_msgs(slurm_fd_t fd, Buf buffer)
+{
+	header_t header;
+	int rc;
+	void *auth_cred = NULL;
+	slurm_msg_t msg;
+	ret_data_info_t *ret_data_info = NULL;
+	List ret_list = NULL;
+
+	slurm_msg_t_init(&msg);
+	msg.conn_fd = fd;
 
 	if (unpack_header(&header, buffer) == SLURM_ERROR) {
 		free_buf(buffer);
@@ -3035,7 +3219,7 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 		slurm_addr_t resp_addr;
 		char addr_str[32];
 		int uid = _unpack_msg_uid(buffer);
-		if (!slurm_get_peer_addr(fd, &resp_addr)) {
+		if ((fd >= 0) && !slurm_get_peer_addr(fd, &resp_addr)) {
 			slurm_print_slurm_addr(
 				&resp_addr, addr_str, sizeof(addr_str));
 			error("Invalid Protocol Version %u from uid=%d at %s",
@@ -3091,6 +3275,14 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 		goto total_return;
 	}
 
+	if ((header.flags & SLURM_MSG_COMPRESSED) &&
+	    (_uncompress_msg_body(&header, &buffer) != SLURM_SUCCESS)) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -3156,20 +3348,14 @@ static int _unpack_msg_uid(Buf buffer)
 }
 
 /*
- * NOTE: memory is allocated for the returned msg and the returned list
- *       both must be freed at some point using the slurm_free_functions
- *       and list_destroy function.
- * IN open_fd	- file descriptor to receive msg on
- * IN/OUT msg	- a slurm_msg struct to be filled in by the function
- *		  we use the orig_addr from this var for forwarding.
- * IN timeout	- how long to wait in milliseconds
- * RET int	- returns 0 on success, -1 on failure and sets errno
+ * Process a message read from fd, reading it first unless buf is set,
+ * see slurm_receive_msg_and_forward() and
+ * slurm_receive_buf_msg_and_forward()
  */
-int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
-				  slurm_msg_t *msg, int timeout)
+static int _receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
+				    slurm_msg_t *msg, int timeout,
+				    char *buf, size_t buflen)
 {
-	char *buf = NULL;
-	size_t buflen = 0;
 	header_t header;
 	int rc;
 	void *auth_cred = NULL;
@@ -3192,31 +3378,34 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 
 	msg->ret_list = list_create(destroy_data_info);
 
-	if (timeout <= 0)
-		/* convert secs to msec */
-		timeout  = slurm_get_msg_timeout() * 1000;
-
-	if (timeout >= (slurm_get_msg_timeout() * 10000)) {
-		debug("slurm_receive_msg_and_forward: "
-		      "You are sending a message with timeout's greater "
-		      "than %d seconds, your's is %d seconds",
-		      (slurm_get_msg_timeout() * 10),
-		      (timeout/1000));
-	} else if (timeout < 1000) {
-		debug("slurm_receive_msg_and_forward: "
-		      "You are sending a message with a very short timeout of "
-		      "%d milliseconds", timeout);
-	}
-
 	/*
 	 * Receive a msg. slurm_msg_recvfrom() will read the message
 	 *  length and allocate space on the heap for a buffer containing
 	 *  the message.
 	 */
-	if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0, timeout) < 0) {
-		forward_init(&header.forward, NULL);
-		rc = errno;
-		goto total_return;
+	if (!buf) {
+		if (timeout <= 0)
+			/* convert secs to msec */
+			timeout  = slurm_get_msg_timeout() * 1000;
+
+		if (timeout >= (slurm_get_msg_timeout() * 10000)) {
+			debug("slurm_receive_msg_and_forward: "
+			      "You are sending a message with timeout's "
+			      "greater than %d seconds, your's is %d seconds",
+			      (slurm_get_msg_timeout() * 10),
+			      (timeout/1000));
+		} else if (timeout < 1000) {
+			debug("slurm_receive_msg_and_forward: "
+			      "You are sending a message with a very short "
+			      "timeout of %d milliseconds", timeout);
+		}
+
+		if (slurm_msg_recvfrom_timeout(fd, &buf, &buflen, 0,
+					       timeout) < 0) {
+			forward_init(&header.forward, NULL);
+			rc = errno;
+			goto total_return;
+		}
 	}
 
 #if	_DEBUG
@@ -3331,6 +3520,14 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 		goto total_return;
 	}
 
+	if ((header.flags & SLURM_MSG_COMPRESSED) &&
+	    (_uncompress_msg_body(&header, &buffer) != SLURM_SUCCESS)) {
+		(void) g_slurm_auth_destroy(auth_cred);
+		free_buf(buffer);
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		goto total_return;
+	}
+
 	/*
 	 * Unpack message body
 	 */
@@ -3373,6 +3570,41 @@ total_return:
 
 }
 
+/*
+ * NOTE: memory is allocated for the returned msg and the returned list
+ *       both must be freed at some point using the slurm_free_functions
+ *       and list_destroy function.
+ * IN open_fd	- file descriptor to receive msg on
+ * IN/OUT msg	- a slurm_msg struct to be filled in by the function
+ *		  we use the orig_addr from this var for forwarding.
+ * IN timeout	- how long to wait in milliseconds
+ * RET int	- returns 0 on success, -1 on failure and sets errno
+ */
+int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
+				  slurm_msg_t *msg, int timeout)
+{
+	return _receive_msg_and_forward(fd, orig_addr, msg, timeout, NULL, 0);
+}
+
+/*
+ * As slurm_receive_msg_and_forward(), for a message which has already been
+ *	read from the connection (without its length), e.g. by a server
+ *	polling many connections
+ * IN open_fd	- file descriptor the msg was received on, used for replies
+ * IN/OUT msg	- a slurm_msg struct to be filled in by the function
+ *		  we use the orig_addr from this var for forwarding.
+ * IN buf	- message received, consumed
+ * IN buflen	- size of buf
+ * RET int	- returns 0 on success, -1 on failure and sets errno
+ */
+int slurm_receive_buf_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
+				      slurm_msg_t *msg, char *buf,
+				      size_t buflen)
+{
+	xassert(buf);
+	return _receive_msg_and_forward(fd, orig_addr, msg, 0, buf, buflen);
+}
+
 /**********************************************************************\
  * send message functions
 \**********************************************************************/
@@ -3400,13 +3632,94 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 	set_buf_offset(buffer, tmplen);
 }
 
+/*
+ * Pack the header, auth credential and body of msg into a new buffer,
+ * ready to be written after its length. The credential is destroyed.
+ * RET buffer to free_buf() or NULL on error with errno set
+ */
+static Buf _pack_msg_buffer(slurm_msg_t *msg, void *auth_cred)
+{
+	header_t header;
+	Buf      buffer;
+	int      rc;
+	uint32_t body_offset;
+
+	init_header(&header, msg, msg->flags);
+
+	/*
+	 * Pack header into buffer for transmission
+	 */
+	buffer = init_buf(BUF_SIZE);
+	pack_header(&header, buffer);
+
+	/*
+	 * Pack auth credential
+	 */
+	if (auth_cred) {
+		rc = g_slurm_auth_pack(auth_cred, buffer);
+		(void) g_slurm_auth_destroy(auth_cred);
+		if (rc) {
+			error("authentication: %s",
+			      g_slurm_auth_errstr(
+				      g_slurm_auth_errno(auth_cred)));
+			free_buf(buffer);
+			slurm_seterrno(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+			return NULL;
+		}
+	}
+
+	/*
+	 * Pack message into buffer
+	 */
+	body_offset = get_buf_offset(buffer);
+	_pack_msg(msg, &header, buffer);
+	_compress_msg_body(msg, &header, buffer, body_offset);
+
+#if	_DEBUG
+	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
+#endif
+	return buffer;
+}
+
+/*
+ * slurm_pack_node_msg - pack a message, with a new auth credential, into
+ *	the form slurm_send_node_msg() would transmit it. This permits the
+ *	same bytes to be written to many connections, each preceded by the
+ *	buffer's length as a uint32_t in network byte order.
+ * IN msg - message to pack, which must not be forwarded
+ * RET buffer to free_buf() or NULL on error with errno set
+ */
+Buf slurm_pack_node_msg(slurm_msg_t *msg)
+{
+	void *auth_cred;
+
+	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
+		auth_cred = g_slurm_auth_create(NULL, 2, _global_auth_key());
+	} else {
+		char *auth_info = slurm_get_auth_info();
+		auth_cred = g_slurm_auth_create(NULL, 2, auth_info);
+		xfree(auth_info);
+	}
+	if (auth_cred == NULL) {
+		error("authentication: %s",
+		      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)) );
+		slurm_seterrno(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		return NULL;
+	}
+
+	if (msg->forward.init != FORWARD_INIT) {
+		forward_init(&msg->forward, NULL);
+		msg->ret_list = NULL;
+	}
+	return _pack_msg_buffer(msg, auth_cred);
+}
+
 /*
  *  Send a slurm message over an open file descriptor `fd'
  *    Returns the size of the message sent in bytes, or -1 on failure.
  */
 int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 {
-	header_t header;
 	Buf      buffer;
 	int      rc;
 	void *   auth_cred;
@@ -3418,8 +3731,12 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	 * can be done in parallel with waiting for message to forward,
 	 * but we may need to generate the credential again later if we
 	 * wait too long for the incoming message.
+	 * No credential is sent with a message authenticated by the
+	 * session of its persistent connection.
 	 */
-	if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
+	if (msg->flags & SLURM_MSG_SESSION_AUTH) {
+		auth_cred = NULL;
+	} else if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
 		auth_cred = g_slurm_auth_create(NULL, 2, _global_auth_key());
 	} else {
 		char *auth_info = slurm_get_auth_info();
@@ -3433,7 +3750,7 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	}
 	forward_wait(msg);
 
-	if (difftime(time(NULL), start_time) >= 60) {
+	if (auth_cred && (difftime(time(NULL), start_time) >= 60)) {
 		(void) g_slurm_auth_destroy(auth_cred);
 		if (msg->flags & SLURM_GLOBAL_AUTH_KEY) {
 			auth_cred = g_slurm_auth_create(NULL, 2,
@@ -3444,40 +3761,15 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 			xfree(auth_info);
 		}
 	}
-	if (auth_cred == NULL) {
+	if ((auth_cred == NULL) && !(msg->flags & SLURM_MSG_SESSION_AUTH)) {
 		error("authentication: %s",
 		      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)) );
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
-	init_header(&header, msg, msg->flags);
-
-	/*
-	 * Pack header into buffer for transmission
-	 */
-	buffer = init_buf(BUF_SIZE);
-	pack_header(&header, buffer);
-
-	/*
-	 * Pack auth credential
-	 */
-	rc = g_slurm_auth_pack(auth_cred, buffer);
-	(void) g_slurm_auth_destroy(auth_cred);
-	if (rc) {
-		error("authentication: %s",
-		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
-		free_buf(buffer);
-		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
-	}
-
-	/*
-	 * Pack message into buffer
-	 */
-	_pack_msg(msg, &header, buffer);
+	if (!(buffer = _pack_msg_buffer(msg, auth_cred)))
+		return SLURM_ERROR;
 
-#if	_DEBUG
-	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
-#endif
 	/*
 	 * Send message
 	 */
@@ -3510,6 +3802,138 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	return rc;
 }
 
+/* Return true if the message type is a potentially large reply which
+ * may be sent compressed to a peer advertising SLURM_MSG_ACCEPT_COMPRESS */
+static bool _is_compressible_msg(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_STEP_INFO:
+	case RESPONSE_NODE_INFO:
+	case RESPONSE_PARTITION_INFO:
+	case RESPONSE_RESERVATION_INFO:
+	case RESPONSE_FRONT_END_INFO:
+	case RESPONSE_BURST_BUFFER_INFO:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Return the minimum message body size to compress, zero to disable */
+static uint32_t _get_compress_threshold(void)
+{
+	uint32_t threshold;
+
+	_load_comm_params();
+	slurm_mutex_lock(&comm_params_lock);
+	threshold = comm_compress_threshold;
+	slurm_mutex_unlock(&comm_params_lock);
+
+	return threshold;
+}
+
+/*
+ * Replace the packed body of a large reply with its zlib compressed form,
+ * prefixed by the uncompressed length, and repack the header to match.
+ * The body is left unchanged unless the peer advertised support for
+ * compression and compressing it actually saves space.
+ */
+static void _compress_msg_body(slurm_msg_t *msg, header_t *header,
+			       Buf buffer, uint32_t body_offset)
+{
+#ifdef USE_MSG_COMPRESSION
+	uint32_t body_len = get_buf_offset(buffer) - body_offset;
+	uint32_t threshold, tmplen;
+	uLongf comp_len;
+	char *comp_buf;
+	DEF_TIMERS;
+
+	if (!(msg->flags & SLURM_MSG_ACCEPT_COMPRESS) ||
+	    (header->version < SLURM_15_08_PROTOCOL_VERSION) ||
+	    !_is_compressible_msg(msg->msg_type))
+		return;
+	threshold = _get_compress_threshold();
+	if ((threshold == 0) || (body_len < threshold))
+		return;
+
+	START_TIMER;
+	comp_len = compressBound(body_len);
+	comp_buf = xmalloc_nz(comp_len);
+	if ((compress2((Bytef *) comp_buf, &comp_len,
+		       (Bytef *) &buffer->head[body_offset], body_len,
+		       Z_BEST_SPEED) != Z_OK) ||
+	    ((comp_len + sizeof(uint32_t)) >= body_len)) {
+		xfree(comp_buf);
+		return;
+	}
+
+	set_buf_offset(buffer, body_offset);
+	pack32(body_len, buffer);
+	packmem_array(comp_buf, comp_len, buffer);
+	xfree(comp_buf);
+
+	header->flags |= SLURM_MSG_COMPRESSED;
+	update_header(header, comp_len + sizeof(uint32_t));
+	tmplen = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack_header(header, buffer);
+	set_buf_offset(buffer, tmplen);
+	END_TIMER;
+	debug3("%s: %s compressed from %u to %lu bytes %s", __func__,
+	       rpc_num2string(msg->msg_type), body_len,
+	       (unsigned long) comp_len, TIME_STR);
+#endif
+}
+
+/*
+ * Replace a buffer containing a compressed message body (at the current
+ * offset) with a new buffer containing only the uncompressed body.
+ * RET SLURM_SUCCESS or SLURM_ERROR, in which case the caller still owns
+ *     and must free the original buffer
+ */
+static int _uncompress_msg_body(header_t *header, Buf *buffer)
+{
+#ifdef USE_MSG_COMPRESSION
+	Buf comp_buf = *buffer;
+	uint32_t body_len;
+	uLongf data_len;
+	char *data;
+
+	if ((header->body_length > remaining_buf(comp_buf)) ||
+	    (header->body_length < sizeof(uint32_t)) ||
+	    unpack32(&body_len, comp_buf))
+		return SLURM_ERROR;
+	if ((body_len == 0) || (body_len > MAX_BUF_SIZE)) {
+		error("%s: invalid uncompressed length %u", __func__,
+		      body_len);
+		return SLURM_ERROR;
+	}
+
+	data_len = body_len;
+	data = xmalloc_nz(body_len);
+	if ((uncompress((Bytef *) data, &data_len,
+			(Bytef *) &comp_buf->head[comp_buf->processed],
+			header->body_length - sizeof(uint32_t)) != Z_OK) ||
+	    (data_len != body_len)) {
+		error("%s: corrupt compressed %s message", __func__,
+		      rpc_num2string(header->msg_type));
+		xfree(data);
+		return SLURM_ERROR;
+	}
+
+	free_buf(comp_buf);
+	*buffer = create_buf(data, body_len);
+	header->body_length = body_len;
+	header->flags &= (~SLURM_MSG_COMPRESSED);
+	return SLURM_SUCCESS;
+#else
+	error("%s: received compressed %s message, but zlib support is not "
+	      "available", __func__, rpc_num2string(header->msg_type));
+	return SLURM_ERROR;
+#endif
+}
+
 /**********************************************************************\
  * stream functions
 \**********************************************************************/
@@ -3864,10 +4288,174 @@ _send_and_recv_msgs(slurm_fd_t fd, slurm_msg_t *req, int timeout)
 }
 
 
+/* Return true if persistent connections to slurmctld are configured */
+static bool _use_persist_conn(void)
+{
+	bool rc;
+
+	_load_comm_params();
+	slurm_mutex_lock(&comm_params_lock);
+	rc = comm_persist_conn;
+	slurm_mutex_unlock(&comm_params_lock);
+
+	return rc;
+}
+
+/* Return true if an idle persistent connection is still usable. Any
+ * pending input on an idle connection means slurmctld closed it. */
+static bool _persist_conn_alive(slurm_fd_t fd)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) != 0)
+		return false;
+	return true;
+}
+
+/*
+ * Get the persistent connection to slurmctld, opening it if needed.
+ * OUT fd - the connection, valid only if 1 is returned
+ * RET 1 if the connection is available and persist_conn_lock is held,
+ *     0 if a private connection should be used instead,
+ *     -1 if no connection could be established
+ * NOTE: Call _persist_conn_release() when the RPC is complete
+ */
+static int _persist_conn_get(slurm_fd_t *fd)
+{
+	if (working_cluster_rec || !_use_persist_conn())
+		return 0;
+	/* Another thread is using the connection, do not wait for it */
+	if (pthread_mutex_trylock(&persist_conn_lock))
+		return 0;
+
+	if (persist_conn_fd >= 0) {
+		if (persist_conn_pid != getpid()) {
+			/* Inherited over fork(), leave it to the parent */
+			(void) close(persist_conn_fd);
+			persist_conn_fd = -1;
+			_persist_conn_reset();
+		} else if (!_persist_conn_alive(persist_conn_fd)) {
+			debug2("%s: slurmctld closed connection %d",
+			       __func__, persist_conn_fd);
+			_persist_conn_close();
+		}
+	}
+	if ((persist_conn_fd < 0) && (_persist_conn_open() < 0)) {
+		slurm_mutex_unlock(&persist_conn_lock);
+		return -1;
+	}
+
+	*fd = persist_conn_fd;
+	return 1;
+}
+
+/* Open a new persistent connection to slurmctld
+ * NOTE: Insure that persist_conn_lock is set on function entry
+ * RET the connection or -1 on failure */
+static int _persist_conn_open(void)
+{
+	slurm_addr_t ctrl_addr;
+
+	persist_conn_fd = slurm_open_controller_conn(&ctrl_addr);
+	if (persist_conn_fd < 0)
+		return -1;
+	fd_set_close_on_exec(persist_conn_fd);
+	/* Requests and replies are small, do not let them wait
+	 * for an ACK of the previous segment */
+	net_set_nodelay(persist_conn_fd);
+	persist_conn_pid = getpid();
+
+	return persist_conn_fd;
+}
+
+/* Release the persistent connection from _persist_conn_get(), closing it
+ * if the last exchange on it failed */
+static void _persist_conn_release(bool close_conn)
+{
+	if (close_conn && (persist_conn_fd >= 0))
+		_persist_conn_close();
+	slurm_mutex_unlock(&persist_conn_lock);
+}
+
+/* Forget the authentication state of the persistent connection */
+static void _persist_conn_reset(void)
+{
+	if (persist_conn_cred) {
+		(void) g_slurm_auth_destroy(persist_conn_cred);
+		persist_conn_cred = NULL;
+	}
+	persist_conn_replies = 0;
+}
+
+static void _persist_conn_close(void)
+{
+	(void) slurm_shutdown_msg_conn(persist_conn_fd);
+	persist_conn_fd = -1;
+	_persist_conn_reset();
+}
+
+/*
+ * Send a request and receive the response on the persistent connection
+ * to slurmctld, leaving the connection open.
+ *
+ * Once slurmctld has answered more than one request on the connection (and
+ * so supports persistent connections) requests and replies are sent
+ * without a credential. Each side then relies on the identity proven by
+ * the last credential it received on the connection. We send a new
+ * credential whenever our uid changes and every PERSIST_CONN_AUTH_TTL
+ * seconds, slurmctld refuses a session older than PERSIST_CONN_SESSION_TTL.
+ *
+ * OUT keep_conn - set if slurmctld agreed to keep the connection open
+ */
+static int _persist_send_and_recv_msg(slurm_fd_t fd, slurm_msg_t *req,
+				      slurm_msg_t *resp, bool *keep_conn)
+{
+	time_t now = time(NULL);
+	uid_t uid = geteuid();
+	int rc;
+
+	slurm_msg_t_init(resp);
+	*keep_conn = false;
+
+	req->flags |= SLURM_MSG_KEEP_CONN;
+	if ((persist_conn_replies > 1) && (persist_conn_uid == uid) &&
+	    (difftime(now, persist_conn_auth_time) < PERSIST_CONN_AUTH_TTL)) {
+		req->flags |= SLURM_MSG_SESSION_AUTH;
+	} else {
+		persist_conn_uid = uid;
+		persist_conn_auth_time = now;
+	}
+	rc = slurm_send_node_msg(fd, req);
+	req->flags &= ~(SLURM_MSG_KEEP_CONN | SLURM_MSG_SESSION_AUTH);
+	if (rc < 0)
+		return -1;
+
+	if (slurm_receive_session_msg(fd, resp, 0, persist_conn_cred) != 0)
+		return -1;
+	if (resp->auth_cred != persist_conn_cred) {
+		if (persist_conn_cred)
+			(void) g_slurm_auth_destroy(persist_conn_cred);
+		persist_conn_cred = resp->auth_cred;
+	}
+	resp->auth_cred = NULL;
+	persist_conn_replies++;
+
+	/* slurmctld clears the flag if it will close the connection */
+	if (resp->flags & SLURM_MSG_KEEP_CONN)
+		*keep_conn = true;
+
+	return 0;
+}
+
 /*
  * slurm_send_recv_controller_msg
  * opens a connection to the controller, sends the controller a message,
- * listens for the response, then closes the connection
+ * listens for the response, then closes the connection (unless
+ * CommunicationParameters=persist_conn, in which case the connection is
+ * kept open for the next request)
  * IN request_msg	- slurm_msg request
  * OUT response_msg	- slurm_msg response
  * RET int		- returns 0 on success, -1 on failure and sets errno
@@ -3882,6 +4470,8 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 	bool backup_controller_flag;
 	uint16_t slurmctld_timeout;
 	slurm_addr_t ctrl_addr;
+	int persist;
+	bool keep_conn = false;
 
 	/* Just in case the caller didn't initialize his slurm_msg_t, and
 	 * since we KNOW that we are only sending to one node (the controller),
@@ -3893,8 +4483,15 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 
 	if (working_cluster_rec)
 		req->flags |= SLURM_GLOBAL_AUTH_KEY;
+#ifdef USE_MSG_COMPRESSION
+	/* Large replies (job, node, partition info, etc.) may be compressed */
+	req->flags |= SLURM_MSG_ACCEPT_COMPRESS;
+#endif
 
-	if ((fd = slurm_open_controller_conn(&ctrl_addr)) < 0) {
+	persist = _persist_conn_get(&fd);
+	if ((persist < 0) ||
+	    ((persist == 0) &&
+	     ((fd = slurm_open_controller_conn(&ctrl_addr)) < 0))) {
 		rc = -1;
 		goto cleanup;
 	}
@@ -3908,11 +4505,30 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 		/* If the backup controller is in the process of assuming
 		 * control, we sleep and retry later */
 		retry = 0;
-		rc = _send_and_recv_msg(fd, req, resp, 0);
-		if (resp->auth_cred)
-			g_slurm_auth_destroy(resp->auth_cred);
-		else
-			rc = -1;
+		if (persist > 0) {
+			bool reused = (persist_conn_replies > 0);
+
+			rc = _persist_send_and_recv_msg(fd, req, resp,
+							&keep_conn);
+			if ((rc != 0) && reused &&
+			    (errno != SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT)) {
+				/* slurmctld closed the connection since it
+				 * was last used (idle or restarted), try once
+				 * more on a new one */
+				debug2("%s: persistent connection %d failed, "
+				       "reconnecting", __func__, fd);
+				_persist_conn_close();
+				if ((fd = _persist_conn_open()) >= 0)
+					rc = _persist_send_and_recv_msg(
+						fd, req, resp, &keep_conn);
+			}
+		} else {
+			rc = _send_and_recv_msg(fd, req, resp, 0);
+			if (resp->auth_cred)
+				g_slurm_auth_destroy(resp->auth_cred);
+			else
+				rc = -1;
+		}
 
 		if ((rc == 0) && (!working_cluster_rec)
 		    && (resp->msg_type == RESPONSE_SLURM_RC)
@@ -3925,6 +4541,10 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 			debug("Neither primary nor backup controller "
 			      "responding, sleep and retry");
 			slurm_free_return_code_msg(resp->data);
+			if (persist > 0) {
+				_persist_conn_release(true);
+				persist = 0;
+			}
 			sleep(30);
 			if ((fd = slurm_open_controller_conn(&ctrl_addr))
 			    < 0) {
@@ -3937,6 +4557,8 @@ int slurm_send_recv_controller_msg(slurm_msg_t *req, slurm_msg_t *resp)
 		if (rc == -1)
 			break;
 	}
+	if (persist > 0)
+		_persist_conn_release((rc != 0) || !keep_conn);
 
 cleanup:
 	if (rc != 0)
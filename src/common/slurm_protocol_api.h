@@ -556,6 +556,29 @@ uint32_t slurm_get_accounting_storage_port(void);
  */
 int slurm_set_accounting_storage_port(uint32_t storage_port);
 
+/* slurm_get_comm_params
+ * get comm_params from slurmctld_conf object
+ * RET char *   - comm_params, MUST be xfreed by caller
+ */
+char *slurm_get_comm_params(void);
+
+/* CommunicationParameters options returned by slurm_get_comm_flags() */
+#define COMM_FLAG_AGENT_COALESCE	0x0001	/* merge agent requests */
+#define COMM_FLAG_MUX_AGENT		0x0002	/* multiplexed agent */
+#define COMM_FLAG_PING_TREE		0x0004	/* ping down the tree */
+
+/* slurm_get_comm_flags
+ * get the CommunicationParameters options kept in the cache
+ * RET uint16_t - COMM_FLAG_* of the options set
+ */
+uint16_t slurm_get_comm_flags(void);
+
+/* slurm_reset_comm_params
+ * discard the cached CommunicationParameters options so they are parsed
+ * again from the configuration on next use
+ */
+void slurm_reset_comm_params(void);
+
 /* slurm_get_launch_params
  * get launch_params from slurmctld_conf object
  * RET char *   - launch_params, MUST be xfreed by caller
@@ -927,6 +950,23 @@ extern int slurm_shutdown_msg_engine(slurm_fd_t open_fd);
  */
 int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout);
 
+/*
+ *  Like slurm_receive_msg(), but also accept a message authenticated by
+ *    the session of a persistent connection (SLURM_MSG_SESSION_AUTH) rather
+ *    than by a credential of its own. Such a message gets "session_cred",
+ *    the last verified credential received on this connection, as its
+ *    msg->auth_cred; the caller must not free it with the message.
+ *
+ * IN open_fd	- file descriptor to receive msg on
+ * OUT msg	- a slurm_msg struct to be filled in by the function
+ * IN timeout	- how long to wait in milliseconds
+ * IN session_cred - verified credential of the connection, or NULL if no
+ *		  session has been established yet
+ * RET int	- returns 0 on success, -1 on failure and sets errno
+ */
+int slurm_receive_session_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout,
+			      void *session_cred);
+
 /*
  *  Receive a slurm message on the open slurm descriptor "fd" waiting
  *    at most "timeout" seconds for the message data. If timeout is
@@ -944,6 +984,20 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout);
  */
 List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout);
 
+/*
+ * slurm_unpack_received_msgs - authenticate and unpack a message read by
+ *    the caller, without its length prefix, as slurm_receive_msgs() would
+ *
+ * IN fd	- connection the message came from, for error messages only,
+ *		  may be -1
+ * IN buffer	- the message, always consumed
+ * RET List	- List containing the responses of the children (if any) we
+ *		  forwarded the message to and the message itself. List
+ *		  containing type (ret_data_info_t). NULL on error with
+ *		  errno set.
+ */
+List slurm_unpack_received_msgs(slurm_fd_t fd, Buf buffer);
+
 /*
  *  Receive a slurm message on the open slurm descriptor "fd" waiting
  *    at most "timeout" seconds for the message data. This will also
@@ -964,6 +1018,20 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout);
 int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 				  slurm_msg_t *resp, int timeout);
 
+/*
+ * As slurm_receive_msg_and_forward(), for a message which has already been
+ *	read from the connection (without its length), e.g. by a server
+ *	polling many connections
+ * IN open_fd	- file descriptor the msg was received on, used for replies
+ * IN/OUT resp	- a slurm_msg struct to be filled in by the function
+ * IN buf	- message received, consumed
+ * IN buflen	- size of buf
+ * RET int	- returns 0 on success, -1 on failure and sets errno
+ */
+int slurm_receive_buf_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
+				      slurm_msg_t *resp, char *buf,
+				      size_t buflen);
+
 /**********************************************************************\
  * send message functions
 \**********************************************************************/
@@ -976,6 +1044,15 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
  */
 int slurm_send_node_msg(slurm_fd_t open_fd, slurm_msg_t *msg);
 
+/* packs a message with a new credential as slurm_send_node_msg would send
+ *	it, so the same bytes can be written to many nodes, each preceded by
+ *	the length of the buffer as a uint32_t in network byte order
+ *
+ * IN msg		- a slurm msg struct to be packed, not forwarded
+ * RET Buf		- packed message to free_buf(), NULL on error
+ */
+Buf slurm_pack_node_msg(slurm_msg_t *msg);
+
 /**********************************************************************\
  * msg connection establishment functions used by msg clients
 \**********************************************************************/
@@ -96,6 +96,20 @@
 /* used to set flags to empty */
 #define SLURM_PROTOCOL_NO_FLAGS 0
 #define SLURM_GLOBAL_AUTH_KEY   0x0001
+#define SLURM_MSG_ACCEPT_COMPRESS 0x0002 /* sender can uncompress the reply */
+#define SLURM_MSG_COMPRESSED    0x0004	/* message body is zlib compressed */
+#define SLURM_MSG_KEEP_CONN     0x0008	/* keep connection open after reply */
+#define SLURM_MSG_SESSION_AUTH  0x0010	/* no credential, authenticated by the
+					 * connection's session */
+#define SLURM_MSG_AGGR_RESP     0x0020	/* replies of a forwarding subtree
+					 * may be merged into one */
+
+/* A client sends a new credential on a persistent connection at least
+ * this often (in seconds) rather than relying on the connection's session */
+#define PERSIST_CONN_AUTH_TTL	60
+/* The server no longer accepts messages on the session of a credential
+ * verified longer ago than this (in seconds) */
+#define PERSIST_CONN_SESSION_TTL (PERSIST_CONN_AUTH_TTL * 2)
 
 #include "src/common/slurm_protocol_socket_common.h"
 
@@ -1176,7 +1176,16 @@ extern void slurm_free_suspend_int_msg(suspend_int_msg_t *msg)
 
 extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 {
+	uint32_t i;
+
 	if (msg) {
+		for (i = 0; msg->msg_aggr_addr && (i < msg->msg_aggr_size);
+		     i++)
+			xfree(msg->msg_aggr_addr[i]);
+		xfree(msg->msg_aggr_addr);
+		xfree(msg->msg_aggr_batch_cnt);
+		xfree(msg->msg_aggr_msg_cnt);
+		xfree(msg->msg_aggr_batch_max);
 		xfree(msg->rpc_type_id);
 		xfree(msg->rpc_type_cnt);
 		xfree(msg->rpc_type_time);
@@ -1412,6 +1421,16 @@ extern void slurm_free_ping_slurmd_resp(ping_slurmd_resp_msg_t *msg)
 	xfree(msg);
 }
 
+extern void slurm_free_ping_slurmd_resp_list(
+	ping_slurmd_resp_list_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->node_list);
+		xfree(msg->cpu_load);
+		xfree(msg);
+	}
+}
+
 extern char *preempt_mode_string(uint16_t preempt_mode)
 {
 	char *gang_str;
@@ -2637,6 +2656,7 @@ extern void slurm_free_slurmd_status(slurmd_status_t* slurmd_status_ptr)
 {
 	if (slurmd_status_ptr) {
 		xfree(slurmd_status_ptr->hostname);
+		xfree(slurmd_status_ptr->script_stats);
 		xfree(slurmd_status_ptr->slurmd_logfile);
 		xfree(slurmd_status_ptr->step_list);
 		xfree(slurmd_status_ptr->version);
@@ -3207,6 +3227,28 @@ extern void slurm_free_composite_msg(composite_msg_t *msg)
 	}
 }
 
+extern void slurm_free_node_msg_list(node_msg_list_t *msg)
+{
+	void *data;
+
+	if (msg) {
+		if (msg->data_list) {
+			while ((data = list_pop(msg->data_list)))
+				slurm_free_msg_data(msg->msg_type, data);
+			list_destroy(msg->data_list);
+		}
+		xfree(msg);
+	}
+}
+
+extern void slurm_free_node_msg_list_resp(node_msg_list_resp_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->rc_array);
+		xfree(msg);
+	}
+}
+
 extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 {
 	switch(type) {
@@ -3467,6 +3509,15 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case RESPONSE_MESSAGE_COMPOSITE:
 		slurm_free_composite_msg(data);
 		break;
+	case REQUEST_NODE_MSG_LIST:
+		slurm_free_node_msg_list(data);
+		break;
+	case RESPONSE_NODE_MSG_LIST:
+		slurm_free_node_msg_list_resp(data);
+		break;
+	case RESPONSE_PING_SLURMD_LIST:
+		slurm_free_ping_slurmd_resp_list(data);
+		break;
 	default:
 		error("invalid type trying to be freed %u", type);
 		break;
@@ -3476,7 +3527,8 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 
 extern uint32_t slurm_get_return_code(slurm_msg_type_t type, void *data)
 {
-	uint32_t rc = 0;
+	uint32_t rc = 0, i;
+	node_msg_list_resp_msg_t *resp_list;
 
 	switch(type) {
 	case MESSAGE_EPILOG_COMPLETE:
@@ -3495,11 +3547,18 @@ extern uint32_t slurm_get_return_code(slurm_msg_type_t type, void *data)
 		rc = ((return_code_msg_t *)data)->return_code;
 		break;
 	case RESPONSE_PING_SLURMD:
+	case RESPONSE_PING_SLURMD_LIST:
 		rc = SLURM_SUCCESS;
 		break;
 	case RESPONSE_ACCT_GATHER_UPDATE:
 		rc = SLURM_SUCCESS;
 		break;
+	case RESPONSE_NODE_MSG_LIST:
+		/* First failure, slurmctld's agent checks all of them */
+		resp_list = (node_msg_list_resp_msg_t *) data;
+		for (i = 0; (i < resp_list->rc_cnt) && !rc; i++)
+			rc = resp_list->rc_array[i];
+		break;
 	case RESPONSE_FORWARD_FAILED:
 		/* There may be other reasons for the failure, but
 		 * this may be a slurm_msg_t data type lacking the
@@ -3877,6 +3936,12 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_COMPLETE_PROLOG";
 	case RESPONSE_PROLOG_EXECUTING:
 		return "RESPONSE_PROLOG_EXECUTING";
+	case REQUEST_NODE_MSG_LIST:
+		return "REQUEST_NODE_MSG_LIST";
+	case RESPONSE_NODE_MSG_LIST:
+		return "RESPONSE_NODE_MSG_LIST";
+	case RESPONSE_PING_SLURMD_LIST:
+		return "RESPONSE_PING_SLURMD_LIST";
 	case SRUN_PING:
 		return "SRUN_PING";
 	case SRUN_TIMEOUT:
@@ -348,6 +348,9 @@ typedef enum {
 	REQUEST_LAUNCH_PROLOG,
 	REQUEST_COMPLETE_PROLOG,
 	RESPONSE_PROLOG_EXECUTING,
+	REQUEST_NODE_MSG_LIST,	/* several messages of one type to a node */
+	RESPONSE_NODE_MSG_LIST,
+	RESPONSE_PING_SLURMD_LIST, /* REQUEST_PING replies of a subtree */
 
 	SRUN_PING = 7001,
 	SRUN_TIMEOUT,
@@ -823,6 +826,17 @@ typedef struct composite_msg {
 	List	 msg_list;
 } composite_msg_t;
 
+/* Messages of a single type coalesced by slurmctld into one RPC */
+typedef struct node_msg_list {
+	uint16_t msg_type;	/* type of every message in data_list */
+	List	 data_list;	/* message bodies, freed by msg_type */
+} node_msg_list_t;
+
+typedef struct node_msg_list_resp {
+	uint32_t  rc_cnt;
+	uint32_t *rc_array;	/* return code of each message, in order */
+} node_msg_list_resp_msg_t;
+
 /* Note: We include the node list here for reliable cleanup on XCPU systems.
  *
  * Note: We include select_jobinfo here in addition to the job launch
@@ -1068,6 +1082,15 @@ typedef struct ping_slurmd_resp_msg {
 	uint32_t cpu_load;	/* CPU load * 100 */
 } ping_slurmd_resp_msg_t;
 
+/* REQUEST_PING replies of every responding node of a forwarding subtree,
+ * nodes which failed to respond are reported individually */
+typedef struct ping_slurmd_resp_list_msg {
+	char *node_list;	/* responding nodes, ranged hostlist */
+	uint32_t node_cnt;	/* count of nodes in node_list */
+	uint32_t *cpu_load;	/* CPU load * 100 of each node, in node_list
+				 * order */
+} ping_slurmd_resp_list_msg_t;
+
 typedef struct license_info_request_msg {
 	time_t last_update;
 	uint16_t show_flags;
@@ -1194,7 +1217,11 @@ extern void slurm_free_priority_factors_response_msg(
 extern void slurm_free_forward_data_msg(forward_data_msg_t *msg);
 extern void slurm_free_comp_msg_list(void *x);
 extern void slurm_free_composite_msg(composite_msg_t *msg);
+extern void slurm_free_node_msg_list(node_msg_list_t *msg);
+extern void slurm_free_node_msg_list_resp(node_msg_list_resp_msg_t *msg);
 extern void slurm_free_ping_slurmd_resp(ping_slurmd_resp_msg_t *msg);
+extern void slurm_free_ping_slurmd_resp_list(
+	ping_slurmd_resp_list_msg_t *msg);
 
 #define	slurm_free_timelimit_msg(msg) \
 	slurm_free_kill_job_msg(msg)
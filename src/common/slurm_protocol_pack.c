@@ -84,6 +84,97 @@
 #define _pack_sicp_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
 #define _pack_layout_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
 
+/*
+ * Wire schemas for runs of consecutive fixed-width fields in the largest
+ * RPC responses (see PACK_DEFINE_FIELDS() in pack.h). Each list must name
+ * the fields in exactly the order they are packed for that protocol version.
+ */
+#define NODE_INFO_HW_FIELDS_15_08(X)					\
+	X(U16,  cpus)							\
+	X(U16,  boards)							\
+	X(U16,  sockets)						\
+	X(U16,  cores)							\
+	X(U16,  threads)						\
+	X(U32,  real_memory)						\
+	X(U32,  tmp_disk)						\
+	X(U32,  owner)							\
+	X(U16,  core_spec_cnt)						\
+	X(U32,  mem_spec_limit)
+PACK_DEFINE_FIELDS(node_info_hw_15_08, node_info_t,
+		   NODE_INFO_HW_FIELDS_15_08)
+
+#define NODE_INFO_STATE_FIELDS_15_08(X)					\
+	X(U32,  cpu_load)						\
+	X(U32,  weight)							\
+	X(U32,  reason_uid)						\
+	X(TIME, boot_time)						\
+	X(TIME, reason_time)						\
+	X(TIME, slurmd_start_time)
+PACK_DEFINE_FIELDS(node_info_state_15_08, node_info_t,
+		   NODE_INFO_STATE_FIELDS_15_08)
+
+#define JOB_INFO_STATE_FIELDS_15_08(X)					\
+	X(U32,  assoc_id)						\
+	X(U32,  job_id)							\
+	X(U32,  user_id)						\
+	X(U32,  group_id)						\
+	X(U32,  profile)						\
+	X(U16,  job_state)						\
+	X(U16,  batch_flag)						\
+	X(U16,  state_reason)						\
+	X(U8,   power_flags)						\
+	X(U8,   reboot)							\
+	X(U8,   sicp_mode)						\
+	X(U16,  restart_cnt)						\
+	X(U16,  show_flags)						\
+	X(U32,  alloc_sid)						\
+	X(U32,  time_limit)						\
+	X(U32,  time_min)						\
+	X(U16,  nice)							\
+	X(TIME, submit_time)						\
+	X(TIME, eligible_time)						\
+	X(TIME, start_time)						\
+	X(TIME, end_time)						\
+	X(TIME, suspend_time)						\
+	X(TIME, pre_sus_time)						\
+	X(TIME, resize_time)						\
+	X(TIME, preempt_time)						\
+	X(U32,  priority)
+PACK_DEFINE_FIELDS(job_info_state_15_08, job_info_t,
+		   JOB_INFO_STATE_FIELDS_15_08)
+
+#define JOB_INFO_EXIT_FIELDS_15_08(X)					\
+	X(U32,  exit_code)						\
+	X(U32,  derived_ec)
+PACK_DEFINE_FIELDS(job_info_exit_15_08, job_info_t,
+		   JOB_INFO_EXIT_FIELDS_15_08)
+
+#define JOB_INFO_SWITCH_FIELDS_15_08(X)					\
+	X(U32,  req_switch)						\
+	X(U32,  wait4switch)
+PACK_DEFINE_FIELDS(job_info_switch_15_08, job_info_t,
+		   JOB_INFO_SWITCH_FIELDS_15_08)
+
+#define JOB_INFO_DETAILS_FIELDS_15_08(X)				\
+	X(U32,  num_cpus)						\
+	X(U32,  max_cpus)						\
+	X(U32,  num_nodes)						\
+	X(U32,  max_nodes)						\
+	X(U16,  requeue)						\
+	X(U16,  ntasks_per_node)					\
+	X(U16,  shared)							\
+	X(U32,  cpu_freq_min)						\
+	X(U32,  cpu_freq_max)						\
+	X(U32,  cpu_freq_gov)						\
+	X(U16,  contiguous)						\
+	X(U16,  core_spec)						\
+	X(U16,  cpus_per_task)						\
+	X(U16,  pn_min_cpus)						\
+	X(U32,  pn_min_memory)						\
+	X(U32,  pn_min_tmp_disk)
+PACK_DEFINE_FIELDS(job_info_details_15_08, job_info_t,
+		   JOB_INFO_DETAILS_FIELDS_15_08)
+
 static void _pack_assoc_shares_object(void *in, Buf buffer,
 				      uint16_t protocol_version);
 static int _unpack_assoc_shares_object(void **object, Buf buffer,
@@ -695,6 +786,11 @@ static void _pack_ping_slurmd_resp(ping_slurmd_resp_msg_t *msg,
 				   Buf buffer, uint16_t protocol_version);
 static int _unpack_ping_slurmd_resp(ping_slurmd_resp_msg_t **msg_ptr,
 				    Buf buffer, uint16_t protocol_version);
+static void _pack_ping_slurmd_resp_list(ping_slurmd_resp_list_msg_t *msg,
+					Buf buffer, uint16_t protocol_version);
+static int _unpack_ping_slurmd_resp_list(ping_slurmd_resp_list_msg_t **msg_ptr,
+					 Buf buffer,
+					 uint16_t protocol_version);
 
 static void _pack_license_info_request_msg(license_info_request_msg_t *msg,
                                            Buf buffer,
@@ -756,6 +852,15 @@ _unpack_network_callerid_resp_msg(network_callerid_resp_t **msg_ptr,
 					    Buf buffer,
 					    uint16_t protocol_version);
 
+static void _pack_node_msg_list(node_msg_list_t *msg, Buf buffer,
+				uint16_t protocol_version);
+static int  _unpack_node_msg_list(node_msg_list_t **msg_ptr, Buf buffer,
+				  uint16_t protocol_version);
+static void _pack_node_msg_list_resp(node_msg_list_resp_msg_t *msg,
+				     Buf buffer, uint16_t protocol_version);
+static int  _unpack_node_msg_list_resp(node_msg_list_resp_msg_t **msg_ptr,
+				       Buf buffer, uint16_t protocol_version);
+
 /* These functions should be removed when version 14.11 protocol is no longer
  * supported */
 #define OLD_DIST_CYCLIC		1
@@ -997,6 +1102,34 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* peek_header_msg_type
+ * get the message type from a slurm protocol header without unpacking the
+ *	rest of the message
+ * OUT msg_type - type of the message
+ * IN data - packed message, starting with its header
+ * IN size - bytes in data
+ * RET 0 or error code
+ */
+int
+peek_header_msg_type(uint16_t *msg_type, char *data, uint32_t size)
+{
+	Buf buffer = create_buf(data, size);
+	uint16_t version, uint16_tmp;
+	int rc = SLURM_ERROR;
+
+	safe_unpack16(&version, buffer);
+	safe_unpack16(&uint16_tmp, buffer);		/* flags */
+	if (version >= SLURM_15_08_PROTOCOL_VERSION)
+		safe_unpack16(&uint16_tmp, buffer);	/* msg_index */
+	safe_unpack16(msg_type, buffer);
+	rc = SLURM_SUCCESS;
+
+unpack_error:
+	buffer->head = NULL;	/* data still belongs to the caller */
+	free_buf(buffer);
+	return rc;
+}
+
 
 /* pack_msg
  * packs a generic slurm protocol message body
@@ -1630,6 +1763,20 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 	case RESPONSE_SICP_INFO:
 		_pack_sicp_info_msg((slurm_msg_t *) msg, buffer);
 		break;
+	case REQUEST_NODE_MSG_LIST:
+		_pack_node_msg_list((node_msg_list_t *) msg->data, buffer,
+				    msg->protocol_version);
+		break;
+	case RESPONSE_NODE_MSG_LIST:
+		_pack_node_msg_list_resp((node_msg_list_resp_msg_t *)
+					 msg->data, buffer,
+					 msg->protocol_version);
+		break;
+	case RESPONSE_PING_SLURMD_LIST:
+		_pack_ping_slurmd_resp_list((ping_slurmd_resp_list_msg_t *)
+					    msg->data, buffer,
+					    msg->protocol_version);
+		break;
 	default:
 		debug("No pack method for msg type %u", msg->msg_type);
 		return EINVAL;
@@ -2337,6 +2484,20 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 		rc = _unpack_sicp_info_msg((sicp_info_msg_t **) & (msg->data),
 					   buffer, msg->protocol_version);
 		break;
+	case REQUEST_NODE_MSG_LIST:
+		rc = _unpack_node_msg_list((node_msg_list_t **) &(msg->data),
+					   buffer, msg->protocol_version);
+		break;
+	case RESPONSE_NODE_MSG_LIST:
+		rc = _unpack_node_msg_list_resp((node_msg_list_resp_msg_t **)
+						&(msg->data), buffer,
+						msg->protocol_version);
+		break;
+	case RESPONSE_PING_SLURMD_LIST:
+		rc = _unpack_ping_slurmd_resp_list(
+			(ping_slurmd_resp_list_msg_t **) &(msg->data), buffer,
+			msg->protocol_version);
+		break;
 	default:
 		debug("No unpack method for msg type %u", msg->msg_type);
 		return EINVAL;
@@ -2684,6 +2845,113 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* Each message in the list is packed as it would be on its own */
+static void _pack_node_msg_list(node_msg_list_t *msg, Buf buffer,
+				uint16_t protocol_version)
+{
+	slurm_msg_t tmp_msg;
+	ListIterator itr;
+	uint32_t count = 0;
+
+	xassert(msg != NULL);
+
+	if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+		if (msg->data_list)
+			count = list_count(msg->data_list);
+		pack16(msg->msg_type, buffer);
+		pack32(count, buffer);
+		if (!count)
+			return;
+		slurm_msg_t_init(&tmp_msg);
+		tmp_msg.msg_type = msg->msg_type;
+		tmp_msg.protocol_version = protocol_version;
+		itr = list_iterator_create(msg->data_list);
+		while ((tmp_msg.data = list_next(itr)))
+			pack_msg(&tmp_msg, buffer);
+		list_iterator_destroy(itr);
+	} else {
+		error("_pack_node_msg_list: protocol_version "
+		      "%hu not supported", protocol_version);
+	}
+}
+
+static int _unpack_node_msg_list(node_msg_list_t **msg_ptr, Buf buffer,
+				 uint16_t protocol_version)
+{
+	node_msg_list_t *msg;
+	slurm_msg_t tmp_msg;
+	uint32_t count, i;
+
+	xassert(msg_ptr != NULL);
+
+	msg = xmalloc(sizeof(node_msg_list_t));
+	*msg_ptr = msg;
+	msg->data_list = list_create(NULL);
+	if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+		safe_unpack16(&msg->msg_type, buffer);
+		safe_unpack32(&count, buffer);
+		slurm_msg_t_init(&tmp_msg);
+		tmp_msg.msg_type = msg->msg_type;
+		tmp_msg.protocol_version = protocol_version;
+		for (i = 0; i < count; i++) {
+			if (unpack_msg(&tmp_msg, buffer) != SLURM_SUCCESS)
+				goto unpack_error;
+			list_append(msg->data_list, tmp_msg.data);
+		}
+	} else {
+		error("_unpack_node_msg_list: protocol_version "
+		      "%hu not supported", protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	info("_unpack_node_msg_list error");
+	*msg_ptr = NULL;
+	slurm_free_node_msg_list(msg);
+	return SLURM_ERROR;
+}
+
+static void _pack_node_msg_list_resp(node_msg_list_resp_msg_t *msg,
+				     Buf buffer, uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+
+	if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+		pack32_array(msg->rc_array, msg->rc_cnt, buffer);
+	} else {
+		error("_pack_node_msg_list_resp: protocol_version "
+		      "%hu not supported", protocol_version);
+	}
+}
+
+static int _unpack_node_msg_list_resp(node_msg_list_resp_msg_t **msg_ptr,
+				      Buf buffer, uint16_t protocol_version)
+{
+	node_msg_list_resp_msg_t *msg;
+
+	xassert(msg_ptr != NULL);
+
+	msg = xmalloc(sizeof(node_msg_list_resp_msg_t));
+	*msg_ptr = msg;
+	if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+		safe_unpack32_array(&msg->rc_array, &msg->rc_cnt, buffer);
+	} else {
+		error("_unpack_node_msg_list_resp: protocol_version "
+		      "%hu not supported", protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	info("_unpack_node_msg_list_resp error");
+	*msg_ptr = NULL;
+	slurm_free_node_msg_list_resp(msg);
+	return SLURM_ERROR;
+}
+
 static void _pack_shares_request_msg(shares_request_msg_t * msg, Buf buffer,
 				     uint16_t protocol_version)
 {
@@ -3927,28 +4195,11 @@ _unpack_node_info_members(node_info_t * node, Buf buffer,
 		safe_unpack32(&node->node_state, buffer);
 		safe_unpackstr_xmalloc(&node->version, &uint32_tmp, buffer);
 
-		safe_unpack16(&node->cpus, buffer);
-		safe_unpack16(&node->boards, buffer);
-		safe_unpack16(&node->sockets, buffer);
-		safe_unpack16(&node->cores, buffer);
-		safe_unpack16(&node->threads, buffer);
-
-		safe_unpack32(&node->real_memory, buffer);
-		safe_unpack32(&node->tmp_disk, buffer);
-
-		safe_unpack32(&node->owner, buffer);
-		safe_unpack16(&node->core_spec_cnt, buffer);
-		safe_unpack32(&node->mem_spec_limit, buffer);
+		safe_unpack_fields(node_info_hw_15_08, node, buffer);
 		safe_unpackstr_xmalloc(&node->cpu_spec_list, &uint32_tmp,
 				       buffer);
 
-		safe_unpack32(&node->cpu_load, buffer);
-		safe_unpack32(&node->weight, buffer);
-		safe_unpack32(&node->reason_uid, buffer);
-
-		safe_unpack_time(&node->boot_time, buffer);
-		safe_unpack_time(&node->reason_time, buffer);
-		safe_unpack_time(&node->slurmd_start_time, buffer);
+		safe_unpack_fields(node_info_state_15_08, node, buffer);
 
 		select_g_select_nodeinfo_unpack(&node->select_nodeinfo, buffer,
 						protocol_version);
@@ -5724,36 +5975,7 @@ _unpack_job_info_members(job_info_t * job, Buf buffer,
 		safe_unpack32(&job->array_max_tasks, buffer);
 		_xlate_task_str(job);
 
-		safe_unpack32(&job->assoc_id, buffer);
-		safe_unpack32(&job->job_id,   buffer);
-		safe_unpack32(&job->user_id,  buffer);
-		safe_unpack32(&job->group_id, buffer);
-		safe_unpack32(&job->profile,  buffer);
-
-		safe_unpack16(&job->job_state,    buffer);
-		safe_unpack16(&job->batch_flag,   buffer);
-		safe_unpack16(&job->state_reason, buffer);
-		safe_unpack8 (&job->power_flags,  buffer);
-		safe_unpack8 (&job->reboot,       buffer);
-		safe_unpack8 (&job->sicp_mode,    buffer);
-		safe_unpack16(&job->restart_cnt,  buffer);
-		safe_unpack16(&job->show_flags,   buffer);
-
-		safe_unpack32(&job->alloc_sid,    buffer);
-		safe_unpack32(&job->time_limit,   buffer);
-		safe_unpack32(&job->time_min,     buffer);
-
-		safe_unpack16(&job->nice, buffer);
-
-		safe_unpack_time(&job->submit_time, buffer);
-		safe_unpack_time(&job->eligible_time, buffer);
-		safe_unpack_time(&job->start_time, buffer);
-		safe_unpack_time(&job->end_time, buffer);
-		safe_unpack_time(&job->suspend_time, buffer);
-		safe_unpack_time(&job->pre_sus_time, buffer);
-		safe_unpack_time(&job->resize_time, buffer);
-		safe_unpack_time(&job->preempt_time, buffer);
-		safe_unpack32(&job->priority, buffer);
+		safe_unpack_fields(job_info_state_15_08, job, buffer);
 		safe_unpackstr_xmalloc(&job->nodes, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->sched_nodes, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->partition, &uint32_tmp, buffer);
@@ -5769,15 +5991,13 @@ _unpack_job_info_members(job_info_t * job, Buf buffer,
 		safe_unpackstr_xmalloc(&job->state_desc, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->resv_name,  &uint32_tmp, buffer);
 
-		safe_unpack32(&job->exit_code, buffer);
-		safe_unpack32(&job->derived_ec, buffer);
+		safe_unpack_fields(job_info_exit_15_08, job, buffer);
 		unpack_job_resources(&job->job_resrcs, buffer,
 				     protocol_version);
 
 		safe_unpackstr_xmalloc(&job->name, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->wckey, &uint32_tmp, buffer);
-		safe_unpack32(&job->req_switch, buffer);
-		safe_unpack32(&job->wait4switch, buffer);
+		safe_unpack_fields(job_info_switch_15_08, job, buffer);
 
 		safe_unpackstr_xmalloc(&job->alloc_node, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&node_inx_str, &uint32_tmp, buffer);
@@ -5798,26 +6018,8 @@ _unpack_job_info_members(job_info_t * job, Buf buffer,
 		safe_unpackstr_xmalloc(&job->dependency, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->command,    &uint32_tmp, buffer);
 
-		safe_unpack32(&job->num_cpus, buffer);
-		safe_unpack32(&job->max_cpus, buffer);
-		safe_unpack32(&job->num_nodes,   buffer);
-		safe_unpack32(&job->max_nodes,   buffer);
-		safe_unpack16(&job->requeue,     buffer);
-		safe_unpack16(&job->ntasks_per_node, buffer);
-
-		safe_unpack16(&job->shared,        buffer);
-		safe_unpack32(&job->cpu_freq_min, buffer);
-		safe_unpack32(&job->cpu_freq_max, buffer);
-		safe_unpack32(&job->cpu_freq_gov, buffer);
-
-		/*** unpack pending job details ***/
-		safe_unpack16(&job->contiguous,    buffer);
-		safe_unpack16(&job->core_spec,     buffer);
-		safe_unpack16(&job->cpus_per_task, buffer);
-		safe_unpack16(&job->pn_min_cpus, buffer);
-
-		safe_unpack32(&job->pn_min_memory, buffer);
-		safe_unpack32(&job->pn_min_tmp_disk, buffer);
+		/* default and pending job details, packed back to back */
+		safe_unpack_fields(job_info_details_15_08, job, buffer);
 
 		safe_unpackstr_xmalloc(&job->req_nodes, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&node_inx_str, &uint32_tmp, buffer);
@@ -6180,6 +6382,7 @@ _pack_slurm_ctl_conf_msg(slurm_ctl_conf_info_msg_t * build_ptr, Buf buffer,
 		packstr(build_ptr->checkpoint_type, buffer);
 		packstr(build_ptr->chos_loc, buffer);
 		packstr(build_ptr->cluster_name, buffer);
+		packstr(build_ptr->comm_params, buffer);
 		pack16(build_ptr->complete_wait, buffer);
 		packstr(build_ptr->control_addr, buffer);
 		packstr(build_ptr->control_machine, buffer);
@@ -7020,6 +7223,8 @@ _unpack_slurm_ctl_conf_msg(slurm_ctl_conf_info_msg_t **build_buffer_ptr,
 				       &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&build_ptr->cluster_name,
 				       &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&build_ptr->comm_params,
+				       &uint32_tmp, buffer);
 		safe_unpack16(&build_ptr->complete_wait, buffer);
 		safe_unpackstr_xmalloc(&build_ptr->control_addr,
 				       &uint32_tmp, buffer);
@@ -12108,6 +12313,47 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_ping_slurmd_resp_list(ping_slurmd_resp_list_msg_t *msg,
+					Buf buffer, uint16_t protocol_version)
+{
+	xassert(msg != NULL);
+
+	if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+		packstr(msg->node_list, buffer);
+		pack32_array(msg->cpu_load, msg->node_cnt, buffer);
+	} else {
+		error("_pack_ping_slurmd_resp_list: protocol_version "
+		      "%hu not supported", protocol_version);
+	}
+}
+
+static int _unpack_ping_slurmd_resp_list(ping_slurmd_resp_list_msg_t **msg_ptr,
+					 Buf buffer,
+					 uint16_t protocol_version)
+{
+	ping_slurmd_resp_list_msg_t *msg;
+	uint32_t uint32_tmp;
+
+	xassert(msg_ptr != NULL);
+	msg = xmalloc(sizeof(ping_slurmd_resp_list_msg_t));
+	*msg_ptr = msg;
+	if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+		safe_unpackstr_xmalloc(&msg->node_list, &uint32_tmp, buffer);
+		safe_unpack32_array(&msg->cpu_load, &msg->node_cnt, buffer);
+	} else {
+		error("_unpack_ping_slurmd_resp_list: protocol_version "
+		      "%hu not supported", protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_ping_slurmd_resp_list(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 static void
 _pack_checkpoint_msg(checkpoint_msg_t *msg, Buf buffer,
 		     uint16_t protocol_version)
@@ -12656,7 +12902,27 @@ static void _pack_slurmd_status(slurmd_status_t *msg, Buf buffer,
 {
 	xassert(msg);
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+		pack_time(msg->booted, buffer);
+		pack_time(msg->last_slurmctld_msg, buffer);
+
+		pack16(msg->slurmd_debug, buffer);
+		pack16(msg->actual_cpus, buffer);
+		pack16(msg->actual_boards, buffer);
+		pack16(msg->actual_sockets, buffer);
+		pack16(msg->actual_cores, buffer);
+		pack16(msg->actual_threads, buffer);
+
+		pack32(msg->actual_real_mem, buffer);
+		pack32(msg->actual_tmp_disk, buffer);
+		pack32(msg->pid, buffer);
+
+		packstr(msg->hostname, buffer);
+		packstr(msg->script_stats, buffer);
+		packstr(msg->slurmd_logfile, buffer);
+		packstr(msg->step_list, buffer);
+		packstr(msg->version, buffer);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack_time(msg->booted, buffer);
 		pack_time(msg->last_slurmctld_msg, buffer);
 
@@ -12691,7 +12957,32 @@ static int _unpack_slurmd_status(slurmd_status_t **msg_ptr, Buf buffer,
 
 	msg = xmalloc(sizeof(slurmd_status_t));
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+		safe_unpack_time(&msg->booted, buffer);
+		safe_unpack_time(&msg->last_slurmctld_msg, buffer);
+
+		safe_unpack16(&msg->slurmd_debug, buffer);
+		safe_unpack16(&msg->actual_cpus, buffer);
+		safe_unpack16(&msg->actual_boards, buffer);
+		safe_unpack16(&msg->actual_sockets, buffer);
+		safe_unpack16(&msg->actual_cores, buffer);
+		safe_unpack16(&msg->actual_threads, buffer);
+
+		safe_unpack32(&msg->actual_real_mem, buffer);
+		safe_unpack32(&msg->actual_tmp_disk, buffer);
+		safe_unpack32(&msg->pid, buffer);
+
+		safe_unpackstr_xmalloc(&msg->hostname,
+					&uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->script_stats,
+					&uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->slurmd_logfile,
+					&uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->step_list,
+					&uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->version,
+					&uint32_tmp, buffer);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack_time(&msg->booted, buffer);
 		safe_unpack_time(&msg->last_slurmctld_msg, buffer);
 
@@ -13199,6 +13490,24 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 		safe_unpack32_array(&msg->rpc_user_id,   &uint32_tmp, buffer);
 		safe_unpack32_array(&msg->rpc_user_cnt,  &uint32_tmp, buffer);
 		safe_unpack64_array(&msg->rpc_user_time, &uint32_tmp, buffer);
+
+		if (protocol_version >= SLURM_15_08_PROTOCOL_VERSION) {
+			safe_unpack32(&msg->auth_create_cnt,	buffer);
+			safe_unpack64(&msg->auth_create_time,	buffer);
+			safe_unpack32(&msg->auth_verify_cnt,	buffer);
+			safe_unpack64(&msg->auth_verify_time,	buffer);
+			safe_unpack32(&msg->auth_verify_max,	buffer);
+			safe_unpack32(&msg->auth_session_cnt,	buffer);
+
+			safe_unpackstr_array(&msg->msg_aggr_addr,
+					     &msg->msg_aggr_size, buffer);
+			safe_unpack32_array(&msg->msg_aggr_batch_cnt,
+					    &uint32_tmp, buffer);
+			safe_unpack32_array(&msg->msg_aggr_msg_cnt,
+					    &uint32_tmp, buffer);
+			safe_unpack32_array(&msg->msg_aggr_batch_max,
+					    &uint32_tmp, buffer);
+		}
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&msg->parts_packed,	buffer);
 		if (msg->parts_packed) {
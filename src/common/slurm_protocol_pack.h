@@ -77,6 +77,17 @@ extern void pack_header ( header_t  * header , Buf buffer );
  */
 extern int unpack_header ( header_t * header , Buf buffer );
 
+/* peek_header_msg_type
+ * get the message type from a slurm protocol header without unpacking the
+ *	rest of the message
+ * OUT msg_type - type of the message
+ * IN data - packed message, starting with its header
+ * IN size - bytes in data
+ * RET 0 or error code
+ */
+extern int peek_header_msg_type(uint16_t *msg_type, char *data,
+				uint32_t size);
+
 
 /**************************************************************************/
 /* generic case statement Pack / Unpack methods for slurm protocol bodies */
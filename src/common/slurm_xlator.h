@@ -236,6 +236,7 @@
 #define grow_buf		slurm_grow_buf
 #define	init_buf		slurm_init_buf
 #define	xfer_buf_data		slurm_xfer_buf_data
+#define	try_grow_buf_remaining	slurm_try_grow_buf_remaining
 #define	pack_time		slurm_pack_time
 #define	unpack_time		slurm_unpack_time
 #define	packdouble		slurm_packdouble
@@ -50,10 +50,13 @@
 #endif				/*  HAVE_CONFIG_H */
 
 #include <arpa/inet.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <syslog.h>
+#include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -71,6 +74,7 @@
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/slurmdbd_defs.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xsignal.h"
 #include "src/common/xstring.h"
@@ -85,10 +89,19 @@ strong_alias(slurmdbd_free_usage_msg,	slurmdb_slurmdbd_free_usage_msg);
 strong_alias(slurmdbd_free_id_rc_msg,	slurmdb_slurmdbd_free_id_rc_msg);
 
 
+#define DBD_AGENT_BATCH		1000	/* Messages per DBD_SEND_MULT_MSG */
+#define DBD_AGENT_WINDOW	4	/* DBD_SEND_MULT_MSG sent before
+					 * waiting for the replies */
+#define DBD_JOURNAL_ACKED	0xDEAD321B	/* record processed by slurmdbd */
+#define DBD_JOURNAL_MAGIC	0xDEAD321A	/* record waiting for slurmdbd */
+#define DBD_JOURNAL_MAX_SEGS	64
+#define DBD_JOURNAL_SEG_MAGIC	0xDEAD321C
+#define DBD_JOURNAL_SEG_SIZE	(4 * 1024 * 1024)
 #define DBD_MAGIC		0xDEAD3219
 #define MAX_AGENT_QUEUE		10000
 #define MAX_DBD_MSG_LEN		16384
 #define SLURMDBD_TIMEOUT	900	/* Seconds SlurmDBD for response */
+#define SLURMDBD_WRITE_TIMEOUT	5	/* Seconds to wait to write a request */
 
 uint16_t running_cache = 0;
 pthread_mutex_t assoc_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -111,13 +124,91 @@ static slurm_trigger_callbacks_t callback;
 static bool      callbacks_requested = 0;
 static bool      from_ctld           = 0;
 static bool      need_to_register    = 0;
+static uint16_t  slurmdbd_rpc_version = 0; /* 0 if slurmdbd predates
+					    * reporting it on DBD_INIT */
+
+/* One DBD_SEND_MULT_MSG sent by the agent. The messages in my_list stay
+ * on agent_list until slurmdbd acknowledges them. */
+typedef struct {
+	Buf buffer;	/* packed DBD_SEND_MULT_MSG */
+	List my_list;	/* agent_list buffers packed into it */
+} dbd_agent_batch_t;
+
+/* The agent queue is journaled as it is filled to dbd.journal.<id> files
+ * in StateSaveLocation. Each segment file is mapped, starts with a
+ * dbd_journal_hdr_t and holds dbd_journal_rec_t records, each followed by
+ * a packed message and aligned to 8 bytes. Records are marked when
+ * slurmdbd acknowledges them and a segment is removed once all of its
+ * records are. Queued messages point into the mapping, so a long slurmdbd
+ * outage costs page cache rather than slurmctld memory. */
+typedef struct {
+	uint32_t magic;		/* DBD_JOURNAL_SEG_MAGIC */
+	uint16_t rpc_version;	/* protocol version of the records */
+	uint16_t pad;
+} dbd_journal_hdr_t;
+
+typedef struct {
+	uint32_t magic;		/* DBD_JOURNAL_MAGIC, DBD_JOURNAL_ACKED or
+				 * zero past the last record */
+	uint32_t size;		/* size of the packed message */
+} dbd_journal_rec_t;
+
+#define DBD_JOURNAL_REC_LEN(_size) \
+	((sizeof(dbd_journal_rec_t) + (_size) + 7) & ~((uint32_t) 7))
+
+typedef struct {
+	char *data;		/* MAP_SHARED mapping of the whole file */
+	uint32_t id;
+	uint32_t live;		/* records not acknowledged yet */
+	uint16_t rpc_version;
+	uint32_t size;
+	uint32_t used;		/* bytes of records, appends go after */
+} dbd_journal_seg_t;
+
+static dbd_journal_seg_t *journal_active = NULL; /* segment appended to */
+static char *    journal_dir         = NULL;
+static uint32_t  journal_next_id     = 0;
+static List      journal_segs        = NULL; /* dbd_journal_seg_t, oldest
+						  * first, NULL if the queue
+						  * is not journaled */
+
+/* A record of an older protocol version replayed from the journal. It
+ * stays live until the message repacked from it is journaled, saved or
+ * processed, so that a crash in between does not lose the message. */
+typedef struct {
+	Buf buffer;		/* repacked message on agent_list */
+	dbd_journal_seg_t *seg;
+	dbd_journal_rec_t *rec;
+} dbd_journal_stale_t;
+
+static List      journal_stale       = NULL; /* dbd_journal_stale_t */
+
+/* Last DBD_JOB_START in the agent window for one job record */
+typedef struct {
+	Buf buffer;
+	char *key;
+} dbd_job_start_key_t;
 
+static void   _ack_agent_msgs(List acked_list);
 static void * _agent(void *x);
+static List   _build_agent_batches(int window);
 static void   _close_slurmdbd_fd(void);
 static void   _create_agent(void);
 static bool   _fd_readable(slurm_fd_t fd, int read_timeout);
-static int    _fd_writeable(slurm_fd_t fd);
+static void   _free_agent_buf(void *x);
+static int    _fd_writeable(slurm_fd_t fd, int write_timeout);
 static int    _get_return_code(uint16_t rpc_version, int read_timeout);
+static int    _handle_mult_rc_ret(uint16_t rpc_version, Buf buffer,
+				  List sent_list, List acked_list);
+static char * _job_start_key(Buf buffer);
+static int    _agent_unjournaled_cnt(void);
+static int    _journal_append(Buf buffer);
+static void   _journal_close(void);
+static void   _journal_open(void);
+static bool   _journal_queue(void);
+static void   _journal_release(Buf buffer);
+static dbd_journal_seg_t *_journal_seg_find(Buf buffer);
+static void   _journal_stale_release(Buf buffer);
 static Buf    _load_dbd_rec(int fd);
 static void   _load_dbd_state(void);
 static void   _open_slurmdbd_fd(bool db_needed);
@@ -125,15 +216,18 @@ static int    _purge_job_start_req(void);
 static Buf    _recv_msg(int read_timeout);
 static void   _reopen_slurmdbd_fd(void);
 static int    _save_dbd_rec(int fd, Buf buffer);
+static int    _send_agent_batches(List batch_list, int read_timeout);
 static void   _save_dbd_state(void);
 static int    _send_init_msg(void);
 static int    _send_fini_msg(void);
 static int    _send_msg(Buf buffer);
+static int    _write_msg(Buf buffer, int write_timeout);
 static void   _sig_handler(int signal);
 static void   _shutdown_agent(void);
 static void   _slurmdbd_packstr(void *str, uint16_t rpc_version, Buf buffer);
 static int    _slurmdbd_unpackstr(void **str, uint16_t rpc_version, Buf buffer);
 static int    _tot_wait (struct timeval *start_time);
+static int    _unpack_return_code(uint16_t rpc_version, Buf buffer);
 
 /****************************************************************************
  * Socket open/close/read/write functions
@@ -384,7 +478,13 @@ extern int slurm_send_slurmdbd_msg(uint16_t rpc_version, slurmdbd_msg_t *req)
 		if (callbacks_requested)
 			(callback.dbd_fail)();
 	}
-	if (cnt == (max_agent_queue - 1))
+	/* A journaled message is queued however long the queue is, only a
+	 * full journal limits it. Registration messages are not kept, see
+	 * _save_dbd_state(). */
+	if (journal_segs && (req->msg_type != DBD_REGISTER_CTLD) &&
+	    (_journal_append(buffer) == SLURM_SUCCESS))
+		cnt = 0;
+	else if ((cnt = _agent_unjournaled_cnt()) >= (max_agent_queue - 1))
 		cnt -= _purge_job_start_req();
 	if (cnt < max_agent_queue) {
 		if (list_enqueue(agent_list, buffer) == NULL)
@@ -546,6 +646,7 @@ extern Buf pack_slurmdbd_msg(slurmdbd_msg_t *req, uint16_t rpc_version)
 	case DBD_GET_CLUSTERS:
 	case DBD_GET_EVENTS:
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_PAGED:
 	case DBD_GET_PROBS:
 	case DBD_GET_QOS:
 	case DBD_GET_RESVS:
@@ -651,6 +752,7 @@ extern Buf pack_slurmdbd_msg(slurmdbd_msg_t *req, uint16_t rpc_version)
 	case DBD_GET_CONFIG:
 		packstr((char *)req->data, buffer);
 		break;
+	case DBD_GET_JOBS_NEXT:
 	case DBD_RECONFIG:
 		break;
 	default:
@@ -731,6 +833,7 @@ extern int unpack_slurmdbd_msg(slurmdbd_msg_t *resp,
 	case DBD_GET_CLUSTERS:
 	case DBD_GET_EVENTS:
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_PAGED:
 	case DBD_GET_PROBS:
 	case DBD_GET_QOS:
 	case DBD_GET_RESVS:
@@ -840,6 +943,7 @@ extern int unpack_slurmdbd_msg(slurmdbd_msg_t *resp,
 		break;
 	case DBD_GET_CONFIG:
 		/* (handled in src/slurmdbd/proc_req.c) */
+	case DBD_GET_JOBS_NEXT:
 	case DBD_RECONFIG:
 		/* No message to unpack */
 		break;
@@ -979,6 +1083,10 @@ extern slurmdbd_msg_type_t str_2_slurmdbd_msg_type(char *msg_type)
 		return DBD_STEP_START;
 	} else if (!strcasecmp(msg_type, "Get Jobs Conditional")) {
 		return DBD_GET_JOBS_COND;
+	} else if (!strcasecmp(msg_type, "Get Jobs Paged")) {
+		return DBD_GET_JOBS_PAGED;
+	} else if (!strcasecmp(msg_type, "Get Jobs Next")) {
+		return DBD_GET_JOBS_NEXT;
 	} else if (!strcasecmp(msg_type, "Get Transations")) {
 		return DBD_GET_TXN;
 	} else if (!strcasecmp(msg_type, "Got Transations")) {
@@ -1395,6 +1503,18 @@ extern char *slurmdbd_msg_type_2_str(slurmdbd_msg_type_t msg_type, int get_enum)
 		} else
 			return "Get Jobs Conditional";
 		break;
+	case DBD_GET_JOBS_PAGED:
+		if (get_enum) {
+			return "DBD_GET_JOBS_PAGED";
+		} else
+			return "Get Jobs Paged";
+		break;
+	case DBD_GET_JOBS_NEXT:
+		if (get_enum) {
+			return "DBD_GET_JOBS_NEXT";
+		} else
+			return "Get Jobs Next";
+		break;
 	case DBD_GET_TXN:
 		if (get_enum) {
 			return "DBD_GET_TXN";
@@ -1587,7 +1707,17 @@ static int _send_init_msg()
 	   same rate and not leave any time to send the response back.
 	*/
 	read_timeout = (slurm_get_msg_timeout() + 35) * 1000;
-	rc = _get_return_code(SLURM_PROTOCOL_VERSION, read_timeout);
+	slurmdbd_rpc_version = 0;
+	if ((buffer = _recv_msg(read_timeout))) {
+		rc = _unpack_return_code(SLURM_PROTOCOL_VERSION, buffer);
+		/* A slurmdbd able to read pipelined requests follows the
+		 * reply with its own version, see _send_agent_batches() */
+		if ((rc == SLURM_SUCCESS) &&
+		    (remaining_buf(buffer) >= sizeof(uint16_t)))
+			unpack16(&slurmdbd_rpc_version, buffer);
+		free_buf(buffer);
+	} else
+		rc = SLURM_ERROR;
 	if (tmp_errno)
 		errno = tmp_errno;
 	else if (rc != SLURM_SUCCESS)
@@ -1602,7 +1732,7 @@ static int _send_fini_msg(void)
 
 	/* If the connection is already gone, we don't need to send a
 	   fini. */
-	if (_fd_writeable(slurmdbd_fd) == -1)
+	if (_fd_writeable(slurmdbd_fd, SLURMDBD_WRITE_TIMEOUT * 1000) == -1)
 		return SLURM_SUCCESS;
 
 	buffer = init_buf(1024);
@@ -1636,17 +1766,14 @@ static void _reopen_slurmdbd_fd(void)
 
 static int _send_msg(Buf buffer)
 {
-	uint32_t msg_size, nw_size;
-	char *msg;
-	ssize_t msg_wrote;
 	int rc, retry_cnt = 0;
 
 	if (slurmdbd_fd < 0)
 		return EAGAIN;
 
-	rc =_fd_writeable(slurmdbd_fd);
-	if (rc == -1) {
-	re_open:	/* SlurmDBD shutdown, try to reopen a connection now */
+	while ((rc = _write_msg(buffer, SLURMDBD_WRITE_TIMEOUT * 1000)) == -1) {
+		/* SlurmDBD shutdown, try to reopen a connection now and
+		 * send the whole message again on it */
 		if (retry_cnt++ > 3)
 			return EAGAIN;
 		/* if errno is ACCESS_DENIED do not try to reopen to
@@ -1654,10 +1781,25 @@ static int _send_msg(Buf buffer)
 		if (errno == ESLURM_ACCESS_DENIED)
 			return ESLURM_ACCESS_DENIED;
 		_reopen_slurmdbd_fd();
-		rc = _fd_writeable(slurmdbd_fd);
+		if (slurmdbd_fd < 0)
+			return EAGAIN;
 	}
+
+	return rc;
+}
+
+/* Write a message and its length to slurmdbd_fd without reopening it
+ * RET SLURM_SUCCESS, EAGAIN, or -1 if the connection has been closed */
+static int _write_msg(Buf buffer, int write_timeout)
+{
+	uint32_t msg_size, nw_size;
+	char *msg;
+	ssize_t msg_wrote;
+	int rc;
+
+	rc = _fd_writeable(slurmdbd_fd, write_timeout);
 	if (rc < 1)
-		return EAGAIN;
+		return (rc == -1) ? -1 : EAGAIN;
 
 	msg_size = get_buf_offset(buffer);
 	nw_size = htonl(msg_size);
@@ -1667,11 +1809,9 @@ static int _send_msg(Buf buffer)
 
 	msg = get_buf_data(buffer);
 	while (msg_size > 0) {
-		rc = _fd_writeable(slurmdbd_fd);
-		if (rc == -1)
-			goto re_open;
+		rc = _fd_writeable(slurmdbd_fd, write_timeout);
 		if (rc < 1)
-			return EAGAIN;
+			return (rc == -1) ? -1 : EAGAIN;
 		msg_wrote = write(slurmdbd_fd, msg, msg_size);
 		if (msg_wrote <= 0)
 			return EAGAIN;
@@ -1757,18 +1897,17 @@ static int _get_return_code(uint16_t rpc_version, int read_timeout)
 	return rc;
 }
 
-static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout)
+/* Process the reply to a DBD_SEND_MULT_MSG. The messages of sent_list that
+ * slurmdbd processed successfully are appended to acked_list. */
+static int _handle_mult_rc_ret(uint16_t rpc_version, Buf buffer,
+			       List sent_list, List acked_list)
 {
-	Buf buffer;
 	uint16_t msg_type;
 	dbd_rc_msg_t *msg;
 	dbd_list_msg_t *list_msg;
+	ListIterator itr, sent_itr;
 	int rc = SLURM_ERROR;
-	Buf out_buf = NULL;
-
-	buffer = _recv_msg(read_timeout);
-	if (buffer == NULL)
-		return rc;
+	Buf b, out_buf = NULL;
 
 	safe_unpack16(&msg_type, buffer);
 	switch(msg_type) {
@@ -1780,27 +1919,22 @@ static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout)
 			break;
 		}
 
-		slurm_mutex_lock(&agent_lock);
-		if (agent_list) {
-			ListIterator itr =
-				list_iterator_create(list_msg->my_list);
-			while ((out_buf = list_next(itr))) {
-				Buf b;
-				if ((rc = _unpack_return_code(
-					    rpc_version, out_buf))
-				    != SLURM_SUCCESS)
-					break;
+		itr = list_iterator_create(list_msg->my_list);
+		sent_itr = list_iterator_create(sent_list);
+		while ((out_buf = list_next(itr))) {
+			if ((rc = _unpack_return_code(rpc_version, out_buf))
+			    != SLURM_SUCCESS)
+				break;
 
-				if ((b = list_dequeue(agent_list))) {
-					free_buf(b);
-				} else {
-					error("slurmdbd: DBD_GOT_MULT_MSG "
-					      "unpack message error");
-				}
+			if ((b = list_next(sent_itr))) {
+				list_append(acked_list, b);
+			} else {
+				error("slurmdbd: DBD_GOT_MULT_MSG "
+				      "unpack message error");
 			}
-			list_iterator_destroy(itr);
 		}
-		slurm_mutex_unlock(&agent_lock);
+		list_iterator_destroy(sent_itr);
+		list_iterator_destroy(itr);
 		slurmdbd_free_list_msg(list_msg);
 		break;
 	case DBD_RC:
@@ -1841,7 +1975,6 @@ static int _handle_mult_rc_ret(uint16_t rpc_version, int read_timeout)
 	}
 
 unpack_error:
-	free_buf(buffer);
 	return rc;
 }
 
@@ -1955,13 +2088,12 @@ static bool _fd_readable(slurm_fd_t fd, int read_timeout)
 
 /* Wait until a file is writeable,
  * RET 1 if file can be written now,
- *     0 if can not be written to within 5 seconds
+ *     0 if can not be written to within write_timeout msec
  *     -1 if file has been closed POLLHUP
  */
-static int _fd_writeable(slurm_fd_t fd)
+static int _fd_writeable(slurm_fd_t fd, int write_timeout)
 {
 	struct pollfd ufds;
-	int write_timeout = 5000;
 	int rc, time_left;
 	struct timeval tstart;
 	char temp[2];
@@ -1985,9 +2117,11 @@ static int _fd_writeable(slurm_fd_t fd)
 		 * If not then exit out and notify the sender.  This
  		 * is here since a write doesn't always tell you the
 		 * socket is gone, but getting 0 back from a
-		 * nonblocking read means just that.
+		 * nonblocking read means just that. Only peek, the agent
+		 * may have replies pending on the connection.
 		 */
-		if (ufds.revents & POLLHUP || (recv(fd, &temp, 1, 0) == 0)) {
+		if (ufds.revents & POLLHUP ||
+		    (recv(fd, &temp, 1, MSG_PEEK) == 0)) {
 			debug2("SlurmDBD connection is closed");
 			if (callbacks_requested)
 				(callback.dbd_fail)();
@@ -2025,8 +2159,17 @@ static void _create_agent(void)
 	agent_shutdown = 0;
 
 	if (agent_list == NULL) {
-		agent_list = list_create(slurmdbd_free_buffer);
+		agent_list = list_create(_free_agent_buf);
+		_journal_open();
 		_load_dbd_state();
+		/* Once the messages recovered from dbd.messages are
+		 * journaled they must not be recovered from there again */
+		if (journal_segs && _journal_queue()) {
+			char *dbd_fname = slurm_get_state_save_location();
+			xstrcat(dbd_fname, "/dbd.messages");
+			(void) unlink(dbd_fname);
+			xfree(dbd_fname);
+		}
 	}
 
 	if (agent_tid == 0) {
@@ -2080,20 +2223,263 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _free_agent_batch(void *x)
+{
+	dbd_agent_batch_t *batch = (dbd_agent_batch_t *) x;
+
+	if (batch) {
+		if (batch->buffer)
+			free_buf(batch->buffer);
+		FREE_NULL_LIST(batch->my_list);
+		xfree(batch);
+	}
+}
+
+static const char *_job_start_key_id(void *x)
+{
+	return ((dbd_job_start_key_t *) x)->key;
+}
+
+static void _job_start_key_free(void *x)
+{
+	dbd_job_start_key_t *key_ptr = (dbd_job_start_key_t *) x;
+
+	xfree(key_ptr->key);
+	xfree(key_ptr);
+}
+
+/* Return a key for the job record a queued DBD_JOB_START updates, or NULL
+ * if the buffer holds some other message or a job without a db_index.
+ * Two such messages with the same key write the same columns of the same
+ * row, so only the later one needs to be sent. */
+static char *_job_start_key(Buf buffer)
+{
+	dbd_job_start_msg_t *req = NULL;
+	uint32_t offset;
+	uint16_t msg_type;
+	char *key = NULL;
+
+	offset = get_buf_offset(buffer);
+	if (offset < 2)
+		return NULL;
+	set_buf_offset(buffer, 0);
+	unpack16(&msg_type, buffer);
+	if ((msg_type == DBD_JOB_START) &&
+	    (slurmdbd_unpack_job_start_msg((void **) &req,
+					   SLURM_PROTOCOL_VERSION, buffer)
+	     == SLURM_SUCCESS) &&
+	    req->db_index && (req->db_index != NO_VAL)) {
+		key = xstrdup_printf("%u.%u.%ld.%ld", req->job_id,
+				     req->db_index, (long) req->submit_time,
+				     (long) req->start_time);
+	}
+	slurmdbd_free_job_start_msg(req);
+	set_buf_offset(buffer, offset);
+
+	return key;
+}
+
+/* Pack the messages at the head of agent_list into up to window
+ * DBD_SEND_MULT_MSG of DBD_AGENT_BATCH messages each. The messages stay on
+ * agent_list until acknowledged. A DBD_JOB_START followed by a later one
+ * for the same job record in the window is dropped from the queue.
+ * NOTE: Call with agent_lock locked.
+ * RET List of dbd_agent_batch_t */
+static List _build_agent_batches(int window)
+{
+	dbd_job_start_key_t **keys, *key_ptr;
+	dbd_agent_batch_t *batch = NULL;
+	slurmdbd_msg_t list_req;
+	dbd_list_msg_t list_msg;
+	List batch_list;
+	ListIterator itr;
+	xhash_t *key_hash;
+	int cnt, i, coalesced = 0;
+	Buf buffer;
+	char *key;
+
+	batch_list = list_create(_free_agent_batch);
+	cnt = MIN(list_count(agent_list), window * DBD_AGENT_BATCH);
+	if (cnt == 0)
+		return batch_list;
+
+	/* Find the last DBD_JOB_START of each job record in the window */
+	keys = xmalloc(sizeof(dbd_job_start_key_t *) * cnt);
+	key_hash = xhash_init(_job_start_key_id, _job_start_key_free, NULL, 0);
+	itr = list_iterator_create(agent_list);
+	for (i = 0; (i < cnt) && (buffer = list_next(itr)); i++) {
+		if (!(key = _job_start_key(buffer)))
+			continue;
+		if ((key_ptr = xhash_get(key_hash, key))) {
+			xfree(key);
+		} else {
+			key_ptr = xmalloc(sizeof(dbd_job_start_key_t));
+			key_ptr->key = key;
+			xhash_add(key_hash, key_ptr);
+		}
+		key_ptr->buffer = buffer;
+		keys[i] = key_ptr;
+	}
+
+	list_iterator_reset(itr);
+	for (i = 0; (i < cnt) && (buffer = list_next(itr)); i++) {
+		if (keys[i] && (keys[i]->buffer != buffer)) {
+			_journal_release(buffer);
+			list_delete_item(itr);
+			coalesced++;
+			continue;
+		}
+		if (!batch || (list_count(batch->my_list) >= DBD_AGENT_BATCH)) {
+			batch = xmalloc(sizeof(dbd_agent_batch_t));
+			batch->my_list = list_create(NULL);
+			list_append(batch_list, batch);
+		}
+		list_append(batch->my_list, buffer);
+	}
+	list_iterator_destroy(itr);
+	xhash_free(key_hash);
+	xfree(keys);
+	if (coalesced)
+		debug("slurmdbd: dropped %d superseded DBD_JOB_START requests",
+		      coalesced);
+
+	list_req.msg_type = DBD_SEND_MULT_MSG;
+	list_req.data = &list_msg;
+	memset(&list_msg, 0, sizeof(dbd_list_msg_t));
+	itr = list_iterator_create(batch_list);
+	while ((batch = list_next(itr))) {
+		list_msg.my_list = batch->my_list;
+		batch->buffer = pack_slurmdbd_msg(&list_req,
+						  SLURM_PROTOCOL_VERSION);
+	}
+	list_iterator_destroy(itr);
+
+	return batch_list;
+}
+
+static int _buf_ptr_cmp(const void *x, const void *y)
+{
+	uintptr_t a = (uintptr_t) *(Buf *) x;
+	uintptr_t b = (uintptr_t) *(Buf *) y;
+
+	if (a < b)
+		return -1;
+	return (a > b);
+}
+
+/* Remove the messages in acked_list, which slurmdbd has processed, from
+ * agent_list.
+ * NOTE: Call with agent_lock locked. */
+static void _ack_agent_msgs(List acked_list)
+{
+	int cnt, i, removed = 0;
+	ListIterator itr;
+	Buf *acked, buffer;
+
+	cnt = list_count(acked_list);
+	if (!agent_list || (cnt == 0))
+		return;
+
+	acked = xmalloc(sizeof(Buf) * cnt);
+	itr = list_iterator_create(acked_list);
+	for (i = 0; (buffer = list_next(itr)); i++)
+		acked[i] = buffer;
+	list_iterator_destroy(itr);
+	qsort(acked, cnt, sizeof(Buf), _buf_ptr_cmp);
+
+	/* The batches came from the head of the queue, so this normally
+	 * stops well before the end of it */
+	itr = list_iterator_create(agent_list);
+	while ((removed < cnt) && (buffer = list_next(itr))) {
+		if (bsearch(&buffer, acked, cnt, sizeof(Buf), _buf_ptr_cmp)) {
+			_journal_release(buffer);
+			list_delete_item(itr);
+			removed++;
+		}
+	}
+	list_iterator_destroy(itr);
+	xfree(acked);
+}
+
+/* Send all batches of batch_list before reading any reply. slurmdbd works
+ * through the requests of a connection in order, so the replies come back
+ * in the order the batches were sent. Only the first batch may reopen the
+ * connection, the others must go to the same slurmdbd as the ones before
+ * them and are only sent if it reported its version on DBD_INIT, older
+ * ones could not read pipelined requests. Behind the earlier batches they
+ * may wait on slurmdbd as long as a reply would.
+ * NOTE: Call with slurmdbd_lock locked and agent_lock unlocked. */
+static int _send_agent_batches(List batch_list, int read_timeout)
+{
+	dbd_agent_batch_t *batch;
+	List acked_list;
+	ListIterator itr;
+	int rc, send_rc = SLURM_SUCCESS, sent = 0, replied = 0;
+	Buf buffer;
+
+	itr = list_iterator_create(batch_list);
+	while ((batch = list_next(itr))) {
+		if (sent == 0) {
+			send_rc = _send_msg(batch->buffer);
+		} else if (!slurmdbd_rpc_version) {
+			break;
+		} else {
+			send_rc = _write_msg(batch->buffer, read_timeout);
+			if (send_rc == -1)
+				send_rc = EAGAIN;
+		}
+		if (send_rc != SLURM_SUCCESS) {
+			if (!agent_shutdown)
+				error("slurmdbd: Failure sending message: "
+				      "%d: %m", send_rc);
+			break;
+		}
+		sent++;
+	}
+	rc = send_rc;
+
+	/* The batches sent all went out on this connection, so their
+	 * replies still come back in order even if a later send failed.
+	 * Should the connection be gone, no reply is read. */
+	acked_list = list_create(NULL);
+	list_iterator_reset(itr);
+	while ((replied < sent) && (batch = list_next(itr))) {
+		if (!(buffer = _recv_msg(read_timeout))) {
+			rc = SLURM_ERROR;
+			break;
+		}
+		replied++;
+		if (_handle_mult_rc_ret(SLURM_PROTOCOL_VERSION, buffer,
+					batch->my_list, acked_list)
+		    != SLURM_SUCCESS)
+			rc = SLURM_ERROR;
+		free_buf(buffer);
+	}
+	list_iterator_destroy(itr);
+
+	/* An unread reply, or the rest of a partly written batch, would
+	 * put the connection out of step, start over on a new one. */
+	if ((replied < sent) || (send_rc != SLURM_SUCCESS))
+		_close_slurmdbd_fd();
+
+	slurm_mutex_lock(&agent_lock);
+	_ack_agent_msgs(acked_list);
+	slurm_mutex_unlock(&agent_lock);
+	list_destroy(acked_list);
+
+	return rc;
+}
+
 static void *_agent(void *x)
 {
 	int cnt, rc;
 	Buf buffer;
+	List batch_list;
 	struct timespec abs_time;
 	static time_t fail_time = 0;
 	int sigarray[] = {SIGUSR1, 0};
 	int read_timeout = SLURMDBD_TIMEOUT * 1000;
-	slurmdbd_msg_t list_req;
-	dbd_list_msg_t list_msg;
 
-	list_req.msg_type = DBD_SEND_MULT_MSG;
-	list_req.data = &list_msg;
-	memset(&list_msg, 0, sizeof(dbd_list_msg_t));
 	/* DEF_TIMERS; */
 
 	/* Prepare to catch SIGUSR1 to interrupt pending
@@ -2131,33 +2517,16 @@ static void *_agent(void *x)
 			continue;
 		} else if ((cnt > 0) && ((cnt % 50) == 0))
 			info("slurmdbd: agent queue size %u", cnt);
-		/* Leave item on the queue until processing complete */
-		if (agent_list) {
-			int handle_agent_count = 1000;
-			if (cnt > handle_agent_count) {
-				int agent_count = 0;
-				ListIterator agent_itr =
-					list_iterator_create(agent_list);
-				list_msg.my_list = list_create(NULL);
-				while ((buffer = list_next(agent_itr))) {
-					list_enqueue(list_msg.my_list, buffer);
-					agent_count++;
-					if (agent_count > handle_agent_count)
-						break;
-				}
-				list_iterator_destroy(agent_itr);
-				buffer = pack_slurmdbd_msg(
-					&list_req, SLURM_PROTOCOL_VERSION);
-			} else if (cnt > 1) {
-				list_msg.my_list = agent_list;
-				buffer = pack_slurmdbd_msg(
-					&list_req, SLURM_PROTOCOL_VERSION);
-			} else
-				buffer = (Buf) list_peek(agent_list);
-		} else
-			buffer = NULL;
+		/* Leave items on the queue until processing complete */
+		batch_list = NULL;
+		buffer = NULL;
+		if (agent_list && (cnt > 1))
+			batch_list = _build_agent_batches(
+				slurmdbd_rpc_version ? DBD_AGENT_WINDOW : 1);
+		else if (agent_list)
+			buffer = (Buf) list_peek(agent_list);
 		slurm_mutex_unlock(&agent_lock);
-		if (buffer == NULL) {
+		if ((buffer == NULL) && (batch_list == NULL)) {
 			slurm_mutex_unlock(&slurmdbd_lock);
 
 			slurm_mutex_lock(&assoc_cache_mutex);
@@ -2171,16 +2540,19 @@ static void *_agent(void *x)
 		/* NOTE: agent_lock is clear here, so we can add more
 		 * requests to the queue while waiting for this RPC to
 		 * complete. */
-		rc = _send_msg(buffer);
-		if (rc != SLURM_SUCCESS) {
+		if (batch_list) {
+			rc = _send_agent_batches(batch_list, read_timeout);
+			if ((rc != SLURM_SUCCESS) && agent_shutdown) {
+				list_destroy(batch_list);
+				slurm_mutex_unlock(&slurmdbd_lock);
+				break;
+			}
+		} else if ((rc = _send_msg(buffer)) != SLURM_SUCCESS) {
 			if (agent_shutdown) {
 				slurm_mutex_unlock(&slurmdbd_lock);
 				break;
 			}
 			error("slurmdbd: Failure sending message: %d: %m", rc);
-		} else if (list_msg.my_list) {
-			rc = _handle_mult_rc_ret(SLURM_PROTOCOL_VERSION,
-						 read_timeout);
 		} else {
 			rc = _get_return_code(SLURM_PROTOCOL_VERSION,
 					      read_timeout);
@@ -2200,34 +2572,20 @@ static void *_agent(void *x)
 		slurm_mutex_unlock(&assoc_cache_mutex);
 
 		slurm_mutex_lock(&agent_lock);
-		if (agent_list && (rc == SLURM_SUCCESS)) {
-			/* If we sent a mult_msg we just need to free
-			   buffer, we don't need to requeue, just mark
-			   list_msg.my_list as NULL as that is the
-			   sign we sent a mult_msg.
-			*/
-			if (list_msg.my_list) {
-				if (list_msg.my_list != agent_list)
-					list_destroy(list_msg.my_list);
-				list_msg.my_list = NULL;
-			} else
-				buffer = (Buf) list_dequeue(agent_list);
-
-			free_buf(buffer);
+		if (batch_list) {
+			/* Acknowledged messages are already off the queue */
+			list_destroy(batch_list);
+			if (rc == SLURM_SUCCESS)
+				fail_time = 0;
+			else
+				fail_time = time(NULL);
+		} else if (agent_list && (rc == SLURM_SUCCESS)) {
+			buffer = (Buf) list_dequeue(agent_list);
+			_journal_release(buffer);
+			_free_agent_buf(buffer);
 			fail_time = 0;
-		} else {
-			/* We still need to free a mult_msg even if we
-			   got a failure.
-			*/
-			if (list_msg.my_list) {
-				if (list_msg.my_list != agent_list)
-					list_destroy(list_msg.my_list);
-				list_msg.my_list = NULL;
-				free_buf(buffer);
-			}
-
+		} else
 			fail_time = time(NULL);
-		}
 		slurm_mutex_unlock(&agent_lock);
 		/* END_TIMER; */
 		/* info("at the end with %s", TIME_STR); */
@@ -2248,15 +2606,470 @@ static void *_agent(void *x)
 		list_destroy(agent_list);
 		agent_list = NULL;
 	}
+	_journal_close();
 	slurm_mutex_unlock(&agent_lock);
 	return NULL;
 }
 
+static char *_journal_seg_name(uint32_t id)
+{
+	return xstrdup_printf("%s/dbd.journal.%u", journal_dir, id);
+}
+
+static void _journal_seg_free(dbd_journal_seg_t *seg, bool remove)
+{
+	char *fname;
+
+	if (seg->data)
+		(void) munmap(seg->data, seg->size);
+	if (remove) {
+		fname = _journal_seg_name(seg->id);
+		if (unlink(fname) && (errno != ENOENT))
+			error("slurmdbd: unlink(%s): %m", fname);
+		xfree(fname);
+	}
+	xfree(seg);
+}
+
+/* Map a journal segment file */
+static dbd_journal_seg_t *_journal_seg_map(uint32_t id, int fd, uint32_t size)
+{
+	dbd_journal_seg_t *seg;
+	char *data;
+
+	data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		error("slurmdbd: mmap of journal segment %u: %m", id);
+		return NULL;
+	}
+	seg = xmalloc(sizeof(dbd_journal_seg_t));
+	seg->data = data;
+	seg->id = id;
+	seg->size = size;
+	return seg;
+}
+
+/* Create a new journal segment of the given size. The file is filled with
+ * zeros rather than extended with ftruncate(), so that running out of
+ * disk space shows up here and not as a SIGBUS when storing into the
+ * mapping. */
+static dbd_journal_seg_t *_journal_seg_create(uint32_t size)
+{
+	dbd_journal_seg_t *seg = NULL;
+	dbd_journal_hdr_t *hdr;
+	uint32_t id = journal_next_id++;
+	uint32_t chunk, left = size;
+	char *fname, *zeros;
+	ssize_t wrote;
+	int fd;
+
+	fname = _journal_seg_name(id);
+	fd = open(fname, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0) {
+		error("slurmdbd: creating journal segment %s: %m", fname);
+		xfree(fname);
+		return NULL;
+	}
+
+	zeros = xmalloc(64 * 1024);
+	while (left) {
+		chunk = MIN(left, 64 * 1024);
+		wrote = write(fd, zeros, chunk);
+		if (wrote > 0) {
+			left -= wrote;
+		} else if ((wrote == -1) && (errno == EINTR)) {
+			continue;
+		} else {
+			error("slurmdbd: writing journal segment %s: %m",
+			      fname);
+			break;
+		}
+	}
+	xfree(zeros);
+
+	if (!left && (seg = _journal_seg_map(id, fd, size))) {
+		hdr = (dbd_journal_hdr_t *) seg->data;
+		hdr->magic = DBD_JOURNAL_SEG_MAGIC;
+		hdr->rpc_version = SLURM_PROTOCOL_VERSION;
+		seg->rpc_version = SLURM_PROTOCOL_VERSION;
+		seg->used = sizeof(dbd_journal_hdr_t);
+	} else
+		(void) unlink(fname);
+	(void) close(fd);
+	xfree(fname);
+
+	return seg;
+}
+
+static void _journal_seg_remove(dbd_journal_seg_t *seg)
+{
+	ListIterator itr;
+	dbd_journal_seg_t *seg2;
+
+	itr = list_iterator_create(journal_segs);
+	while ((seg2 = list_next(itr))) {
+		if (seg2 == seg) {
+			list_remove(itr);
+			break;
+		}
+	}
+	list_iterator_destroy(itr);
+	_journal_seg_free(seg, true);
+}
+
+/* Return the journal segment holding the data of buffer, or NULL if the
+ * message is not journaled */
+static dbd_journal_seg_t *_journal_seg_find(Buf buffer)
+{
+	ListIterator itr;
+	dbd_journal_seg_t *seg;
+	char *data = get_buf_data(buffer);
+
+	if (!journal_segs)
+		return NULL;
+
+	itr = list_iterator_create(journal_segs);
+	while ((seg = list_next(itr))) {
+		if ((data >= seg->data) && (data < (seg->data + seg->size)))
+			break;
+	}
+	list_iterator_destroy(itr);
+
+	return seg;
+}
+
+/* Queue the unacknowledged records of one journal segment on agent_list.
+ * RET number of records queued */
+static int _journal_seg_replay(uint32_t id)
+{
+	dbd_journal_seg_t *seg = NULL;
+	dbd_journal_hdr_t *hdr;
+	dbd_journal_rec_t *rec;
+	slurmdbd_msg_t msg;
+	struct stat stat_buf;
+	uint32_t offset;
+	char *fname;
+	Buf buffer;
+	int fd;
+
+	fname = _journal_seg_name(id);
+	if ((fd = open(fname, O_RDWR)) < 0) {
+		error("slurmdbd: opening journal segment %s: %m", fname);
+		xfree(fname);
+		return 0;
+	}
+	if (fstat(fd, &stat_buf) ||
+	    (stat_buf.st_size < sizeof(dbd_journal_hdr_t)) ||
+	    (stat_buf.st_size > UINT32_MAX) ||
+	    !(seg = _journal_seg_map(id, fd, stat_buf.st_size))) {
+		error("slurmdbd: invalid journal segment %s", fname);
+		(void) close(fd);
+		xfree(fname);
+		return 0;
+	}
+	(void) close(fd);
+
+	hdr = (dbd_journal_hdr_t *) seg->data;
+	if (hdr->magic != DBD_JOURNAL_SEG_MAGIC) {
+		error("slurmdbd: invalid journal segment %s", fname);
+		_journal_seg_free(seg, false);
+		xfree(fname);
+		return 0;
+	}
+	seg->rpc_version = hdr->rpc_version;
+	seg->used = seg->size;	/* never append to an old segment */
+
+	offset = sizeof(dbd_journal_hdr_t);
+	while ((offset + sizeof(dbd_journal_rec_t)) <= seg->size) {
+		rec = (dbd_journal_rec_t *) (seg->data + offset);
+		if (rec->magic == 0)
+			break;
+		if (((rec->magic != DBD_JOURNAL_MAGIC) &&
+		     (rec->magic != DBD_JOURNAL_ACKED)) ||
+		    (rec->size > (seg->size - offset -
+				  sizeof(dbd_journal_rec_t)))) {
+			error("slurmdbd: journal segment %s is corrupted at "
+			      "offset %u", fname, offset);
+			break;
+		}
+		offset += DBD_JOURNAL_REC_LEN(rec->size);
+		if (rec->magic != DBD_JOURNAL_MAGIC)
+			continue;
+
+		buffer = create_buf((char *) (rec + 1), rec->size);
+		if (seg->rpc_version != SLURM_PROTOCOL_VERSION) {
+			/* unpack and repack with new PROTOCOL_VERSION, the
+			 * copy is journaled again by _journal_queue() */
+			dbd_journal_stale_t *stale;
+			int rc = unpack_slurmdbd_msg(&msg, seg->rpc_version,
+						     buffer);
+			buffer->head = NULL;
+			free_buf(buffer);
+			if (rc != SLURM_SUCCESS) {
+				rec->magic = DBD_JOURNAL_ACKED;
+				continue;
+			}
+			buffer = pack_slurmdbd_msg(&msg,
+						   SLURM_PROTOCOL_VERSION);
+			stale = xmalloc(sizeof(dbd_journal_stale_t));
+			stale->buffer = buffer;
+			stale->seg = seg;
+			stale->rec = rec;
+			list_append(journal_stale, stale);
+		} else {
+			set_buf_offset(buffer, rec->size);
+		}
+		seg->live++;
+		if (!list_enqueue(agent_list, buffer))
+			fatal("slurmdbd: list_enqueue, no memory");
+	}
+	xfree(fname);
+
+	if (!seg->live) {
+		_journal_seg_free(seg, true);
+		return 0;
+	}
+	list_append(journal_segs, seg);
+	return seg->live;
+}
+
+static int _uint32_cmp(const void *x, const void *y)
+{
+	uint32_t a = *(uint32_t *) x;
+	uint32_t b = *(uint32_t *) y;
+
+	if (a < b)
+		return -1;
+	return (a > b);
+}
+
+/* Open the journal in StateSaveLocation and queue the messages it still
+ * holds on agent_list, oldest first. If the directory cannot be read the
+ * queue is not journaled and is saved to dbd.messages at shutdown only.
+ * NOTE: Call with agent_lock locked. */
+static void _journal_open(void)
+{
+	struct dirent *ent;
+	uint32_t *ids = NULL, id;
+	int i, id_cnt = 0, recovered = 0;
+	char *end;
+	DIR *dir;
+
+	journal_dir = slurm_get_state_save_location();
+	if (!(dir = opendir(journal_dir))) {
+		error("slurmdbd: opendir(%s): %m, not journaling the agent "
+		      "queue", journal_dir);
+		xfree(journal_dir);
+		return;
+	}
+	while ((ent = readdir(dir))) {
+		if (strncmp(ent->d_name, "dbd.journal.", 12))
+			continue;
+		id = strtoul(ent->d_name + 12, &end, 10);
+		if ((end == ent->d_name + 12) || (*end != '\0'))
+			continue;
+		xrealloc(ids, sizeof(uint32_t) * (id_cnt + 1));
+		ids[id_cnt++] = id;
+	}
+	closedir(dir);
+
+	journal_segs = list_create(NULL);
+	journal_stale = list_create(NULL);
+	journal_next_id = 0;
+	if (id_cnt)
+		qsort(ids, id_cnt, sizeof(uint32_t), _uint32_cmp);
+	for (i = 0; i < id_cnt; i++) {
+		recovered += _journal_seg_replay(ids[i]);
+		journal_next_id = ids[i] + 1;
+	}
+	xfree(ids);
+
+	if (recovered)
+		verbose("slurmdbd: recovered %d pending RPCs from journal",
+			recovered);
+}
+
+/* Journal the messages on agent_list that are not journaled yet, those
+ * recovered from dbd.messages or repacked for a new protocol version.
+ * RET true if all of them are journaled now
+ * NOTE: Call with agent_lock locked. */
+static bool _journal_queue(void)
+{
+	ListIterator itr;
+	Buf buffer;
+	bool all = true;
+
+	itr = list_iterator_create(agent_list);
+	while ((buffer = list_next(itr))) {
+		if (!_journal_seg_find(buffer) &&
+		    (_journal_append(buffer) != SLURM_SUCCESS)) {
+			all = false;
+			break;
+		}
+	}
+	list_iterator_destroy(itr);
+	/* The old records of the copies just journaled are not needed */
+	_journal_stale_release(NULL);
+
+	return all;
+}
+
+/* Release the journal records of an older protocol version replaced by
+ * buffer, or with NULL those replaced by any message journaled by now.
+ * NOTE: Call with agent_lock locked. */
+static void _journal_stale_release(Buf buffer)
+{
+	ListIterator itr;
+	dbd_journal_stale_t *stale;
+
+	if (!journal_stale || !list_count(journal_stale))
+		return;
+
+	itr = list_iterator_create(journal_stale);
+	while ((stale = list_next(itr))) {
+		if (buffer ? (stale->buffer != buffer) :
+		    !_journal_seg_find(stale->buffer))
+			continue;
+		list_remove(itr);
+		stale->rec->magic = DBD_JOURNAL_ACKED;
+		if ((--stale->seg->live == 0) &&
+		    (stale->seg != journal_active))
+			_journal_seg_remove(stale->seg);
+		xfree(stale);
+	}
+	list_iterator_destroy(itr);
+}
+
+/* Return the number of messages on agent_list the journal does not hold.
+ * NOTE: Call with agent_lock locked. */
+static int _agent_unjournaled_cnt(void)
+{
+	ListIterator itr;
+	dbd_journal_seg_t *seg;
+	int cnt = list_count(agent_list);
+
+	if (!journal_segs)
+		return cnt;
+
+	/* Every live record is a message on agent_list, except those
+	 * replaced by an unjournaled copy */
+	itr = list_iterator_create(journal_segs);
+	while ((seg = list_next(itr)))
+		cnt -= seg->live;
+	list_iterator_destroy(itr);
+	cnt += list_count(journal_stale);
+
+	return cnt;
+}
+
+/* Move the data of a packed message into the journal. On success buffer
+ * points into the journal mapping.
+ * NOTE: Call with agent_lock locked. */
+static int _journal_append(Buf buffer)
+{
+	dbd_journal_seg_t *seg = journal_active;
+	dbd_journal_rec_t *rec;
+	uint32_t msg_size = get_buf_offset(buffer);
+	uint32_t rec_len = DBD_JOURNAL_REC_LEN(msg_size);
+
+	if (!journal_segs)
+		return SLURM_ERROR;
+
+	if (!seg || ((seg->used + rec_len) > seg->size)) {
+		if (list_count(journal_segs) >= DBD_JOURNAL_MAX_SEGS)
+			return SLURM_ERROR;
+		seg = _journal_seg_create(
+			MAX(DBD_JOURNAL_SEG_SIZE,
+			    sizeof(dbd_journal_hdr_t) + rec_len));
+		if (!seg)
+			return SLURM_ERROR;
+		list_append(journal_segs, seg);
+		if (journal_active && !journal_active->live)
+			_journal_seg_remove(journal_active);
+		journal_active = seg;
+	}
+
+	rec = (dbd_journal_rec_t *) (seg->data + seg->used);
+	memcpy(rec + 1, get_buf_data(buffer), msg_size);
+	rec->size = msg_size;
+	/* The magic marks the record complete, store it last in case we
+	 * die in between */
+	__sync_synchronize();
+	rec->magic = DBD_JOURNAL_MAGIC;
+	seg->used += rec_len;
+	seg->live++;
+
+	xfree(buffer->head);
+	buffer->head = (char *) (rec + 1);
+	buffer->size = msg_size;
+
+	return SLURM_SUCCESS;
+}
+
+/* Mark the journal record of a message slurmdbd has processed. The
+ * buffer no longer points into the journal afterwards, as its segment may
+ * be gone.
+ * NOTE: Call with agent_lock locked. */
+static void _journal_release(Buf buffer)
+{
+	dbd_journal_seg_t *seg;
+	dbd_journal_rec_t *rec;
+
+	if (!(seg = _journal_seg_find(buffer))) {
+		_journal_stale_release(buffer);
+		return;
+	}
+
+	rec = ((dbd_journal_rec_t *) get_buf_data(buffer)) - 1;
+	rec->magic = DBD_JOURNAL_ACKED;
+	buffer->head = NULL;
+	buffer->size = 0;
+	set_buf_offset(buffer, 0);
+	if ((--seg->live == 0) && (seg != journal_active))
+		_journal_seg_remove(seg);
+}
+
+/* Flush and unmap the journal. Call after agent_list is destroyed.
+ * NOTE: Call with agent_lock locked. */
+static void _journal_close(void)
+{
+	dbd_journal_seg_t *seg;
+	dbd_journal_stale_t *stale;
+
+	if (!journal_segs)
+		return;
+
+	/* Records whose copies were neither journaled nor saved stay live */
+	while ((stale = list_pop(journal_stale)))
+		xfree(stale);
+	FREE_NULL_LIST(journal_stale);
+	while ((seg = list_pop(journal_segs))) {
+		if (seg->live &&
+		    msync(seg->data, seg->size, MS_SYNC))
+			error("slurmdbd: msync of journal segment %u: %m",
+			      seg->id);
+		_journal_seg_free(seg, !seg->live);
+	}
+	FREE_NULL_LIST(journal_segs);
+	journal_active = NULL;
+	xfree(journal_dir);
+}
+
+/* Free a message removed from agent_list */
+static void _free_agent_buf(void *x)
+{
+	Buf buffer = (Buf) x;
+
+	if (_journal_seg_find(buffer))
+		buffer->head = NULL;	/* data belongs to the journal */
+	free_buf(buffer);
+}
+
 static void _save_dbd_state(void)
 {
 	char *dbd_fname;
 	Buf buffer;
-	int fd, rc, wrote = 0;
+	int fd, rc, wrote = 0, journaled = 0;
 	uint16_t msg_type;
 	uint32_t offset;
 
@@ -2278,6 +3091,12 @@ static void _save_dbd_state(void)
 			goto end_it;
 
 		while ((buffer = list_dequeue(agent_list))) {
+			/* Journaled messages are already saved */
+			if (_journal_seg_find(buffer)) {
+				_free_agent_buf(buffer);
+				journaled++;
+				continue;
+			}
 			/* We do not want to store registration
 			   messages.  If an admin puts in an incorrect
 			   cluster name we can get a deadlock unless
@@ -2298,6 +3117,8 @@ static void _save_dbd_state(void)
 			}
 
 			rc = _save_dbd_rec(fd, buffer);
+			if (rc == SLURM_SUCCESS)
+				_journal_stale_release(buffer);
 			free_buf(buffer);
 			if (rc != SLURM_SUCCESS)
 				break;
@@ -2308,6 +3129,9 @@ static void _save_dbd_state(void)
 end_it:
 	if (fd >= 0) {
 		verbose("slurmdbd: saved %d pending RPCs", wrote);
+		if (journaled)
+			verbose("slurmdbd: %d pending RPCs left in journal",
+				journaled);
 		(void) close(fd);
 	}
 	xfree(dbd_fname);
@@ -2491,7 +3315,8 @@ static void _sig_handler(int signal)
 {
 }
 
-/* Purge queued job/step start records from the agent queue
+/* Purge queued job/step start records the journal does not hold from the
+ * agent queue, journaled ones cost no memory and survive a restart
  * RET number of records purged */
 static int _purge_job_start_req(void)
 {
@@ -2504,7 +3329,7 @@ static int _purge_job_start_req(void)
 	iter = list_iterator_create(agent_list);
 	while ((buffer = list_next(iter))) {
 		offset = get_buf_offset(buffer);
-		if (offset < 2)
+		if ((offset < 2) || _journal_seg_find(buffer))
 			continue;
 		set_buf_offset(buffer, 0);
 		unpack16(&msg_type, buffer);
@@ -2512,6 +3337,7 @@ static int _purge_job_start_req(void)
 		if ((msg_type == DBD_JOB_START) ||
 		    (msg_type == DBD_STEP_START) ||
 		    (msg_type == DBD_STEP_COMPLETE)) {
+			_journal_release(buffer);
 			list_remove(iter);
 			purged++;
 		}
@@ -2591,6 +3417,7 @@ extern void slurmdbd_free_cond_msg(dbd_cond_msg_t *msg,
 			my_destroy = slurmdb_destroy_cluster_cond;
 			break;
 		case DBD_GET_JOBS_COND:
+		case DBD_GET_JOBS_PAGED:
 			my_destroy = slurmdb_destroy_job_cond;
 			break;
 		case DBD_GET_QOS:
@@ -3003,6 +3830,7 @@ extern void slurmdbd_pack_cond_msg(dbd_cond_msg_t *msg,
 		my_function = slurmdb_pack_cluster_cond;
 		break;
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_PAGED:
 		my_function = slurmdb_pack_job_cond;
 		break;
 	case DBD_GET_QOS:
@@ -3066,6 +3894,7 @@ extern int slurmdbd_unpack_cond_msg(dbd_cond_msg_t **msg,
 		my_function = slurmdb_unpack_cluster_cond;
 		break;
 	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_PAGED:
 		my_function = slurmdb_unpack_job_cond;
 		break;
 	case DBD_GET_QOS:
@@ -181,6 +181,8 @@ typedef enum {
 	DBD_ADD_TRES,         /* Add tres to the database           */
 	DBD_GET_TRES,         /* Get tres from the database         */
 	DBD_GOT_TRES,         /* Got tres from the database         */
+	DBD_GET_JOBS_PAGED,	/* Get job information a page at a time	*/
+	DBD_GET_JOBS_NEXT,	/* Get next page of DBD_GET_JOBS_PAGED	*/
 } slurmdbd_msg_type_t;
 
 /*****************************************************************************\
@@ -39,6 +39,8 @@
  *  Copyright (C) 2002 The Regents of the University of California.
 \*****************************************************************************/
 
+#include <ctype.h>
+
 #include "mysql_common.h"
 #include "src/common/xstring.h"
 #include "src/common/xmalloc.h"
@@ -53,6 +55,12 @@ typedef struct {
 	char *columns;
 } db_key_t;
 
+typedef struct {
+	char *head;	/* statement, or start of an insert */
+	char *row;	/* values of an insert, NULL for a plain statement */
+	char *tail;	/* end of an insert (on duplicate key...) */
+} mysql_batch_t;
+
 static void _destroy_db_key(void *arg)
 {
 	db_key_t *db_key = (db_key_t *)arg;
@@ -168,6 +176,191 @@ end_it:
 	return rc;
 }
 
+static void _destroy_batch(void *arg)
+{
+	mysql_batch_t *batch = (mysql_batch_t *)arg;
+
+	if (batch) {
+		xfree(batch->head);
+		xfree(batch->row);
+		xfree(batch->tail);
+		xfree(batch);
+	}
+}
+
+static bool _batch_mergeable(mysql_batch_t *prev, mysql_batch_t *batch)
+{
+	return (prev && prev->row && batch->row &&
+		!strcmp(prev->head, batch->head) &&
+		!strcmp(prev->tail, batch->tail));
+}
+
+/* NOTE: Insure that mysql_conn->lock is set on function entry */
+static int _run_batch_entry(MYSQL *db_conn, mysql_batch_t *batch)
+{
+	char *query = xstrdup_printf("%s%s%s", batch->head,
+				     batch->row ? batch->row : "",
+				     batch->tail ? batch->tail : "");
+	int rc;
+
+	if ((rc = _mysql_query_internal(db_conn, query)) == SLURM_SUCCESS)
+		_clear_results(db_conn);
+	xfree(query);
+
+	return rc;
+}
+
+/* Send everything in mysql_conn->batch_list as one multi-statement query.
+ * If a statement fails MySQL skips the rest, so those are then run one
+ * at a time (and the rows of a failed multi-row insert along with them)
+ * to lose no more than the single bad statement would have.  A deadlock
+ * rolls back the whole transaction instead, so then the whole batch is
+ * run again if the transaction is our own.  Any failure is remembered in
+ * mysql_conn->batch_failed for the next mysql_db_commit().
+ * NOTE: Insure that mysql_conn->lock is set on function entry */
+static int _flush_batch(mysql_conn_t *mysql_conn)
+{
+	MYSQL *db_conn = mysql_conn->db_conn;
+	MYSQL_RES *result;
+	mysql_batch_t **batch, *prev = NULL;
+	int *stmt_first, stmt_cnt = 0, stmt_ok = 0, batch_cnt, i, status;
+	int rc = SLURM_SUCCESS, err = 0;
+	char *query = NULL;
+
+	if (!mysql_conn->batch_list ||
+	    !(batch_cnt = list_count(mysql_conn->batch_list)))
+		return SLURM_SUCCESS;
+
+	batch = xmalloc(sizeof(mysql_batch_t *) * batch_cnt);
+	stmt_first = xmalloc(sizeof(int) * (batch_cnt + 1));
+	for (i = 0; i < batch_cnt; i++) {
+		batch[i] = list_dequeue(mysql_conn->batch_list);
+		if (_batch_mergeable(prev, batch[i])) {
+			xstrfmtcat(query, ", %s", batch[i]->row);
+		} else {
+			if (prev)
+				xstrfmtcat(query, "%s;",
+					   prev->tail ? prev->tail : "");
+			stmt_first[stmt_cnt++] = i;
+			xstrfmtcat(query, "%s%s", batch[i]->head,
+				   batch[i]->row ? batch[i]->row : "");
+		}
+		prev = batch[i];
+	}
+	xstrfmtcat(query, "%s;", prev->tail ? prev->tail : "");
+	stmt_first[stmt_cnt] = batch_cnt;
+	mysql_conn->batch_size = 0;
+
+	/* A connection in autocommit mode would otherwise commit after
+	 * every statement */
+	if (!mysql_conn->rollback)
+		_mysql_query_internal(db_conn, "start transaction;");
+
+	if ((_mysql_query_internal(db_conn, query) == SLURM_SUCCESS) &&
+	    !mysql_errno(db_conn)) {
+		stmt_ok = 1;
+		while (1) {
+			if ((result = mysql_store_result(db_conn)))
+				mysql_free_result(result);
+			if ((status = mysql_next_result(db_conn)))
+				break;
+			stmt_ok++;
+		}
+		if (status > 0) {
+			err = mysql_errno(db_conn);
+			error("mysql batch statement %d of %d failed: %d %s",
+			      stmt_ok + 1, stmt_cnt, err, mysql_error(db_conn));
+			rc = SLURM_ERROR;
+		}
+	} else {
+		err = mysql_errno(db_conn);
+		rc = SLURM_ERROR;
+	}
+
+	if ((rc != SLURM_SUCCESS) && (err == ER_LOCK_DEADLOCK)) {
+		/* Everything since the start of the transaction is gone.
+		 * In the caller's transaction that is more than this
+		 * batch, so only the caller can start over. */
+		if (!mysql_conn->rollback) {
+			_mysql_query_internal(db_conn, "start transaction;");
+			rc = SLURM_SUCCESS;
+			for (i = 0; i < batch_cnt; i++) {
+				if (_run_batch_entry(db_conn, batch[i]))
+					rc = SLURM_ERROR;
+			}
+		}
+	} else if (rc != SLURM_SUCCESS) {
+		/* Only the merged rows of the failed statement get a
+		 * second chance, a single statement would just fail
+		 * again. */
+		i = stmt_first[stmt_ok];
+		if ((stmt_first[stmt_ok + 1] - i) == 1)
+			i++;
+		else
+			rc = SLURM_SUCCESS;
+		for ( ; i < batch_cnt; i++) {
+			if (_run_batch_entry(db_conn, batch[i]))
+				rc = SLURM_ERROR;
+		}
+	}
+
+	if (!mysql_conn->rollback && mysql_commit(db_conn)) {
+		error("mysql_commit failed: %d %s",
+		      mysql_errno(db_conn), mysql_error(db_conn));
+		rc = SLURM_ERROR;
+	}
+
+	if (rc != SLURM_SUCCESS)
+		mysql_conn->batch_failed = true;
+
+	for (i = 0; i < batch_cnt; i++)
+		_destroy_batch(batch[i]);
+	xfree(batch);
+	xfree(stmt_first);
+	xfree(query);
+
+	return rc;
+}
+
+/* NOTE: Insure that mysql_conn->lock is set on function entry */
+static void _purge_batch(mysql_conn_t *mysql_conn)
+{
+	if (mysql_conn->batch_list)
+		list_flush(mysql_conn->batch_list);
+	mysql_conn->batch_size = 0;
+	mysql_conn->batch_failed = false;
+}
+
+static int _queue_batch(mysql_conn_t *mysql_conn, char *head, char *row,
+			char *tail)
+{
+	mysql_batch_t *batch;
+	int rc = SLURM_SUCCESS;
+
+	if (!mysql_conn || !mysql_conn->db_conn) {
+		fatal("You haven't inited this storage yet.");
+		return 0;	/* For CLANG false positive */
+	}
+
+	batch = xmalloc(sizeof(mysql_batch_t));
+	batch->head = xstrdup(head);
+	batch->row = xstrdup(row);
+	batch->tail = xstrdup(tail);
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	if (!mysql_conn->batch_list)
+		mysql_conn->batch_list = list_create(_destroy_batch);
+	list_append(mysql_conn->batch_list, batch);
+	mysql_conn->batch_size += strlen(head) + 2;
+	if (row)
+		mysql_conn->batch_size += strlen(row);
+	if (mysql_conn->batch_size >= MYSQL_BATCH_SIZE)
+		rc = _flush_batch(mysql_conn);
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	return rc;
+}
+
 /* NOTE: Insure that mysql_conn->lock is NOT set on function entry */
 static int _mysql_make_table_current(mysql_conn_t *mysql_conn, char *table_name,
 				     storage_field_t *fields, char *ending)
@@ -594,6 +787,7 @@ extern int destroy_mysql_conn(mysql_conn_t *mysql_conn)
 {
 	if (mysql_conn) {
 		mysql_db_close_db_connection(mysql_conn);
+		FREE_NULL_LIST(mysql_conn->batch_list);
 		xfree(mysql_conn->pre_commit_query);
 		xfree(mysql_conn->cluster_name);
 		slurm_mutex_destroy(&mysql_conn->lock);
@@ -727,6 +921,12 @@ extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn)
 {
 	slurm_mutex_lock(&mysql_conn->lock);
 	if (mysql_conn && mysql_conn->db_conn) {
+		/* Without autocommit the server drops the open
+		 * transaction anyway */
+		if (mysql_conn->rollback)
+			_purge_batch(mysql_conn);
+		else
+			_flush_batch(mysql_conn);
 		if (mysql_thread_safe())
 			mysql_thread_end();
 		mysql_close(mysql_conn->db_conn);
@@ -758,6 +958,7 @@ extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	rc = _mysql_query_internal(mysql_conn->db_conn, query);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
@@ -776,6 +977,7 @@ extern int mysql_db_delete_affected_rows(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	if (!(rc = _mysql_query_internal(mysql_conn->db_conn, query)))
 			rc = mysql_affected_rows(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
@@ -805,9 +1007,18 @@ extern int mysql_db_commit(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
-	if (mysql_commit(mysql_conn->db_conn)) {
+	if (mysql_conn->batch_failed) {
+		/* The caller reports everything in this transaction as
+		 * failed, so don't commit the part that worked. */
+		error("queued queries failed, not committing");
+		if (mysql_conn->rollback)
+			mysql_rollback(mysql_conn->db_conn);
+		mysql_conn->batch_failed = false;
+		rc = SLURM_ERROR;
+	} else if (mysql_commit(mysql_conn->db_conn)) {
 		error("mysql_commit failed: %d %s",
 		      mysql_errno(mysql_conn->db_conn),
 		      mysql_error(mysql_conn->db_conn));
@@ -826,6 +1037,7 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_purge_batch(mysql_conn);
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
 	if (mysql_rollback(mysql_conn->db_conn)) {
@@ -846,6 +1058,7 @@ extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
 		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
 			goto fini;
@@ -870,6 +1083,7 @@ extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query)
 	int rc = SLURM_SUCCESS;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	if ((rc = _mysql_query_internal(
 		     mysql_conn->db_conn, query)) != SLURM_ERROR)
 		rc = _clear_results(mysql_conn->db_conn);
@@ -882,6 +1096,7 @@ extern int mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 	int new_id = 0;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
 		new_id = mysql_insert_id(mysql_conn->db_conn);
 		if (!new_id) {
@@ -895,6 +1110,42 @@ extern int mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 
 }
 
+extern int mysql_db_query_batch(mysql_conn_t *mysql_conn, char *query)
+{
+	char *stmt = xstrdup(query);
+	int len = strlen(stmt), rc;
+
+	/* The statements get joined with ';', an empty one in between
+	 * is an error */
+	while (len && ((stmt[len - 1] == ';') || isspace(stmt[len - 1])))
+		stmt[--len] = '\0';
+	rc = _queue_batch(mysql_conn, stmt, NULL, NULL);
+	xfree(stmt);
+
+	return rc;
+}
+
+extern int mysql_db_insert_batch(mysql_conn_t *mysql_conn, char *head,
+				 char *row, char *tail)
+{
+	return _queue_batch(mysql_conn, head, row, tail ? tail : "");
+}
+
+extern int mysql_db_flush_batch(mysql_conn_t *mysql_conn)
+{
+	int rc;
+
+	if (!mysql_conn->db_conn)
+		return SLURM_ERROR;
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
+	rc = mysql_conn->batch_failed ? SLURM_ERROR : SLURM_SUCCESS;
+	mysql_conn->batch_failed = false;
+	slurm_mutex_unlock(&mysql_conn->lock);
+	return rc;
+}
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending)
 {
@@ -69,7 +69,15 @@ typedef enum {
 	SLURM_MYSQL_PLUGIN_JC, /* jobcomp */
 } slurm_mysql_plugin_type_t;
 
+/* Queued statements are sent once they add up to this many bytes, keep
+ * it well under the server's max_allowed_packet */
+#define MYSQL_BATCH_SIZE (1024 * 1024)
+
 typedef struct {
+	bool batch_failed;	/* a queued statement failed since the
+				 * last commit or rollback */
+	List batch_list;	/* mysql_batch_t's waiting to be sent */
+	uint32_t batch_size;	/* bytes queued in batch_list */
 	bool cluster_deleted;
 	char *cluster_name;
 	MYSQL *db_conn;
@@ -115,6 +123,20 @@ extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query);
 
 extern int mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query);
 
+/* Queue a statement whose result isn't needed right away.  The queue is
+ * sent as one multi-statement query before any other query on the
+ * connection, on commit, on close, or once MYSQL_BATCH_SIZE is reached.
+ * Errors are logged when the queue is sent. */
+extern int mysql_db_query_batch(mysql_conn_t *mysql_conn, char *query);
+/* Queue one row of an insert.  Rows queued back to back with the same
+ * head (e.g. "insert into t (a, b) values ") and tail (e.g. " on
+ * duplicate key update b=VALUES(b)") are sent as a single multi-row
+ * insert. */
+extern int mysql_db_insert_batch(mysql_conn_t *mysql_conn, char *head,
+				 char *row, char *tail);
+/* Send anything queued with mysql_db_query_batch/insert_batch */
+extern int mysql_db_flush_batch(mysql_conn_t *mysql_conn);
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending);
 
@@ -90,6 +90,20 @@ extern List slurmdb_jobs_get(void *db_conn, slurmdb_job_cond_t *job_cond)
 	return jobacct_storage_g_get_jobs_cond(db_conn, getuid(), job_cond);
 }
 
+/*
+ * get info from the storage one job at a time
+ * IN:  callback - called with each slurmdb_job_rec_t * found
+ * RET: SLURM_SUCCESS on success SLURM_ERROR else
+ */
+extern int slurmdb_jobs_get_cb(void *db_conn, slurmdb_job_cond_t *job_cond,
+			       int (*callback) (slurmdb_job_rec_t *job,
+						void *arg),
+			       void *arg)
+{
+	return jobacct_storage_g_get_jobs_cond_cb(db_conn, getuid(), job_cond,
+						  callback, arg);
+}
+
 /*
  * get info from the storage
  * IN:  slurmdb_assoc_cond_t *
@@ -81,7 +81,7 @@ List as_mysql_cluster_list = NULL;
    end of the life of the slurmdbd.
 */
 List as_mysql_total_cluster_list = NULL;
-pthread_mutex_t as_mysql_cluster_list_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_rwlock_t as_mysql_cluster_list_lock = PTHREAD_RWLOCK_INITIALIZER;
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -737,10 +737,10 @@ static int _as_mysql_acct_check_tables(mysql_conn_t *mysql_conn)
 			fatal("problem adding tres 'cpu'");
 	}
 
-	slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_wrlock(&as_mysql_cluster_list_lock);
 	if (!(as_mysql_cluster_list = _get_cluster_names(mysql_conn, 0))) {
 		error("issue getting contents of %s", cluster_table);
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 		return SLURM_ERROR;
 	}
 
@@ -751,13 +751,13 @@ static int _as_mysql_acct_check_tables(mysql_conn_t *mysql_conn)
 	if (!(as_mysql_total_cluster_list =
 	      _get_cluster_names(mysql_conn, 1))) {
 		error("issue getting total contents of %s", cluster_table);
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 		return SLURM_ERROR;
 	}
 
 	if (as_mysql_convert_tables(mysql_conn) != SLURM_SUCCESS) {
 		error("issue converting tables");
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 		return SLURM_ERROR;
 	}
 
@@ -772,7 +772,7 @@ static int _as_mysql_acct_check_tables(mysql_conn_t *mysql_conn)
 			break;
 	}
 	list_iterator_destroy(itr);
-	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	if (rc != SLURM_SUCCESS)
 		return rc;
@@ -2205,7 +2205,7 @@ extern int init ( void )
 
 extern int fini ( void )
 {
-	slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_wrlock(&as_mysql_cluster_list_lock);
 	if (as_mysql_cluster_list) {
 		list_destroy(as_mysql_cluster_list);
 		as_mysql_cluster_list = NULL;
@@ -2214,8 +2214,8 @@ extern int fini ( void )
 		list_destroy(as_mysql_total_cluster_list);
 		as_mysql_total_cluster_list = NULL;
 	}
-	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
-	slurm_mutex_destroy(&as_mysql_cluster_list_lock);
+	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_destroy(&as_mysql_cluster_list_lock);
 	destroy_mysql_db_info(mysql_db_info);
 	xfree(mysql_db_name);
 	xfree(default_qos_str);
@@ -2278,12 +2278,12 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 
 	debug4("got %d commits", list_count(mysql_conn->update_list));
 
+	rc = SLURM_SUCCESS;
 	if (mysql_conn->rollback) {
 		if (!commit) {
 			if (mysql_db_rollback(mysql_conn))
 				error("rollback failed");
 		} else {
-			int rc = SLURM_SUCCESS;
 			/* Handle anything here we were unable to do
 			   because of rollback issues.  i.e. Since any
 			   use of altering a tables
@@ -2302,11 +2302,14 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 			if (rc != SLURM_SUCCESS) {
 				if (mysql_db_rollback(mysql_conn))
 					error("rollback failed");
-			} else {
-				if (mysql_db_commit(mysql_conn))
-					error("commit failed");
+			} else if ((rc = mysql_db_commit(mysql_conn))) {
+				error("commit failed");
 			}
 		}
+	} else if (commit) {
+		/* autocommit, just send anything queued */
+		if ((rc = mysql_db_flush_batch(mysql_conn)))
+			error("flushing queued queries failed");
 	}
 
 	if (commit && list_count(mysql_conn->update_list)) {
@@ -2339,7 +2342,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	skip:
 		(void) assoc_mgr_update(mysql_conn->update_list, 0);
 
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_wrlock(&as_mysql_cluster_list_lock);
 		itr2 = list_iterator_create(as_mysql_cluster_list);
 		itr = list_iterator_create(mysql_conn->update_list);
 		while ((object = list_next(itr))) {
@@ -2368,7 +2371,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 		}
 		list_iterator_destroy(itr);
 		list_iterator_destroy(itr2);
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 		if (get_qos_count)
 			_set_qos_cnt(mysql_conn);
@@ -2376,7 +2379,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	xfree(mysql_conn->pre_commit_query);
 	list_flush(mysql_conn->update_list);
 
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 extern int acct_storage_p_add_users(mysql_conn_t *mysql_conn, uint32_t uid,
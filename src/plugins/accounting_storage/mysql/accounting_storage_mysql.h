@@ -103,7 +103,7 @@ extern char *wckey_table;
  */
 extern List as_mysql_cluster_list;
 extern List as_mysql_total_cluster_list;
-extern pthread_mutex_t as_mysql_cluster_list_lock;
+extern pthread_rwlock_t as_mysql_cluster_list_lock;
 
 extern uint64_t debug_flags;
 
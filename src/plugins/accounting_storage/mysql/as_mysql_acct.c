@@ -79,7 +79,7 @@ static int _get_account_coords(mysql_conn_t *mysql_conn,
 	}
 	mysql_free_result(result);
 
-	slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 	itr = list_iterator_create(as_mysql_cluster_list);
 	while ((cluster_name = list_next(itr))) {
 		if (query)
@@ -96,7 +96,7 @@ static int _get_account_coords(mysql_conn_t *mysql_conn,
 			   acct->name, acct->name);
 	}
 	list_iterator_destroy(itr);
-	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	if (!query) {
 		error("No clusters defined?  How could there be accts?");
@@ -523,7 +523,7 @@ extern List as_mysql_remove_accts(mysql_conn_t *mysql_conn, uint32_t uid,
 
 	user_name = uid_to_string((uid_t) uid);
 
-	slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 	itr = list_iterator_create(as_mysql_cluster_list);
 	while ((object = list_next(itr))) {
 		if ((rc = remove_common(mysql_conn, DBD_REMOVE_ACCOUNTS, now,
@@ -534,7 +534,7 @@ extern List as_mysql_remove_accts(mysql_conn_t *mysql_conn, uint32_t uid,
 			break;
 	}
 	list_iterator_destroy(itr);
-	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	xfree(user_name);
 	xfree(name_char);
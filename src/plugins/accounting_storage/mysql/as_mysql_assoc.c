@@ -338,7 +338,7 @@ static int _make_sure_users_have_default(
 	if (!user_list)
 		return SLURM_SUCCESS;
 
-	slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 
 	clus_itr = list_iterator_create(as_mysql_cluster_list);
 	itr = list_iterator_create(user_list);
@@ -403,7 +403,7 @@ static int _make_sure_users_have_default(
 	}
 	list_iterator_destroy(itr);
 	list_iterator_destroy(clus_itr);
-	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	return rc;
 }
@@ -2987,7 +2987,7 @@ extern int as_mysql_add_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 			ListIterator itr2 =
 				list_iterator_create(update_object->objects);
 
-			slurm_mutex_lock(&as_mysql_cluster_list_lock);
+			slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 			itr = list_iterator_create(as_mysql_cluster_list);
 			while ((cluster_name = list_next(itr))) {
 				uint32_t smallest_lft = 0xFFFFFFFF;
@@ -3006,7 +3006,7 @@ extern int as_mysql_add_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 						smallest_lft);
 			}
 			list_iterator_destroy(itr);
-			slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+			slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 			list_iterator_destroy(itr2);
 		}
 	}
@@ -3259,7 +3259,7 @@ is_same_user:
 	if (assoc_cond->cluster_list && list_count(assoc_cond->cluster_list))
 		use_cluster_list = assoc_cond->cluster_list;
 	else
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
@@ -3302,7 +3302,7 @@ is_same_user:
 	}
 	list_iterator_destroy(itr);
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 	xfree(vals);
 	xfree(object);
 	xfree(extra);
@@ -3374,7 +3374,7 @@ extern List as_mysql_remove_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 	if (assoc_cond->cluster_list && list_count(assoc_cond->cluster_list))
 		use_cluster_list = assoc_cond->cluster_list;
 	else
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
@@ -3449,7 +3449,7 @@ extern List as_mysql_remove_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 	}
 	list_iterator_destroy(itr);
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 	xfree(object);
 	xfree(extra);
 
@@ -3531,7 +3531,7 @@ empty:
 	assoc_list = list_create(slurmdb_destroy_assoc_rec);
 
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
 		int rc;
@@ -3546,7 +3546,7 @@ empty:
 	}
 	list_iterator_destroy(itr);
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 	xfree(tmp);
 	xfree(extra);
 
@@ -49,6 +49,30 @@
 
 #define BUFFER_SIZE 4096
 
+static char *step_start_dup =
+	" on duplicate key update "
+	"nodes_alloc=VALUES(nodes_alloc), task_cnt=VALUES(task_cnt), "
+	"time_end=0, state=VALUES(state), "
+	"nodelist=VALUES(nodelist), node_inx=VALUES(node_inx), "
+	"task_dist=VALUES(task_dist), req_cpufreq=VALUES(req_cpufreq), "
+	"req_cpufreq_min=VALUES(req_cpufreq_min), "
+	"req_cpufreq_gov=VALUES(req_cpufreq_gov), "
+	"tres_alloc=VALUES(tres_alloc)";
+
+/* Job and step record updates don't need an answer, so under the
+ * slurmdbd they are queued and sent together with the next query or
+ * the commit after every RPC (or DBD_SEND_MULT_MSG) from the slurmctld,
+ * whose reply then carries any failure.  With CommitDelay the reply
+ * goes out before the commit, and a slurmctld writing to the database
+ * directly never commits, so both still send them right away.
+ */
+static int _job_query(mysql_conn_t *mysql_conn, char *query)
+{
+	if (slurmdbd_conf && !slurmdbd_conf->commit_delay)
+		return mysql_db_query_batch(mysql_conn, query);
+	return mysql_db_query(mysql_conn, query);
+}
+
 /* Used in job functions for getting the database index based off the
  * submit time, job and assoc id.  0 is returned if none is found
  */
@@ -655,7 +679,7 @@ no_rollup_change:
 
 		if (debug_flags & DEBUG_FLAG_DB_JOB)
 			DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-		rc = mysql_db_query(mysql_conn, query);
+		rc = _job_query(mysql_conn, query);
 	}
 
 	xfree(block_id);
@@ -905,7 +929,7 @@ extern int as_mysql_job_complete(mysql_conn_t *mysql_conn,
 
 	if (debug_flags & DEBUG_FLAG_DB_JOB)
 		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	rc = _job_query(mysql_conn, query);
 	xfree(query);
 
 	return rc;
@@ -919,7 +943,7 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 	char node_list[BUFFER_SIZE];
 	char *node_inx = NULL, *step_name = NULL;
 	time_t start_time, submit_time;
-	char *query = NULL;
+	char *query = NULL, *head = NULL, *row = NULL;
 
 	if (!step_ptr->job_ptr->db_index
 	    && ((!step_ptr->job_ptr->details
@@ -1049,32 +1073,36 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 	/* we want to print a -1 for the requid so leave it a
 	   %d */
 	/* The stepid could be -2 so use %d not %u */
-	query = xstrdup_printf(
+	head = xstrdup_printf(
 		"insert into \"%s_%s\" (job_db_inx, id_step, time_start, "
 		"step_name, state, tres_alloc, "
 		"nodes_alloc, task_cnt, nodelist, node_inx, "
 		"task_dist, req_cpufreq, req_cpufreq_min, req_cpufreq_gov) "
-		"values (%d, %d, %d, '%s', %d, '%s', %d, %d, "
-		"'%s', '%s', %d, %u, %u, %u) "
-		"on duplicate key update "
-		"nodes_alloc=%d, task_cnt=%d, time_end=0, state=%d, "
-		"nodelist='%s', node_inx='%s', task_dist=%d, "
-		"req_cpufreq=%u, req_cpufreq_min=%u, req_cpufreq_gov=%u,"
-		"tres_alloc='%s';",
-		mysql_conn->cluster_name, step_table,
+		"values ",
+		mysql_conn->cluster_name, step_table);
+	row = xstrdup_printf(
+		"(%d, %d, %d, '%s', %d, '%s', %d, %d, "
+		"'%s', '%s', %d, %u, %u, %u)",
 		step_ptr->job_ptr->db_index,
 		step_ptr->step_id,
 		(int)start_time, step_name,
 		JOB_RUNNING, step_ptr->tres_alloc_str,
 		nodes, tasks, node_list, node_inx, task_dist,
 		step_ptr->cpu_freq_max, step_ptr->cpu_freq_min,
-		step_ptr->cpu_freq_gov, nodes, tasks, JOB_RUNNING,
-		node_list, node_inx, task_dist, step_ptr->cpu_freq_max,
-		step_ptr->cpu_freq_min, step_ptr->cpu_freq_gov,
-		step_ptr->tres_alloc_str);
+		step_ptr->cpu_freq_gov);
 	if (debug_flags & DEBUG_FLAG_DB_STEP)
-		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+		DB_DEBUG(mysql_conn->conn, "query\n%s%s%s",
+			 head, row, step_start_dup);
+	/* Steps started back to back go out as one multi-row insert */
+	if (slurmdbd_conf && !slurmdbd_conf->commit_delay) {
+		rc = mysql_db_insert_batch(mysql_conn, head, row,
+					   step_start_dup);
+	} else {
+		query = xstrdup_printf("%s%s%s", head, row, step_start_dup);
+		rc = mysql_db_query(mysql_conn, query);
+	}
+	xfree(head);
+	xfree(row);
 	xfree(query);
 	xfree(step_name);
 
@@ -1275,7 +1303,7 @@ extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 		   step_ptr->job_ptr->db_index, step_ptr->step_id);
 	if (debug_flags & DEBUG_FLAG_DB_STEP)
 		DB_DEBUG(mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	rc = _job_query(mysql_conn, query);
 	xfree(query);
 
 	return rc;
@@ -1335,18 +1363,21 @@ extern int as_mysql_suspend(mysql_conn_t *mysql_conn,
 
 	/* use job_db_inx for this one since we want to update the
 	   supend time of the job before it was resized.
+	   The state check keeps a resent request from flipping
+	   time_suspended back.
 	*/
 	xstrfmtcat(query,
 		   "update \"%s_%s\" set time_suspended=%d-time_suspended, "
-		   "state=%d where job_db_inx=%d;",
+		   "state=%d where job_db_inx=%d && state!=%d;",
 		   mysql_conn->cluster_name, job_table,
 		   (int)job_ptr->suspend_time,
 		   job_ptr->job_state & JOB_STATE_BASE,
-		   job_db_inx);
+		   job_db_inx, job_ptr->job_state & JOB_STATE_BASE);
 	if (IS_JOB_SUSPENDED(job_ptr))
 		xstrfmtcat(query,
 			   "insert into \"%s_%s\" (job_db_inx, id_assoc, "
-			   "time_start, time_end) values (%u, %u, %d, 0);",
+			   "time_start, time_end) values (%u, %u, %d, 0) "
+			   "on duplicate key update time_end=0;",
 			   mysql_conn->cluster_name, suspend_table,
 			   job_ptr->db_index, job_ptr->assoc_id,
 			   (int)job_ptr->suspend_time);
@@ -1366,10 +1397,12 @@ extern int as_mysql_suspend(mysql_conn_t *mysql_conn,
 		xstrfmtcat(query,
 			   "update \"%s_%s\" set "
 			   "time_suspended=%u-time_suspended, "
-			   "state=%d where job_db_inx=%u and time_end=0",
+			   "state=%d where job_db_inx=%u and time_end=0 "
+			   "and state!=%d",
 			   mysql_conn->cluster_name, step_table,
 			   (int)job_ptr->suspend_time,
-			   job_ptr->job_state, job_ptr->db_index);
+			   job_ptr->job_state, job_ptr->db_index,
+			   job_ptr->job_state);
 		rc = mysql_db_query(mysql_conn, query);
 		xfree(query);
 	}
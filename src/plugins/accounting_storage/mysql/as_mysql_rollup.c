@@ -43,6 +43,12 @@
 #include "src/common/parse_time.h"
 #include "src/common/slurm_time.h"
 
+/* Catching up on many hours (e.g. after the slurmdbd was down) splits
+ * the hourly rollup over up to HOURLY_ROLLUP_THREADS threads, each
+ * doing at least HOURLY_ROLLUP_MIN_HOURS hours on its own connection */
+#define HOURLY_ROLLUP_THREADS   4
+#define HOURLY_ROLLUP_MIN_HOURS 24
+
 enum {
 	TIME_ALLOC,
 	TIME_DOWN,
@@ -79,6 +85,14 @@ typedef struct {
 	time_t start;
 } local_cluster_usage_t;
 
+typedef struct {
+	char *cluster_name;
+	int conn;
+	time_t end;
+	int rc;
+	time_t start;
+} local_hour_rollup_t;
+
 typedef struct {
 	time_t end;
 	int id;
@@ -840,10 +854,8 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 	return c_usage;
 }
 
-extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
-				  char *cluster_name,
-				  time_t start, time_t end,
-				  uint16_t archive_data)
+static int _hourly_rollup(mysql_conn_t *mysql_conn, char *cluster_name,
+			  time_t start, time_t end)
 {
 	int rc = SLURM_SUCCESS;
 	int add_sec = 3600;
@@ -1558,6 +1570,117 @@ end_it:
 /* 	info("stop start %s", slurm_ctime2(&curr_start)); */
 /* 	info("stop end %s", slurm_ctime2(&curr_end)); */
 
+	return rc;
+}
+
+/* Each hour is rolled up on its own, so a range of hours can be done on
+ * a separate connection and committed by itself.  Redoing an hour just
+ * overwrites its rows, so if any thread fails the whole range is done
+ * again next time around. */
+static void *_hourly_rollup_thread(void *arg)
+{
+	local_hour_rollup_t *hour_rollup = (local_hour_rollup_t *)arg;
+	mysql_conn_t mysql_conn;
+
+	memset(&mysql_conn, 0, sizeof(mysql_conn_t));
+	mysql_conn.rollback = 1;
+	mysql_conn.conn = hour_rollup->conn;
+	slurm_mutex_init(&mysql_conn.lock);
+
+	hour_rollup->rc = check_connection(&mysql_conn);
+	if (hour_rollup->rc == SLURM_SUCCESS)
+		hour_rollup->rc = _hourly_rollup(&mysql_conn,
+						 hour_rollup->cluster_name,
+						 hour_rollup->start,
+						 hour_rollup->end);
+
+	if (hour_rollup->rc == SLURM_SUCCESS) {
+		if (mysql_db_commit(&mysql_conn)) {
+			error("Couldn't commit hourly rollup of cluster %s",
+			      hour_rollup->cluster_name);
+			hour_rollup->rc = SLURM_ERROR;
+		}
+	} else if (mysql_db_rollback(&mysql_conn))
+		error("rollback failed");
+
+	mysql_db_close_db_connection(&mysql_conn);
+	slurm_mutex_destroy(&mysql_conn.lock);
+
+	return NULL;
+}
+
+static int _hourly_rollup_threaded(mysql_conn_t *mysql_conn,
+				   char *cluster_name,
+				   time_t start, time_t end, int thread_cnt)
+{
+	local_hour_rollup_t hour_rollup[HOURLY_ROLLUP_THREADS];
+	pthread_t thread_id[HOURLY_ROLLUP_THREADS];
+	pthread_attr_t attr;
+	int hours = (end - start) / 3600, i, started = 0;
+	int rc = SLURM_SUCCESS;
+
+	debug("%s: rolling up %d hours using %d threads",
+	      cluster_name, hours, thread_cnt);
+
+	for (i = 0; i < thread_cnt; i++) {
+		hour_rollup[i].cluster_name = cluster_name;
+		hour_rollup[i].conn = mysql_conn->conn;
+		hour_rollup[i].start = start +
+			(time_t)(hours * i / thread_cnt) * 3600;
+		if (i == (thread_cnt - 1))
+			hour_rollup[i].end = end;
+		else
+			hour_rollup[i].end = start +
+				(time_t)(hours * (i + 1) / thread_cnt) * 3600;
+		hour_rollup[i].rc = SLURM_SUCCESS;
+
+		slurm_attr_init(&attr);
+		if (pthread_create(&thread_id[i], &attr,
+				   _hourly_rollup_thread, &hour_rollup[i])) {
+			error("pthread_create: %m");
+			slurm_attr_destroy(&attr);
+			break;
+		}
+		slurm_attr_destroy(&attr);
+		started++;
+	}
+
+	/* Whatever didn't get a thread is done here */
+	if (started < thread_cnt)
+		rc = _hourly_rollup(mysql_conn, cluster_name,
+				    hour_rollup[started].start, end);
+
+	for (i = 0; i < started; i++) {
+		pthread_join(thread_id[i], NULL);
+		if (hour_rollup[i].rc != SLURM_SUCCESS)
+			rc = hour_rollup[i].rc;
+	}
+
+	/* End the transaction so its snapshot includes what the threads
+	 * committed, the daily rollup reads it from here. */
+	if ((rc == SLURM_SUCCESS) && mysql_db_commit(mysql_conn))
+		rc = SLURM_ERROR;
+
+	return rc;
+}
+
+extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
+				  char *cluster_name,
+				  time_t start, time_t end,
+				  uint16_t archive_data)
+{
+	int rc, thread_cnt;
+
+	thread_cnt = ((end - start) / 3600) / HOURLY_ROLLUP_MIN_HOURS;
+	if (thread_cnt > HOURLY_ROLLUP_THREADS)
+		thread_cnt = HOURLY_ROLLUP_THREADS;
+
+	if (thread_cnt > 1)
+		rc = _hourly_rollup_threaded(mysql_conn, cluster_name,
+					     start, end, thread_cnt);
+	else
+		rc = _hourly_rollup(mysql_conn, cluster_name, start, end);
+
 	/* go check to see if we archive and purge */
 
 	if (rc == SLURM_SUCCESS)
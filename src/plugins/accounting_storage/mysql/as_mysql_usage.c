@@ -904,7 +904,7 @@ extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn,
 	pthread_cond_init(&rolledup_cond, NULL);
 
 	//START_TIMER;
-	slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 	itr = list_iterator_create(as_mysql_cluster_list);
 	while ((cluster_name = list_next(itr))) {
 		pthread_t rollup_tid;
@@ -951,7 +951,7 @@ extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn,
 	}
 	slurm_mutex_lock(&rolledup_lock);
 	list_iterator_destroy(itr);
-	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	while (rolledup < roll_started) {
 		pthread_cond_wait(&rolledup_cond, &rolledup_lock);
@@ -123,7 +123,7 @@ static int _make_sure_users_have_default(
 	if (!user_list)
 		return SLURM_SUCCESS;
 
-	slurm_mutex_lock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 
 	clus_itr = list_iterator_create(as_mysql_cluster_list);
 	itr = list_iterator_create(user_list);
@@ -190,7 +190,7 @@ static int _make_sure_users_have_default(
 	}
 	list_iterator_destroy(itr);
 	list_iterator_destroy(clus_itr);
-	slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	return rc;
 }
@@ -696,7 +696,7 @@ is_same_user:
 	user_name = uid_to_string((uid_t) uid);
 
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 
 	ret_list = list_create(slurm_destroy_char);
 	itr = list_iterator_create(use_cluster_list);
@@ -712,7 +712,7 @@ is_same_user:
 	xfree(user_name);
 
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	if (rc == SLURM_ERROR) {
 		list_destroy(ret_list);
@@ -759,7 +759,7 @@ empty:
 	user_name = uid_to_string((uid_t) uid);
 
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 	ret_list = list_create(slurm_destroy_char);
 	itr = list_iterator_create(use_cluster_list);
 	while ((object = list_next(itr))) {
@@ -773,7 +773,7 @@ empty:
 	xfree(user_name);
 
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	if (rc == SLURM_ERROR) {
 		list_destroy(ret_list);
@@ -843,7 +843,7 @@ empty:
 	wckey_list = list_create(slurmdb_destroy_wckey_rec);
 
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_lock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 	//START_TIMER;
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
@@ -858,7 +858,7 @@ empty:
 	list_iterator_destroy(itr);
 
 	if (use_cluster_list == as_mysql_cluster_list)
-		slurm_mutex_unlock(&as_mysql_cluster_list_lock);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
 	xfree(tmp);
 	xfree(extra);
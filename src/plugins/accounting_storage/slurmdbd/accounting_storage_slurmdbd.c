@@ -2683,6 +2683,73 @@ extern List jobacct_storage_p_get_jobs_cond(void *db_conn, uid_t uid,
 	return my_job_list;
 }
 
+/*
+ * get info from the storage a page at a time, calling callback for
+ * each job as it arrives rather than collecting them all in one List
+ */
+extern int jobacct_storage_p_get_jobs_cond_cb(
+	void *db_conn, uid_t uid, slurmdb_job_cond_t *job_cond,
+	int (*callback) (slurmdb_job_rec_t *job, void *arg), void *arg)
+{
+	slurmdbd_msg_t req, resp;
+	dbd_cond_msg_t get_msg;
+	dbd_list_msg_t *got_msg;
+	int rc = SLURM_SUCCESS;
+	bool done = false;
+
+	memset(&get_msg, 0, sizeof(dbd_cond_msg_t));
+
+	get_msg.cond = job_cond;
+
+	req.msg_type = DBD_GET_JOBS_PAGED;
+	req.data = &get_msg;
+	while (!done && (rc == SLURM_SUCCESS)) {
+		rc = slurm_send_recv_slurmdbd_msg(SLURM_PROTOCOL_VERSION,
+						  &req, &resp);
+		if (rc != SLURM_SUCCESS) {
+			error("slurmdbd: %s failure: %m",
+			      slurmdbd_msg_type_2_str(req.msg_type, 1));
+		} else if (resp.msg_type == DBD_RC) {
+			dbd_rc_msg_t *msg = resp.data;
+			if ((req.msg_type == DBD_GET_JOBS_PAGED) &&
+			    (msg->return_code == EINVAL) && !msg->sent_type) {
+				/* slurmdbd predates DBD_GET_JOBS_PAGED, have
+				 * the caller get the whole list instead */
+				slurmdbd_free_rc_msg(msg);
+				slurm_seterrno(ESLURM_NOT_SUPPORTED);
+				return SLURM_ERROR;
+			}
+			if (msg->return_code == SLURM_SUCCESS) {
+				info("%s", msg->comment);
+				done = true;
+			} else {
+				slurm_seterrno(msg->return_code);
+				error("%s", msg->comment);
+				rc = SLURM_ERROR;
+			}
+			slurmdbd_free_rc_msg(msg);
+		} else if (resp.msg_type != DBD_GOT_JOBS) {
+			error("slurmdbd: response type not DBD_GOT_JOBS: %u",
+			      resp.msg_type);
+			rc = SLURM_ERROR;
+		} else {
+			got_msg = (dbd_list_msg_t *) resp.data;
+			/* An empty page marks the end of the jobs */
+			if (!got_msg->my_list || !list_count(got_msg->my_list))
+				done = true;
+			else
+				rc = jobacct_storage_job_list_cb(
+					got_msg->my_list, callback, arg);
+			slurmdbd_free_list_msg(got_msg);
+		}
+
+		req.msg_type = DBD_GET_JOBS_NEXT;
+		req.data = NULL;
+	}
+
+	return rc;
+}
+
 /*
  * Expire old info from the storage
  * Not applicable for any database
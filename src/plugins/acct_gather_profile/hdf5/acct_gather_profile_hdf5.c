@@ -64,7 +64,11 @@
 #include "src/slurmd/common/proctrack.h"
 #include "hdf5_api.h"
 
-#define HDF5_CHUNK_SIZE 10
+/* Samples are kept in memory and appended to their table HDF5_CHUNK_SIZE at
+ * a time, or when the oldest one is older than ProfileHDF5FlushInterval, so
+ * each table is written one full chunk at a time. */
+#define HDF5_CHUNK_SIZE 64
+#define HDF5_FLUSH_INTERVAL 60
 /* Compression level, a value of 0 through 9. Level 0 is faster but offers the
  * least compression; level 9 is slower but offers maximum compression.
  * A setting of -1 indicates that no compression is desired. */
@@ -103,11 +107,15 @@ const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 typedef struct {
 	char *dir;
 	uint32_t def;
+	uint32_t flush_interval;
 } slurm_hdf5_conf_t;
 
 typedef struct {
 	hid_t  table_id;
 	size_t type_size;
+	uint8_t *buf;		/* HDF5_CHUNK_SIZE records not yet written */
+	size_t buf_cnt;
+	time_t buf_time;	/* sample time of the first buffered record */
 } table_t;
 
 // Global HDF5 Variables
@@ -137,6 +145,25 @@ static void _reset_slurm_profile_conf(void)
 {
 	xfree(hdf5_conf.dir);
 	hdf5_conf.def = ACCT_GATHER_PROFILE_NONE;
+	hdf5_conf.flush_interval = HDF5_FLUSH_INTERVAL;
+}
+
+/* Append the buffered records of a table to the HDF5 file */
+static int _flush_table(table_t *ds)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (!ds->buf_cnt)
+		return rc;
+
+	if (H5PTappend(ds->table_id, ds->buf_cnt, ds->buf) < 0) {
+		error("PROFILE: Impossible to add data to the table; "
+		      "maybe the table has not been created?");
+		rc = SLURM_ERROR;
+	}
+	ds->buf_cnt = 0;
+
+	return rc;
 }
 
 static uint32_t _determine_profile(void)
@@ -232,6 +259,10 @@ extern int init(void)
 
 extern int fini(void)
 {
+	size_t i;
+
+	for (i = 0; i < tables_cur_len; ++i)
+		xfree(tables[i].buf);
 	xfree(tables);
 	xfree(groups);
 	xfree(hdf5_conf.dir);
@@ -244,6 +275,7 @@ extern void acct_gather_profile_p_conf_options(s_p_options_t **full_options,
 	s_p_options_t options[] = {
 		{"ProfileHDF5Dir", S_P_STRING},
 		{"ProfileHDF5Default", S_P_STRING},
+		{"ProfileHDF5FlushInterval", S_P_UINT32},
 		{NULL} };
 
 	transfer_s_p_options(full_options, options, full_options_cnt);
@@ -266,6 +298,8 @@ extern void acct_gather_profile_p_conf_set(s_p_hashtbl_t *tbl)
 			}
 			xfree(tmp);
 		}
+		s_p_get_uint32(&hdf5_conf.flush_interval,
+			       "ProfileHDF5FlushInterval", tbl);
 	}
 
 	if (!hdf5_conf.dir)
@@ -410,10 +444,13 @@ extern int acct_gather_profile_p_node_step_end(void)
 	if (debug_flags & DEBUG_FLAG_PROFILE)
 		info("PROFILE: node_step_end (shutdown)");
 
-	/* close tables */
+	/* write what is left and close tables */
 	for (i = 0; i < tables_cur_len; ++i) {
+		_flush_table(&tables[i]);
 		H5PTclose(tables[i].table_id);
+		xfree(tables[i].buf);
 	}
+	tables_cur_len = 0;
 	/* close groups */
 	for (i = 0; i < groups_len; ++i) {
 		H5Gclose(groups[i]);
@@ -569,6 +606,9 @@ extern int acct_gather_profile_p_create_dataset(
 	/* reserve a new table */
 	tables[tables_cur_len].table_id  = table_id;
 	tables[tables_cur_len].type_size = type_size;
+	tables[tables_cur_len].buf = xmalloc(type_size * HDF5_CHUNK_SIZE);
+	tables[tables_cur_len].buf_cnt = 0;
+	tables[tables_cur_len].buf_time = 0;
 	++tables_cur_len;
 
 	return tables_cur_len - 1;
@@ -577,8 +617,8 @@ extern int acct_gather_profile_p_create_dataset(
 extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 						 time_t sample_time)
 {
-	table_t *ds = &tables[table_id];
-	uint8_t send_data[ds->type_size];
+	table_t *ds;
+	uint8_t *send_data;
 	int header_size = 0;
 	debug("acct_gather_profile_p_add_sample_data %d", table_id);
 
@@ -603,6 +643,11 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 	if (g_profile_running <= ACCT_GATHER_PROFILE_NONE)
 		return SLURM_ERROR;
 
+	ds = &tables[table_id];
+	if (!ds->buf_cnt)
+		ds->buf_time = sample_time;
+	send_data = ds->buf + (ds->buf_cnt * ds->type_size);
+
 	/* prepend timestampe and relative time */
 	((uint64_t *)send_data)[0] = difftime(sample_time, step_start_time);
 	header_size += sizeof(uint64_t);
@@ -610,13 +655,13 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 	header_size += sizeof(uint64_t);
 
 	memcpy(send_data + header_size, data, ds->type_size - header_size);
+	ds->buf_cnt++;
 
-	/* append the record to the table */
-	if (H5PTappend(ds->table_id, 1, send_data) < 0) {
-		error("PROFILE: Impossible to add data to the table %d; "
-		      "maybe the table has not been created?", table_id);
-		return SLURM_ERROR;
-	}
+	/* append the buffered records to the table */
+	if ((ds->buf_cnt == HDF5_CHUNK_SIZE) ||
+	    (difftime(sample_time, ds->buf_time) >=
+	     hdf5_conf.flush_interval))
+		return _flush_table(ds);
 
 	return SLURM_SUCCESS;
 }
@@ -637,6 +682,11 @@ extern void acct_gather_profile_p_conf_values(List *data)
 	key_pair->value = xstrdup(acct_gather_profile_to_string(hdf5_conf.def));
 	list_append(*data, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5FlushInterval");
+	key_pair->value = xstrdup_printf("%u", hdf5_conf.flush_interval);
+	list_append(*data, key_pair);
+
 	return;
 
 }
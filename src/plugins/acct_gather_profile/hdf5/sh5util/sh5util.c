@@ -60,10 +60,12 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 #include "src/common/uid.h"
 #include "src/common/read_config.h"
@@ -122,6 +124,24 @@ typedef struct table {
 	const char *name;
 } table_t;
 
+/* A node-step file to merge, read in memory ahead of time by a reader
+ * thread when merging with --parallel */
+typedef struct node_file {
+	char *path;
+	char *node;
+	void *image;
+	size_t size;
+	bool read;
+} node_file_t;
+
+/* Node-step files of the step being merged, shared with the reader threads */
+static pthread_mutex_t readers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t readers_cond = PTHREAD_COND_INITIALIZER;
+static node_file_t *node_files = NULL;
+static int node_files_cnt = 0;
+static int node_files_next = 0;		/* next file to read */
+static int node_files_merged = 0;	/* files merged so far */
+
 static FILE* output_file;
 static bool group_mode = false;
 static const char *current_step;
@@ -173,6 +193,8 @@ Usage sh5util [<OPTION>] -j <job[.stepid]>\n"
 "                      Default for extract is ./extract_$jobid.csv\n"
 " -p, --profiledir     Profile directory location where node-step files exist\n"
 "		               default is what is set in acct_gather.conf\n"
+" -P, --parallel       Number of node-step files to read concurrently while\n"
+"                      merging (default 1)\n"
 " -S, --savefiles      Don't remove node-step files after merging them \n"
 " --user               User who profiled job. (Handy for root user, defaults to \n"
 "		               user running this command.)\n"
@@ -288,6 +310,7 @@ static void _init_opts(void)
 	params.job_id = -1;
 	params.mode = SH5UTIL_MODE_MERGE;
 	params.step_id = -1;
+	params.parallel = 1;
 }
 
 static int _set_options(const int argc, char **argv)
@@ -309,6 +332,7 @@ static int _set_options(const int argc, char **argv)
 		{"list", no_argument, 0, 'L'},
 		{"node", required_argument, 0, 'N'},
 		{"output", required_argument, 0, 'o'},
+		{"parallel", required_argument, 0, 'P'},
 		{"profiledir", required_argument, 0, 'p'},
 		{"series", required_argument, 0, 's'},
 		{"savefiles", no_argument, 0, 'S'},
@@ -331,7 +355,7 @@ static int _set_options(const int argc, char **argv)
 
 	_init_opts();
 
-	while ((cc = getopt_long(argc, argv, "d:Ehi:Ij:l:LN:o:p:s:Su:UvV",
+	while ((cc = getopt_long(argc, argv, "d:Ehi:Ij:l:LN:o:p:P:s:Su:UvV",
 	                         long_options, &option_index)) != EOF) {
 		switch (cc) {
 			case 'd':
@@ -373,6 +397,14 @@ static int _set_options(const int argc, char **argv)
 			case 'p':
 				params.dir = xstrdup(optarg);
 				break;
+			case 'P':
+				params.parallel = strtol(optarg, NULL, 10);
+				if (params.parallel < 1) {
+					error("Bad value for --parallel=\"%s\"",
+					      optarg);
+					return -1;
+				}
+				break;
 			case 's':
 				if (strcmp(optarg, GRP_ENERGY)
 				    && strcmp(optarg, GRP_LUSTRE)
@@ -486,14 +518,21 @@ _check_params(void)
 }
 
 /* Copy the group "/{NodeName}" of the hdf5 file file_name into the location
- * jgid_nodes */
+ * jgid_nodes. If image is set it holds the content of file_name. */
 static int _merge_node_step_data(char* file_name, char* node_name,
-				 hid_t jgid_nodes, hid_t jgid_tasks)
+				 hid_t jgid_nodes, hid_t jgid_tasks,
+				 void *image, size_t size)
 {
 	hid_t fid_nodestep;
 	char group_name[MAX_GROUP_NAME+1];
 
-	fid_nodestep = H5Fopen(file_name, H5F_ACC_RDONLY, H5P_DEFAULT);
+	if (image)
+		fid_nodestep = H5LTopen_file_image(
+			image, size, H5LT_FILE_IMAGE_DONT_COPY |
+			H5LT_FILE_IMAGE_DONT_RELEASE);
+	else
+		fid_nodestep = H5Fopen(file_name, H5F_ACC_RDONLY,
+				       H5P_DEFAULT);
 	if (fid_nodestep < 0) {
 		error("Failed to open %s",file_name);
 		return SLURM_ERROR;
@@ -507,6 +546,7 @@ static int _merge_node_step_data(char* file_name, char* node_name,
 		debug("Failed to copy node step data of %s into the job file, "
 		      "trying with old method",
 		      node_name);
+		H5Fclose(fid_nodestep);
 		return SLURM_PROTOCOL_VERSION_ERROR;
 	}
 
@@ -518,6 +558,137 @@ static int _merge_node_step_data(char* file_name, char* node_name,
 	return SLURM_SUCCESS;
 }
 
+/* Read a whole file into memory, return NULL on error */
+static void *_read_file(char *path, size_t *size)
+{
+	struct stat st;
+	char *buf;
+	size_t offset = 0;
+	ssize_t len;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		error("Failed to open %s: %m", path);
+		return NULL;
+	}
+	if ((fstat(fd, &st) < 0) || (st.st_size <= 0)) {
+		close(fd);
+		return NULL;
+	}
+	buf = xmalloc_nz(st.st_size);
+	while (offset < st.st_size) {
+		len = read(fd, buf + offset, st.st_size - offset);
+		if (len <= 0) {
+			error("Failed to read %s: %m", path);
+			xfree(buf);
+			close(fd);
+			return NULL;
+		}
+		offset += len;
+	}
+	close(fd);
+	*size = st.st_size;
+
+	return buf;
+}
+
+/* Read node-step files in memory ahead of the merge, at most 2 files per
+ * thread ahead of the one being merged */
+static void *_reader_thread(void *arg)
+{
+	node_file_t *nf;
+	void *image;
+	size_t size = 0;
+	int i;
+
+	slurm_mutex_lock(&readers_mutex);
+	while (node_files_next < node_files_cnt) {
+		if (node_files_next >=
+		    (node_files_merged + (2 * params.parallel))) {
+			pthread_cond_wait(&readers_cond, &readers_mutex);
+			continue;
+		}
+		i = node_files_next++;
+		nf = &node_files[i];
+		slurm_mutex_unlock(&readers_mutex);
+
+		image = _read_file(nf->path, &size);
+
+		slurm_mutex_lock(&readers_mutex);
+		nf->image = image;
+		nf->size = size;
+		nf->read = true;
+		pthread_cond_broadcast(&readers_cond);
+	}
+	slurm_mutex_unlock(&readers_mutex);
+
+	return NULL;
+}
+
+/* Merge the node-step files of a step into jgid_nodes. HDF5 calls are kept
+ * in this thread, reader threads only read the files in memory. */
+static int _merge_node_files(hid_t jgid_nodes, hid_t jgid_tasks)
+{
+	pthread_attr_t attr;
+	pthread_t *threads = NULL;
+	node_file_t *nf;
+	int i, nthreads = 0, rc = SLURM_SUCCESS;
+
+	if (params.parallel > 1) {
+		nthreads = MIN(params.parallel, node_files_cnt);
+		threads = xmalloc(sizeof(pthread_t) * nthreads);
+		node_files_next = 0;
+		node_files_merged = 0;
+		slurm_attr_init(&attr);
+		for (i = 0; i < nthreads; i++) {
+			if (pthread_create(&threads[i], &attr,
+					   _reader_thread, NULL)) {
+				error("pthread_create error %m");
+				break;
+			}
+		}
+		nthreads = i;
+		slurm_attr_destroy(&attr);
+	}
+
+	for (i = 0; i < node_files_cnt; i++) {
+		nf = &node_files[i];
+		if (nthreads) {
+			slurm_mutex_lock(&readers_mutex);
+			while (!nf->read)
+				pthread_cond_wait(&readers_cond,
+						  &readers_mutex);
+			slurm_mutex_unlock(&readers_mutex);
+		}
+
+		debug("Adding %s to the job file", nf->path);
+		rc = _merge_node_step_data(nf->path, nf->node,
+					   jgid_nodes, jgid_tasks,
+					   nf->image, nf->size);
+		xfree(nf->image);
+
+		if (nthreads) {
+			slurm_mutex_lock(&readers_mutex);
+			node_files_merged++;
+			pthread_cond_broadcast(&readers_cond);
+			slurm_mutex_unlock(&readers_mutex);
+		}
+	}
+
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	xfree(threads);
+
+	for (i = 0; i < node_files_cnt; i++) {
+		xfree(node_files[i].path);
+		xfree(node_files[i].node);
+	}
+	xfree(node_files);
+	node_files_cnt = 0;
+
+	return rc;
+}
+
 /* Look for step and node files and merge them together into one job file */
 static int _merge_step_files(void)
 {
@@ -643,14 +814,19 @@ static int _merge_step_files(void)
 			}
 
 			sprintf(step_path, "%s/%s", step_dir, de->d_name);
-			debug("Adding %s to the job file", step_path);
-			rc = _merge_node_step_data(step_path, step_node,
-						   jgid_nodes, jgid_tasks);
+			xrealloc(node_files,
+				 sizeof(node_file_t) * (node_files_cnt + 1));
+			node_files[node_files_cnt].path = xstrdup(step_path);
+			node_files[node_files_cnt].node = xstrdup(step_node);
+			node_files_cnt++;
 			nodex++;
 		}
 
 		closedir(dir);
 
+		if (node_files_cnt)
+			rc = _merge_node_files(jgid_nodes, jgid_tasks);
+
 		if (nodex > 0) {
 			put_int_attribute(jgid_step, ATTR_NNODES, nodex);
 			H5Gclose(jgid_tasks);
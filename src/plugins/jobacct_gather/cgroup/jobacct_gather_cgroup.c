@@ -41,10 +41,12 @@
 
 #include <fcntl.h>
 #include <signal.h>
+#include <unistd.h>
 #include "src/common/slurm_xlator.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/slurm_acct_gather_energy.h"
+#include "src/common/slurm_acct_gather_profile.h"
 #include "src/common/xstring.h"
 #include "src/slurmd/common/proctrack.h"
 #include "src/slurmd/common/xcpuinfo.h"
@@ -96,13 +98,53 @@ const char plugin_name[] = "Job accounting gather cgroup plugin";
 const char plugin_type[] = "jobacct_gather/cgroup";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
+/* Counter files of a task cgroup, opened once when the task is added */
+typedef struct task_cg_fds {
+	int cpuacct_fd;		/* cpuacct.stat */
+	int memory_fd;		/* memory.stat */
+} task_cg_fds_t;
+
 /* Other useful declarations */
 static slurm_cgroup_conf_t slurm_cgroup_conf;
 
+static pthread_mutex_t task_fds_mutex = PTHREAD_MUTEX_INITIALIZER;
+static task_cg_fds_t *task_fds = NULL;	/* indexed by task id */
+static uint32_t task_fds_cnt = 0;
+
+static void _parse_cpuacct_stat(char *cpu_time, jag_prec_t *prec)
+{
+	unsigned long utime, stime;
+
+	if (sscanf(cpu_time, "%*s %lu %*s %lu", &utime, &stime) == 2) {
+		prec->usec = utime;
+		prec->ssec = stime;
+	}
+}
+
+static void _parse_memory_stat(char *memory_stat, jag_prec_t *prec)
+{
+	unsigned long total_rss, total_pgpgin;
+	char *ptr;
+
+	/* This number represents the amount of "dirty" private memory
+	   used by the cgroup.  From our experience this is slightly
+	   different than what proc presents, but is probably more
+	   accurate on what the user is actually using.
+	*/
+	if ((ptr = strstr(memory_stat, "total_rss")) &&
+	    (sscanf(ptr, "total_rss %lu", &total_rss) == 1))
+		prec->rss = total_rss / 1024; /* convert from bytes to KB */
+
+	/* total_pgmajfault is what is reported in proc, so we use
+	 * the same thing here. */
+	if ((ptr = strstr(memory_stat, "total_pgmajfault")) &&
+	    (sscanf(ptr, "total_pgmajfault %lu", &total_pgpgin) == 1))
+		prec->pages = total_pgpgin;
+}
+
 static void _prec_extra(jag_prec_t *prec)
 {
-	unsigned long utime, stime, total_rss, total_pgpgin;
-	char *cpu_time = NULL, *memory_stat = NULL, *ptr;
+	char *cpu_time = NULL, *memory_stat = NULL;
 	size_t cpu_time_size = 0, memory_stat_size = 0;
 
 	//DEF_TIMERS;
@@ -114,34 +156,16 @@ static void _prec_extra(jag_prec_t *prec)
 	if (cpu_time == NULL) {
 		debug2("%s: failed to collect cpuacct.stat pid %d ppid %d",
 		       __func__, prec->pid, prec->ppid);
-	} else {
-		sscanf(cpu_time, "%*s %lu %*s %lu", &utime, &stime);
-		prec->usec = utime;
-		prec->ssec = stime;
-	}
+	} else
+		_parse_cpuacct_stat(cpu_time, prec);
 
 	xcgroup_get_param(&task_memory_cg, "memory.stat",
 			  &memory_stat, &memory_stat_size);
 	if (memory_stat == NULL) {
 		debug2("%s: failed to collect memory.stat  pid %d ppid %d",
 		       __func__, prec->pid, prec->ppid);
-	} else {
-		/* This number represents the amount of "dirty" private memory
-		   used by the cgroup.  From our experience this is slightly
-		   different than what proc presents, but is probably more
-		   accurate on what the user is actually using.
-		*/
-		ptr = strstr(memory_stat, "total_rss");
-		sscanf(ptr, "total_rss %lu", &total_rss);
-		prec->rss = total_rss / 1024; /* convert from bytes to KB */
-
-		/* total_pgmajfault is what is reported in proc, so we use
-		 * the same thing here. */
-		if ((ptr = strstr(memory_stat, "total_pgmajfault"))) {
-			sscanf(ptr, "total_pgmajfault %lu", &total_pgpgin);
-			prec->pages = total_pgpgin;
-		}
-	}
+	} else
+		_parse_memory_stat(memory_stat, prec);
 
 	xfree(cpu_time);
 	xfree(memory_stat);
@@ -183,6 +207,114 @@ static void _prec_extra(jag_prec_t *prec)
 
 }
 
+/* Read the whole content of an already opened cgroup file into buf */
+static bool _pread_cg_file(int fd, char *buf, size_t size)
+{
+	ssize_t len;
+
+	if (fd < 0)
+		return false;
+	if ((len = pread(fd, buf, size - 1, 0)) <= 0)
+		return false;
+	buf[len] = '\0';
+	return true;
+}
+
+/*
+ * Build one jag_prec_t per task out of the counters of its task cgroup,
+ * without looking at the processes of the task. The cost of a poll only
+ * depends on the number of tasks.
+ */
+static List _get_cgroup_precs(List task_list, bool pgid_plugin,
+			      uint64_t cont_id, jag_callbacks_t *callbacks)
+{
+	List prec_list = list_create(destroy_jag_prec);
+	struct jobacctinfo *jobacct;
+	jag_prec_t *prec;
+	ListIterator itr;
+	uint32_t taskid;
+	char buf[4096];
+
+	if (!task_list)
+		return prec_list;
+
+	slurm_mutex_lock(&task_fds_mutex);
+	itr = list_iterator_create(task_list);
+	while ((jobacct = list_next(itr))) {
+		taskid = jobacct->id.taskid;
+		if (taskid >= task_fds_cnt)
+			continue;
+		prec = xmalloc(sizeof(jag_prec_t));
+		prec->pid = jobacct->pid;
+		prec->ppid = getpid();
+		if (_pread_cg_file(task_fds[taskid].cpuacct_fd,
+				   buf, sizeof(buf)))
+			_parse_cpuacct_stat(buf, prec);
+		else
+			debug2("%s: failed to read cpuacct.stat of task %u",
+			       __func__, taskid);
+		if (_pread_cg_file(task_fds[taskid].memory_fd,
+				   buf, sizeof(buf)))
+			_parse_memory_stat(buf, prec);
+		else
+			debug2("%s: failed to read memory.stat of task %u",
+			       __func__, taskid);
+		list_append(prec_list, prec);
+	}
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&task_fds_mutex);
+
+	return prec_list;
+}
+
+/* Open the counter files of the cgroups the task was just attached to */
+static void _open_task_fds(uint32_t taskid)
+{
+	char path[PATH_MAX];
+	uint32_t i;
+
+	slurm_mutex_lock(&task_fds_mutex);
+	if (taskid >= task_fds_cnt) {
+		xrealloc(task_fds, sizeof(task_cg_fds_t) * (taskid + 1));
+		for (i = task_fds_cnt; i <= taskid; i++) {
+			task_fds[i].cpuacct_fd = -1;
+			task_fds[i].memory_fd = -1;
+		}
+		task_fds_cnt = taskid + 1;
+	}
+
+	if (task_fds[taskid].cpuacct_fd >= 0)
+		close(task_fds[taskid].cpuacct_fd);
+	snprintf(path, sizeof(path), "%s/cpuacct.stat", task_cpuacct_cg.path);
+	if ((task_fds[taskid].cpuacct_fd =
+	     open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		debug2("%s: unable to open %s: %m", __func__, path);
+
+	if (task_fds[taskid].memory_fd >= 0)
+		close(task_fds[taskid].memory_fd);
+	snprintf(path, sizeof(path), "%s/memory.stat", task_memory_cg.path);
+	if ((task_fds[taskid].memory_fd =
+	     open(path, O_RDONLY | O_CLOEXEC)) < 0)
+		debug2("%s: unable to open %s: %m", __func__, path);
+	slurm_mutex_unlock(&task_fds_mutex);
+}
+
+static void _close_task_fds(void)
+{
+	uint32_t i;
+
+	slurm_mutex_lock(&task_fds_mutex);
+	for (i = 0; i < task_fds_cnt; i++) {
+		if (task_fds[i].cpuacct_fd >= 0)
+			close(task_fds[i].cpuacct_fd);
+		if (task_fds[i].memory_fd >= 0)
+			close(task_fds[i].memory_fd);
+	}
+	xfree(task_fds);
+	task_fds_cnt = 0;
+	slurm_mutex_unlock(&task_fds_mutex);
+}
+
 static bool _run_in_daemon(void)
 {
 	static bool set = false;
@@ -253,6 +385,7 @@ extern int init (void)
 extern int fini (void)
 {
 	if (_run_in_daemon()) {
+		_close_task_fds();
 		jobacct_gather_cgroup_cpuacct_fini(&slurm_cgroup_conf);
 		jobacct_gather_cgroup_memory_fini(&slurm_cgroup_conf);
 		/* jobacct_gather_cgroup_blkio_fini(&slurm_cgroup_conf); */
@@ -286,13 +419,26 @@ extern void jobacct_gather_p_poll_data(
 {
 	static jag_callbacks_t callbacks;
 	static bool first = 1;
+	static bool no_proc_scan = false;
 
 	if (first) {
+		char *acct_params = slurm_get_jobacct_gather_params();
+		if (acct_params && strstr(acct_params, "NoProcScan"))
+			no_proc_scan = true;
+		xfree(acct_params);
+
 		memset(&callbacks, 0, sizeof(jag_callbacks_t));
 		first = 0;
 		callbacks.prec_extra = _prec_extra;
 	}
 
+	/* Task profiling records data only found in /proc */
+	if (no_proc_scan &&
+	    !acct_gather_profile_g_is_active(ACCT_GATHER_PROFILE_TASK))
+		callbacks.get_precs = _get_cgroup_precs;
+	else
+		callbacks.get_precs = NULL;
+
 	jag_common_poll_data(task_list, pgid_plugin, cont_id, &callbacks,
 			     profile);
 
@@ -316,6 +462,8 @@ extern int jobacct_gather_p_add_task(pid_t pid, jobacct_id_t *jobacct_id)
 	    SLURM_SUCCESS)
 		return SLURM_ERROR;
 
+	_open_task_fds(jobacct_id->taskid);
+
 	/* if (jobacct_gather_cgroup_blkio_attach_task(pid, jobacct_id) != */
 	/*     SLURM_SUCCESS) */
 	/* 	return SLURM_ERROR; */
@@ -39,10 +39,14 @@
 \*****************************************************************************/
 
 #include <dirent.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
 #include <time.h>
 #include <ctype.h>
+#include <stdlib.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 
 #include "src/common/slurm_xlator.h"
 #include "src/common/slurm_jobacct_gather.h"
@@ -54,11 +58,51 @@
 
 #include "common_jag.h"
 
+/*
+ * With proctrack/pgid every slurmstepd needs the stat of every process on
+ * the node. One slurmstepd per interval reads /proc and leaves the result
+ * here for the others, see _get_node_precs(). The file is kept in a
+ * directory only its owner can write, so no one else can plant a link
+ * under its name, see _open_proc_sample().
+ */
+#define PROC_SAMPLE_DIR		"/dev/shm/slurm"
+#define PROC_SAMPLE_FILE	PROC_SAMPLE_DIR "/proc_sample"
+#define PROC_SAMPLE_MAX_AGE	1	/* seconds */
+
+typedef struct proc_sample_hdr {
+	uint16_t version;	/* SLURM_PROTOCOL_VERSION of the writer */
+	uint16_t rec_size;	/* sizeof(jag_prec_t) of the writer */
+	uint32_t rec_cnt;
+	time_t sample_time;
+} proc_sample_hdr_t;
+
+/*
+ * Reading smaps is expensive for processes with many mappings, so with
+ * JobAcctGatherParams=PssInterval=<sec> the PSS of a process is only read
+ * again once that interval has passed or its RSS changed by more than
+ * PSS_RSS_CHANGE percent.
+ */
+#define PSS_RSS_CHANGE	10	/* percent */
+
+typedef struct pss_cache {
+	pid_t pid;
+	pid_t ppid;
+	uint64_t rss;		/* RSS when the PSS was read */
+	uint64_t pss;
+	time_t read_time;
+	uint32_t poll;		/* last poll the process was seen in */
+} pss_cache_t;
+
+static List pss_cache = NULL;
+static uint32_t pss_poll = 0;
+static int pss_interval = 0;
+
 static int cpunfo_frequency = 0;
 static long hertz = 0;
 
 static int my_pagesize = 0;
 static DIR  *slash_proc = NULL;
+static bool pgid_proctrack = false;
 static int energy_profile = ENERGY_DATA_JOULES_TASK;
 static uint64_t debug_flags = 0;
 
@@ -109,17 +153,83 @@ static char *_skipdot (char *str)
 	return str;
 }
 
+static int _find_pss_cache(void *x, void *key)
+{
+	pss_cache_t *cache = (pss_cache_t *) x;
+	jag_prec_t *prec = (jag_prec_t *) key;
+
+	if ((cache->pid == prec->pid) && (cache->ppid == prec->ppid))
+		return 1;
+
+	return 0;
+}
+
+static int _purge_pss_cache(void *x, void *key)
+{
+	pss_cache_t *cache = (pss_cache_t *) x;
+
+	if (cache->poll != pss_poll)
+		return 1;
+
+	return 0;
+}
+
+static void _destroy_pss_cache(void *x)
+{
+	xfree(x);
+}
+
+/* Return true if the RSS of prec is still close to the one cached */
+static bool _pss_cache_valid(pss_cache_t *cache, jag_prec_t *prec,
+			     time_t now)
+{
+	uint64_t diff;
+
+	if ((now - cache->read_time) >= pss_interval)
+		return false;
+	if (prec->rss > cache->rss)
+		diff = prec->rss - cache->rss;
+	else
+		diff = cache->rss - prec->rss;
+	if ((diff * 100) > (cache->rss * PSS_RSS_CHANGE))
+		return false;
+
+	return true;
+}
+
 /*
- * collects the Pss value from /proc/<pid>/smaps
+ * collects the Pss value from /proc/<pid>/smaps_rollup, or from
+ * /proc/<pid>/smaps on kernels without it
  */
-static int _get_pss(char *proc_smaps_file, jag_prec_t *prec)
+static int _get_pss(jag_prec_t *prec)
 {
+	static int have_smaps_rollup = -1;
+	char proc_smaps_file[256];	/* Allow ~20x extra length */
+	pss_cache_t *cache = NULL;
+	time_t now = 0;
         uint64_t pss;
 	uint64_t p;
         char line[128];
         FILE *fp;
 	int i;
 
+	if (pss_interval) {
+		now = time(NULL);
+		if (!pss_cache)
+			pss_cache = list_create(_destroy_pss_cache);
+		cache = list_find_first(pss_cache, _find_pss_cache, prec);
+		if (cache && _pss_cache_valid(cache, prec, now)) {
+			cache->poll = pss_poll;
+			pss = cache->pss;
+			goto done;
+		}
+	}
+
+	if (have_smaps_rollup == -1)
+		have_smaps_rollup = !access("/proc/self/smaps_rollup", R_OK);
+	snprintf(proc_smaps_file, sizeof(proc_smaps_file), "/proc/%d/%s",
+		 prec->pid, have_smaps_rollup ? "smaps_rollup" : "smaps");
+
 	fp = fopen(proc_smaps_file, "r");
         if (!fp) {
                 return -1;
@@ -156,14 +266,29 @@ static int _get_pss(char *proc_smaps_file, jag_prec_t *prec)
 	}
 
         fclose(fp);
+
+	debug3("%s: read pss %"PRIu64" for process %s",
+	       __func__, pss, proc_smaps_file);
+
+	if (pss_interval) {
+		if (!cache) {
+			cache = xmalloc(sizeof(pss_cache_t));
+			cache->pid = prec->pid;
+			cache->ppid = prec->ppid;
+			list_append(pss_cache, cache);
+		}
+		cache->rss = prec->rss;
+		cache->pss = pss;
+		cache->read_time = now;
+		cache->poll = pss_poll;
+	}
+
+done:
         /* Sanity checks */
         if (pss > 0 && prec->rss > pss) {
                 prec->rss = pss;
         }
 
-	debug3("%s: read pss %"PRIu64" for process %s",
-	       __func__, pss, proc_smaps_file);
-
         return 0;
 }
 
@@ -266,6 +391,7 @@ static int _is_a_lwp(uint32_t pid) {
 /* _get_process_data_line() - get line of data from /proc/<pid>/stat
  *
  * IN:	in - input file descriptor
+ * IN:	check_lwp - skip the process if it is a Light Weight Process
  * OUT:	prec - the destination for the data
  *
  * RETVAL:	==0 - no valid data
@@ -276,7 +402,7 @@ static int _is_a_lwp(uint32_t pid) {
  * embedded ')'s. Such names confuse %s (see scanf(3)), so the string is split
  * and %39c is used instead. (except for embedded ')' "(%[^)]c)" would work.
  */
-static int _get_process_data_line(int in, jag_prec_t *prec) {
+static int _get_process_data_line(int in, jag_prec_t *prec, bool check_lwp) {
 	char sbuf[256], *tmp;
 	int num_read, nvals;
 	char cmd[40], state[1];
@@ -319,11 +445,12 @@ static int _get_process_data_line(int in, jag_prec_t *prec) {
 
 	/* If current pid corresponds to a Light Weight Process (Thread POSIX) */
 	/* skip it, we will only account the original process (pid==tgid) */
-	if (_is_a_lwp(prec->pid) > 0)
+	if (check_lwp && (_is_a_lwp(prec->pid) > 0))
 		return 0;
 
 	/* Copy the values that slurm records into our data structure */
 	prec->ppid  = ppid;
+	prec->pgid  = pgrp;
 	prec->pages = majflt;
 	prec->usec  = utime;
 	prec->ssec  = stime;
@@ -431,15 +558,19 @@ static int _get_process_io_data_line(int in, jag_prec_t *prec) {
 	return 1;
 }
 
-static void _handle_stats(List prec_list, char *proc_stat_file, char *proc_io_file,
-			  char *proc_smaps_file, jag_callbacks_t *callbacks)
+/*
+ * Read the data of a process beyond /proc/<pid>/stat, as configured by
+ * JobAcctGatherParams.
+ * RET false if the process should not be accounted
+ */
+static bool _get_prec_extra(jag_prec_t *prec, jag_callbacks_t *callbacks)
 {
 	static int no_share_data = -1;
 	static int use_pss = -1;
-	FILE *stat_fp = NULL;
+	char proc_file[256];	/* Allow ~20x extra length */
 	FILE *io_fp = NULL;
-	int fd, fd2;
-	jag_prec_t *prec = NULL;
+	char *tmp;
+	int fd2;
 
 	if (no_share_data == -1) {
 		char *acct_params = slurm_get_jobacct_gather_params();
@@ -452,11 +583,46 @@ static void _handle_stats(List prec_list, char *proc_stat_file, char *proc_io_fi
 			use_pss = 1;
 		else
 			use_pss = 0;
+
+		if (acct_params &&
+		    (tmp = strstr(acct_params, "PssInterval=")))
+			pss_interval = atoi(tmp + strlen("PssInterval="));
 		xfree(acct_params);
 	}
 
+	/* Remove shared data from rss */
+	if (no_share_data) {
+		snprintf(proc_file, sizeof(proc_file), "/proc/%d/stat",
+			 prec->pid);
+		_remove_share_data(proc_file, prec);
+	}
+
+	/* Use PSS instead if RSS */
+	if (use_pss && (_get_pss(prec) == -1))
+		return false;
+
+	snprintf(proc_file, sizeof(proc_file), "/proc/%d/io", prec->pid);
+	if ((io_fp = fopen(proc_file, "r"))) {
+		fd2 = fileno(io_fp);
+		fcntl(fd2, F_SETFD, FD_CLOEXEC);
+		_get_process_io_data_line(fd2, prec);
+		fclose(io_fp);
+	}
+	if (callbacks->prec_extra)
+		(*(callbacks->prec_extra))(prec);
+
+	return true;
+}
+
+/* Read /proc/<pid>/stat into a new jag_prec_t, NULL if it is not valid */
+static jag_prec_t *_get_prec(char *proc_stat_file, bool check_lwp)
+{
+	FILE *stat_fp = NULL;
+	jag_prec_t *prec = NULL;
+	int fd;
+
 	if (!(stat_fp = fopen(proc_stat_file, "r")))
-		return;  /* Assume the process went away */
+		return NULL;  /* Assume the process went away */
 	/*
 	 * Close the file on exec() of user tasks.
 	 *
@@ -471,52 +637,235 @@ static void _handle_stats(List prec_list, char *proc_stat_file, char *proc_io_fi
 	fcntl(fd, F_SETFD, FD_CLOEXEC);
 
 	prec = xmalloc(sizeof(jag_prec_t));
-	if (!_get_process_data_line(fd, prec)) {
+	if (!_get_process_data_line(fd, prec, check_lwp))
+		xfree(prec);
+	fclose(stat_fp);
+
+	return prec;
+}
+
+static void _handle_stats(List prec_list, pid_t pid,
+			  jag_callbacks_t *callbacks)
+{
+	char proc_stat_file[256];	/* Allow ~20x extra length */
+	jag_prec_t *prec = NULL;
+
+	snprintf(proc_stat_file, sizeof(proc_stat_file), "/proc/%d/stat", pid);
+	if (!(prec = _get_prec(proc_stat_file, true)))
+		return;
+	if (!_get_prec_extra(prec, callbacks)) {
 		xfree(prec);
-		fclose(stat_fp);
 		return;
 	}
-	fclose(stat_fp);
+	list_append(prec_list, prec);
+}
 
-	/* Remove shared data from rss */
-	if (no_share_data)
-		_remove_share_data(proc_stat_file, prec);
+/* Read /proc/<pid>/stat of every process on the node */
+static List _get_all_precs(void)
+{
+	List prec_list = list_create(destroy_jag_prec);
+	static int slash_proc_open = 0;
+	struct dirent *slash_proc_entry;
+	char proc_stat_file[256];	/* Allow ~20x extra length */
+	char *iptr = NULL, *optr = NULL;
+	jag_prec_t *prec;
+	int i;
 
-	/* Use PSS instead if RSS */
-	if (use_pss) {
-		if (_get_pss(proc_smaps_file, prec) == -1) {
-			xfree(prec);
-			return;
+	if (slash_proc_open) {
+		rewinddir(slash_proc);
+	} else {
+		slash_proc=opendir("/proc");
+		if (slash_proc == NULL) {
+			perror("opening /proc");
+			return prec_list;
 		}
+		slash_proc_open=1;
 	}
+	strcpy(proc_stat_file, "/proc/");
 
-	list_append(prec_list, prec);
+	while ((slash_proc_entry = readdir(slash_proc))) {
 
-	if ((io_fp = fopen(proc_io_file, "r"))) {
-		fd2 = fileno(io_fp);
-		fcntl(fd2, F_SETFD, FD_CLOEXEC);
-		_get_process_io_data_line(fd2, prec);
-		fclose(io_fp);
+		/* Save a few cyles by simulating
+		 * strcat(statFileName, slash_proc_entry->d_name);
+		 * strcat(statFileName, "/stat");
+		 * while checking for a numeric filename (which really
+		 * should be a pid).
+		 */
+		optr = proc_stat_file + sizeof("/proc");
+		iptr = slash_proc_entry->d_name;
+		i = 0;
+		do {
+			if ((*iptr < '0') ||
+			    ((*optr++ = *iptr++) > '9')) {
+				i = -1;
+				break;
+			}
+		} while (*iptr);
+
+		if (i == -1)
+			continue;
+		iptr = (char*)"/stat";
+
+		do {
+			*optr++ = *iptr++;
+		} while (*iptr);
+		*optr = 0;
+
+		/* Threads are not listed in /proc, no need to check for
+		 * Light Weight Processes */
+		if ((prec = _get_prec(proc_stat_file, false)))
+			list_append(prec_list, prec);
 	}
-	if (callbacks->prec_extra)
-		(*(callbacks->prec_extra))(prec);
+
+	return prec_list;
+}
+
+/*
+ * Open PROC_SAMPLE_FILE, creating it and PROC_SAMPLE_DIR as needed.
+ * Return -1 unless both belong to us and no one else can write them or
+ * link to the file.
+ */
+static int _open_proc_sample(void)
+{
+	struct stat stat_buf;
+	int fd;
+
+	if ((mkdir(PROC_SAMPLE_DIR, S_IRWXU) < 0) && (errno != EEXIST))
+		return -1;
+	/* /dev/shm is sticky, so once checked the directory stays ours */
+	if (lstat(PROC_SAMPLE_DIR, &stat_buf) ||
+	    !S_ISDIR(stat_buf.st_mode) || (stat_buf.st_uid != geteuid()) ||
+	    (stat_buf.st_mode & (S_IRWXG | S_IRWXO))) {
+		debug("%s: %s is not a private directory, not sharing "
+		      "process samples", __func__, PROC_SAMPLE_DIR);
+		return -1;
+	}
+
+	fd = open(PROC_SAMPLE_FILE, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC,
+		  S_IRUSR | S_IWUSR);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &stat_buf) || !S_ISREG(stat_buf.st_mode) ||
+	    (stat_buf.st_nlink != 1) || (stat_buf.st_uid != geteuid()) ||
+	    (stat_buf.st_mode & (S_IWGRP | S_IWOTH))) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*
+ * Return the jag_prec_t of every process on the node, read from /proc
+ * at most PROC_SAMPLE_MAX_AGE seconds ago. The sample is shared with the
+ * other slurmstepds of the node through PROC_SAMPLE_FILE, so /proc is
+ * only read once per interval rather than once per step.
+ */
+static List _get_node_precs(void)
+{
+	proc_sample_hdr_t hdr;
+	List prec_list = NULL;
+	jag_prec_t *prec, *recs = NULL;
+	ListIterator itr;
+	time_t now;
+	int fd, i;
+
+	if ((fd = _open_proc_sample()) < 0)
+		return _get_all_precs();
+	if (flock(fd, LOCK_EX)) {
+		close(fd);
+		return _get_all_precs();
+	}
+
+	now = time(NULL);
+	if ((read(fd, &hdr, sizeof(hdr)) == sizeof(hdr)) &&
+	    (hdr.version == SLURM_PROTOCOL_VERSION) &&
+	    (hdr.rec_size == sizeof(jag_prec_t)) &&
+	    (hdr.sample_time <= now) &&
+	    ((now - hdr.sample_time) <= PROC_SAMPLE_MAX_AGE)) {
+		recs = xmalloc(sizeof(jag_prec_t) * (hdr.rec_cnt + 1));
+		if (read(fd, recs, sizeof(jag_prec_t) * hdr.rec_cnt) ==
+		    (sizeof(jag_prec_t) * hdr.rec_cnt)) {
+			prec_list = list_create(destroy_jag_prec);
+			for (i = 0; i < hdr.rec_cnt; i++) {
+				prec = xmalloc(sizeof(jag_prec_t));
+				memcpy(prec, &recs[i], sizeof(jag_prec_t));
+				list_append(prec_list, prec);
+			}
+		}
+		xfree(recs);
+	}
+
+	if (!prec_list) {
+		prec_list = _get_all_precs();
+		hdr.version = SLURM_PROTOCOL_VERSION;
+		hdr.rec_size = sizeof(jag_prec_t);
+		hdr.rec_cnt = list_count(prec_list);
+		hdr.sample_time = now;
+		recs = xmalloc(sizeof(jag_prec_t) * (hdr.rec_cnt + 1));
+		i = 0;
+		itr = list_iterator_create(prec_list);
+		while ((prec = list_next(itr)))
+			memcpy(&recs[i++], prec, sizeof(jag_prec_t));
+		list_iterator_destroy(itr);
+		if ((ftruncate(fd, 0) < 0) ||
+		    (pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) ||
+		    (pwrite(fd, recs, sizeof(jag_prec_t) * hdr.rec_cnt,
+			    sizeof(hdr)) != (sizeof(jag_prec_t) * hdr.rec_cnt)))
+			debug("%s: unable to write %s: %m", __func__,
+			      PROC_SAMPLE_FILE);
+		xfree(recs);
+	}
+
+	flock(fd, LOCK_UN);
+	close(fd);
+	return prec_list;
+}
+
+/*
+ * Remove from prec_list every process which is not in process group pgid
+ * (if pgid is not zero), then read the rest of their data.
+ */
+static void _keep_pgid_precs(List prec_list, pid_t pgid,
+			     jag_callbacks_t *callbacks)
+{
+	jag_prec_t *prec;
+	ListIterator itr;
+
+	itr = list_iterator_create(prec_list);
+	while ((prec = list_next(itr))) {
+		if ((pgid && (prec->pgid != pgid)) ||
+		    !_get_prec_extra(prec, callbacks))
+			list_delete_item(itr);
+	}
+	list_iterator_destroy(itr);
 }
 
 static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 		       jag_callbacks_t *callbacks)
 {
-	List prec_list = list_create(destroy_jag_prec);
-	char	proc_stat_file[256];	/* Allow ~20x extra length */
-	char	proc_io_file[256];	/* Allow ~20x extra length */
-	char	proc_smaps_file[256];	/* Allow ~20x extra length */
-	static	int	slash_proc_open = 0;
+	List prec_list;
 	int i;
 
+	pss_poll++;
 	if (!pgid_plugin) {
 		pid_t *pids = NULL;
 		int npids = 0;
-		/* get only the processes in the proctrack container */
-		proctrack_g_get_pids(cont_id, &pids, &npids);
+
+		if (pgid_proctrack) {
+			/*
+			 * The container is a process group, take its members
+			 * from the sample shared by the node's slurmstepds
+			 * rather than from another walk of /proc.
+			 */
+			prec_list = _get_node_precs();
+			_keep_pgid_precs(prec_list, (pid_t)cont_id, callbacks);
+			npids = list_count(prec_list);
+		} else {
+			prec_list = list_create(destroy_jag_prec);
+			/* get only the processes in the proctrack container */
+			proctrack_g_get_pids(cont_id, &pids, &npids);
+		}
 		if (!npids) {
 			/* update consumed energy even if pids do not exist */
 			struct jobacctinfo *jobacct = NULL;
@@ -529,107 +878,19 @@ static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 			}
 
 			debug4("no pids in this container %"PRIu64"", cont_id);
-			goto finished;
-		}
-		for (i = 0; i < npids; i++) {
-			snprintf(proc_stat_file, 256, "/proc/%d/stat", pids[i]);
-			snprintf(proc_io_file, 256, "/proc/%d/io", pids[i]);
-			snprintf(proc_smaps_file, 256, "/proc/%d/smaps", pids[i]);
-			_handle_stats(prec_list, proc_stat_file, proc_io_file,
-				      proc_smaps_file, callbacks);
+			return prec_list;
 		}
+		for (i = 0; pids && (i < npids); i++)
+			_handle_stats(prec_list, pids[i], callbacks);
 		xfree(pids);
 	} else {
-		struct dirent *slash_proc_entry;
-		char  *iptr = NULL, *optr = NULL, *optr2 = NULL;
-
-		if (slash_proc_open) {
-			rewinddir(slash_proc);
-		} else {
-			slash_proc=opendir("/proc");
-			if (slash_proc == NULL) {
-				perror("opening /proc");
-				goto finished;
-			}
-			slash_proc_open=1;
-		}
-		strcpy(proc_stat_file, "/proc/");
-		strcpy(proc_io_file, "/proc/");
-		strcpy(proc_smaps_file, "/proc/");
-
-		while ((slash_proc_entry = readdir(slash_proc))) {
-
-			/* Save a few cyles by simulating
-			 * strcat(statFileName, slash_proc_entry->d_name);
-			 * strcat(statFileName, "/stat");
-			 * while checking for a numeric filename (which really
-			 * should be a pid). Then do the same for the
-			 * /proc/<pid>/io file name.
-			 */
-			optr = proc_stat_file + sizeof("/proc");
-			iptr = slash_proc_entry->d_name;
-			i = 0;
-			do {
-				if ((*iptr < '0') ||
-				    ((*optr++ = *iptr++) > '9')) {
-					i = -1;
-					break;
-				}
-			} while (*iptr);
-
-			if (i == -1)
-				continue;
-			iptr = (char*)"/stat";
-
-			do {
-				*optr++ = *iptr++;
-			} while (*iptr);
-			*optr = 0;
-
-			optr2 = proc_io_file + sizeof("/proc");
-			iptr = slash_proc_entry->d_name;
-			i = 0;
-			do {
-				if ((*iptr < '0') ||
-				    ((*optr2++ = *iptr++) > '9')) {
-					i = -1;
-					break;
-				}
-			} while (*iptr);
-			if (i == -1)
-				continue;
-			iptr = (char*)"/io";
-
-			do {
-				*optr2++ = *iptr++;
-			} while (*iptr);
-			*optr2 = 0;
-
-			optr2 = proc_smaps_file + sizeof("/proc");
-			iptr = slash_proc_entry->d_name;
-			i = 0;
-			do {
-				if ((*iptr < '0') ||
-				    ((*optr2++ = *iptr++) > '9')) {
-					i = -1;
-					break;
-				}
-			} while (*iptr);
-			if (i == -1)
-				continue;
-			iptr = (char*)"/smaps";
-
-			do {
-				*optr2++ = *iptr++;
-			} while (*iptr);
-			*optr2 = 0;
-
-			_handle_stats(prec_list, proc_stat_file, proc_io_file,
-				      proc_smaps_file,callbacks);
-		}
+		prec_list = _get_node_precs();
+		_keep_pgid_precs(prec_list, 0, callbacks);
 	}
 
-finished:
+	/* Forget the processes which went away */
+	if (pss_cache)
+		list_delete_all(pss_cache, _purge_pss_cache, NULL);
 
 	return prec_list;
 }
@@ -730,6 +991,7 @@ static void _record_profile(struct jobacctinfo *jobacct)
 extern void jag_common_init(long in_hertz)
 {
 	uint32_t profile_opt;
+	char *type;
 
 	debug_flags = slurm_get_debug_flags();
 
@@ -753,12 +1015,18 @@ extern void jag_common_init(long in_hertz)
 	}
 
 	my_pagesize = getpagesize() / 1024;
+
+	type = slurm_get_proctrack_type();
+	if (!xstrcasecmp(type, "proctrack/pgid"))
+		pgid_proctrack = true;
+	xfree(type);
 }
 
 extern void jag_common_fini(void)
 {
 	if (slash_proc)
 		(void) closedir(slash_proc);
+	FREE_NULL_LIST(pss_cache);
 }
 
 extern void destroy_jag_prec(void *object)
@@ -51,6 +51,7 @@ typedef struct jag_prec {	/* process record */
 	int     pages;  /* pages */
 	pid_t	pid;
 	pid_t	ppid;
+	pid_t	pgid;
 	uint64_t rss;	/* rss */
 	int     ssec;   /* system cpu time */
 	int     usec;   /* user cpu time */
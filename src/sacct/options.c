@@ -417,62 +417,68 @@ void _init_params()
 	params.job_cond->without_usage_truncation = 1;
 }
 
-int get_data(void)
+/* Set the uid and sum the step usage into the job record */
+static void _aggregate_job(slurmdb_job_rec_t *job)
 {
-	slurmdb_job_rec_t *job = NULL;
 	slurmdb_step_rec_t *step = NULL;
-	ListIterator itr = NULL;
 	ListIterator itr_step = NULL;
-	slurmdb_job_cond_t *job_cond = params.job_cond;
 
-	if (params.opt_completion) {
-		jobs = g_slurm_jobcomp_get_jobs(job_cond);
-		return SLURM_SUCCESS;
-	} else {
-		jobs = slurmdb_jobs_get(acct_db_conn, job_cond);
+	if (job->user) {
+		struct	passwd *pw = NULL;
+		if ((pw=getpwnam(job->user)))
+			job->uid = pw->pw_uid;
 	}
 
-	if (!jobs)
-		return SLURM_ERROR;
+	if (!job->steps || !list_count(job->steps))
+		return;
 
-	itr = list_iterator_create(jobs);
-	while((job = list_next(itr))) {
-		if (job->user) {
-			struct	passwd *pw = NULL;
-			if ((pw=getpwnam(job->user)))
-				job->uid = pw->pw_uid;
-		}
+	itr_step = list_iterator_create(job->steps);
+	while((step = list_next(itr_step)) != NULL) {
+		/* now aggregate the aggregatable */
 
-		if (!job->steps || !list_count(job->steps))
+		if (step->state < JOB_COMPLETE)
 			continue;
-
-		itr_step = list_iterator_create(job->steps);
-		while((step = list_next(itr_step)) != NULL) {
-			/* now aggregate the aggregatable */
-
-			if (step->state < JOB_COMPLETE)
-				continue;
-			job->tot_cpu_sec += step->tot_cpu_sec;
-			job->tot_cpu_usec += step->tot_cpu_usec;
-			job->user_cpu_sec +=
-				step->user_cpu_sec;
-			job->user_cpu_usec +=
-				step->user_cpu_usec;
-			job->sys_cpu_sec +=
-				step->sys_cpu_sec;
-			job->sys_cpu_usec +=
-				step->sys_cpu_usec;
-
-			/* get the max for all the sacct_t struct */
-			aggregate_stats(&job->stats, &step->stats);
-		}
-		list_iterator_destroy(itr_step);
+		job->tot_cpu_sec += step->tot_cpu_sec;
+		job->tot_cpu_usec += step->tot_cpu_usec;
+		job->user_cpu_sec +=
+			step->user_cpu_sec;
+		job->user_cpu_usec +=
+			step->user_cpu_usec;
+		job->sys_cpu_sec +=
+			step->sys_cpu_sec;
+		job->sys_cpu_usec +=
+			step->sys_cpu_usec;
+
+		/* get the max for all the sacct_t struct */
+		aggregate_stats(&job->stats, &step->stats);
 	}
-	list_iterator_destroy(itr);
+	list_iterator_destroy(itr_step);
+}
+
+/* Print each job as it comes back from the storage */
+static int _get_job(slurmdb_job_rec_t *job, void *arg)
+{
+	_aggregate_job(job);
+	do_list(job);
 
 	return SLURM_SUCCESS;
 }
 
+int get_data(void)
+{
+	slurmdb_job_cond_t *job_cond = params.job_cond;
+
+	if (params.opt_completion) {
+		jobs = g_slurm_jobcomp_get_jobs(job_cond);
+		return SLURM_SUCCESS;
+	}
+
+	/* The jobs are printed as they arrive rather than gathered in a
+	 * list first, so even a very large query is shown without ever
+	 * holding all of it in memory. */
+	return slurmdb_jobs_get_cb(acct_db_conn, job_cond, _get_job, NULL);
+}
+
 void parse_command_line(int argc, char **argv)
 {
 	extern int optind;
@@ -1101,51 +1107,42 @@ void do_help(void)
 	}
 }
 
-/* do_list() -- List the assembled data
+/* do_list() -- List a job
  *
- * In:	Nothing explicit.
+ * In:	The job, with its steps already aggregated.
  * Out:	void.
  *
  * At this point, we have already selected the desired data,
  * so we just need to print it for the user.
  */
-void do_list(void)
+void do_list(slurmdb_job_rec_t *job)
 {
-	ListIterator itr = NULL;
 	ListIterator itr_step = NULL;
-	slurmdb_job_rec_t *job = NULL;
 	slurmdb_step_rec_t *step = NULL;
 
-	if (!jobs)
-		return;
-
-	itr = list_iterator_create(jobs);
-	while((job = list_next(itr))) {
-		if (list_count(job->steps)) {
-			int cnt = list_count(job->steps);
-			job->stats.cpu_ave /= (double)cnt;
-			job->stats.rss_ave /= (double)cnt;
-			job->stats.vsize_ave /= (double)cnt;
-			job->stats.pages_ave /= (double)cnt;
-			job->stats.disk_read_ave /= (double)cnt;
-			job->stats.disk_write_ave /= (double)cnt;
-		}
+	if (list_count(job->steps)) {
+		int cnt = list_count(job->steps);
+		job->stats.cpu_ave /= (double)cnt;
+		job->stats.rss_ave /= (double)cnt;
+		job->stats.vsize_ave /= (double)cnt;
+		job->stats.pages_ave /= (double)cnt;
+		job->stats.disk_read_ave /= (double)cnt;
+		job->stats.disk_write_ave /= (double)cnt;
+	}
 
-		if (job->show_full)
-			print_fields(JOB, job);
+	if (job->show_full)
+		print_fields(JOB, job);
 
-		if (!params.opt_allocs
-		    && (job->track_steps || !job->show_full)) {
-			itr_step = list_iterator_create(job->steps);
-			while((step = list_next(itr_step))) {
-				if (step->end == 0)
-					step->end = job->end;
-				print_fields(JOBSTEP, step);
-			}
-			list_iterator_destroy(itr_step);
+	if (!params.opt_allocs
+	    && (job->track_steps || !job->show_full)) {
+		itr_step = list_iterator_create(job->steps);
+		while((step = list_next(itr_step))) {
+			if (step->end == 0)
+				step->end = job->end;
+			print_fields(JOBSTEP, step);
 		}
+		list_iterator_destroy(itr_step);
 	}
-	list_iterator_destroy(itr);
 }
 
 /* do_list_completion() -- List the assembled data
@@ -159,8 +159,6 @@ int main(int argc, char **argv)
 			exit(errno);
 		if (params.opt_completion)
 			do_list_completion();
-		else
-			do_list();
 		break;
 	case SACCT_HELP:
 		do_help();
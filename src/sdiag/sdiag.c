@@ -173,6 +173,32 @@ static int _print_stats(void)
 		       buf->bf_queue_len_sum / buf->bf_cycle_counter);
 	}
 
+	printf("\nAuthentication statistics (microseconds)\n");
+	printf("\tCredentials created: %u\n", buf->auth_create_cnt);
+	if (buf->auth_create_cnt > 0) {
+		printf("\tMean create time: %"PRIu64"\n",
+		       buf->auth_create_time / buf->auth_create_cnt);
+	}
+	printf("\tCredentials verified: %u\n", buf->auth_verify_cnt);
+	if (buf->auth_verify_cnt > 0) {
+		printf("\tMean verify time: %"PRIu64"\n",
+		       buf->auth_verify_time / buf->auth_verify_cnt);
+	}
+	printf("\tMax verify time: %u\n", buf->auth_verify_max);
+	printf("\tSession authenticated messages: %u\n",
+	       buf->auth_session_cnt);
+
+	printf("\nMessage aggregation statistics by collector\n");
+	for (i = 0; i < buf->msg_aggr_size; i++) {
+		printf("\t%-22s batches:%-6u msgs:%-8u "
+		       "ave_batch:%-4u max_batch:%u\n",
+		       buf->msg_aggr_addr[i], buf->msg_aggr_batch_cnt[i],
+		       buf->msg_aggr_msg_cnt[i],
+		       buf->msg_aggr_msg_cnt[i] /
+		       MAX(buf->msg_aggr_batch_cnt[i], 1),
+		       buf->msg_aggr_batch_max[i]);
+	}
+
 	printf("\nRemote Procedure Call statistics by message type\n");
 	for (i = 0; i < buf->rpc_type_size; i++) {
 		printf("\t%-40s(%5u) count:%-6u "
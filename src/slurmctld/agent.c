@@ -60,6 +60,15 @@
  *
  *  All the state for each thread is maintained in thd_t struct, which is
  *  used by the watchdog thread as well as the communication threads.
+ *
+ *  With CommunicationParameters=mux_agent, job termination and node ping
+ *  RPCs are instead sent directly through the forwarding engine, which
+ *  drives the connections to thousands of nodes at once, and a single
+ *  thread processes the responses. See _mux_queue_request().
+ *
+ *  Job termination and task signal RPCs are first held briefly so that
+ *  those bound for the same nodes can be sent as one REQUEST_NODE_MSG_LIST.
+ *  See _coalesce_request().
 \*****************************************************************************/
 
 #ifdef HAVE_CONFIG_H
@@ -76,6 +85,7 @@
 #include <signal.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -176,16 +186,25 @@ static void _sig_handler(int dummy);
 static int  _batch_launch_defer(queued_request_t *queued_req_ptr);
 static inline int _comm_err(char *node_name, slurm_msg_type_t msg_type);
 static void _list_delete_retry(void *retry_entry);
-static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr);
+static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr,
+				      bool direct);
 static task_info_t *_make_task_data(agent_info_t *agent_info_ptr, int inx);
 static void _notify_slurmctld_jobs(agent_info_t *agent_ptr);
 static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 		int no_resp_cnt, int retry_cnt);
+static state_t _process_ret_list(List ret_list, slurm_msg_type_t msg_type,
+				 void *msg_args, bool srun_agent);
 static void _purge_agent_args(agent_arg_t *agent_arg_ptr);
 static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count);
 static int _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 			  int count, int *spot);
 static void _spawn_retry_agent(agent_arg_t * agent_arg_ptr);
+static void _agent_queue_now(agent_arg_t *agent_arg_ptr);
+static bool _coalesce_eligible(agent_arg_t *agent_arg_ptr);
+static void _coalesce_request(agent_arg_t *agent_arg_ptr);
+static bool _mux_agent_eligible(agent_arg_t *agent_arg_ptr);
+static bool _ping_tree(void);
+static void _mux_queue_request(agent_arg_t *agent_arg_ptr);
 static void *_thread_per_group_rpc(void *args);
 static int   _valid_agent_arg(agent_arg_t *agent_arg_ptr);
 static void *_wdog(void *args);
@@ -268,7 +287,7 @@ void *agent(void *args)
 		goto cleanup;
 
 	/* initialize the agent data structures */
-	agent_info_ptr = _make_agent_info(agent_arg_ptr);
+	agent_info_ptr = _make_agent_info(agent_arg_ptr, false);
 	thread_ptr = agent_info_ptr->thread_struct;
 
 	/* start the watchdog thread */
@@ -391,7 +410,13 @@ static int _valid_agent_arg(agent_arg_t *agent_arg_ptr)
 	return SLURM_SUCCESS;
 }
 
-static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr)
+/*
+ * Build the per thread records for an agent request
+ * IN direct - send the message to every node directly rather than
+ *	forwarding it through slurmd
+ */
+static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr,
+				      bool direct)
 {
 	int i = 0, j = 0;
 	agent_info_t *agent_info_ptr = NULL;
@@ -415,7 +440,11 @@ static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr)
 	agent_info_ptr->msg_args_pptr  = &agent_arg_ptr->msg_args;
 	agent_info_ptr->protocol_version = agent_arg_ptr->protocol_version;
 
-	if ((agent_arg_ptr->msg_type != REQUEST_JOB_NOTIFY)	&&
+	if (direct) {
+		span = set_span(agent_arg_ptr->node_count,
+				agent_arg_ptr->node_count);
+		agent_info_ptr->get_reply = true;
+	} else if ((agent_arg_ptr->msg_type != REQUEST_JOB_NOTIFY)	&&
 	    (agent_arg_ptr->msg_type != REQUEST_REBOOT_NODES)	&&
 	    (agent_arg_ptr->msg_type != REQUEST_RECONFIGURE)	&&
 	    (agent_arg_ptr->msg_type != REQUEST_SHUTDOWN)	&&
@@ -733,7 +762,11 @@ static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 				      node_names, down_msg);
 				break;
 			case DSH_DONE:
-				node_did_resp(node_names);
+				if (resp_type == RESPONSE_PING_SLURMD_LIST)
+					node_list_did_resp(
+						ret_data_info->data);
+				else
+					node_did_resp(node_names);
 				break;
 			default:
 				error("unknown state returned for %s",
@@ -795,32 +828,97 @@ static int _wif_status(void)
 }
 
 /*
- * _thread_per_group_rpc - thread to issue an RPC for a group of nodes
- *                         sending message out to one and forwarding it to
- *                         others if necessary.
- * IN/OUT args - pointer to task_info_t, xfree'd on completion
+ * _process_node_msg_list - act on the responses to a REQUEST_NODE_MSG_LIST,
+ *	processing each message's return code as if it had been sent alone
+ * RET state of the last node processed, each ret_data_info_t's err is set
+ *	to the state of its node (its worst state for any of the messages)
  */
-static void *_thread_per_group_rpc(void *args)
+static state_t _process_node_msg_list(List ret_list, node_msg_list_t *msg_list,
+				      bool srun_agent)
 {
-	int rc = SLURM_SUCCESS;
-	slurm_msg_t msg;
-	task_info_t *task_ptr = (task_info_t *) args;
-	/* we cache some pointers from task_info_t because we need
-	 * to xfree args before being finished with their use. xfree
-	 * is required for timely termination of this pthread because
-	 * xfree could lock it at the end, preventing a timely
-	 * thread_exit */
-	pthread_mutex_t *thread_mutex_ptr   = task_ptr->thread_mutex_ptr;
-	pthread_cond_t  *thread_cond_ptr    = task_ptr->thread_cond_ptr;
-	uint32_t        *threads_active_ptr = task_ptr->threads_active_ptr;
-	thd_t           *thread_ptr         = task_ptr->thread_struct_ptr;
+	ret_data_info_t *ret_data_info, sub_info;
+	node_msg_list_resp_msg_t *resp;
+	return_code_msg_t rc_msg;
+	ListIterator itr, data_itr;
+	List sub_list = list_create(NULL);
+	state_t thread_state = DSH_NO_RESP, state;
+	void *data;
+	uint32_t i;
+
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		resp = NULL;
+		if (ret_data_info->type == RESPONSE_NODE_MSG_LIST) {
+			resp = (node_msg_list_resp_msg_t *) ret_data_info->data;
+			if (resp->rc_cnt != list_count(msg_list->data_list)) {
+				error("%s: %s returned %u of %d return codes",
+				      __func__, ret_data_info->node_name,
+				      resp->rc_cnt,
+				      list_count(msg_list->data_list));
+				resp = NULL;
+			}
+		}
+		if (!resp) {
+			/* Failure applies to every message */
+			list_append(sub_list, ret_data_info);
+			thread_state = DSH_DONE;
+			data_itr = list_iterator_create(msg_list->data_list);
+			while ((data = list_next(data_itr))) {
+				state = _process_ret_list(sub_list,
+							  msg_list->msg_type,
+							  data, srun_agent);
+				if (thread_state == DSH_DONE)
+					thread_state = state;
+			}
+			list_iterator_destroy(data_itr);
+			(void) list_pop(sub_list);
+			ret_data_info->err = thread_state;
+			continue;
+		}
+
+		memset(&sub_info, 0, sizeof(ret_data_info_t));
+		sub_info.node_name = ret_data_info->node_name;
+		sub_info.type = RESPONSE_SLURM_RC;
+		sub_info.data = &rc_msg;
+		thread_state = DSH_DONE;
+		i = 0;
+		data_itr = list_iterator_create(msg_list->data_list);
+		while ((data = list_next(data_itr))) {
+			rc_msg.return_code = resp->rc_array[i++];
+			sub_info.err = 0;
+			list_append(sub_list, &sub_info);
+			state = _process_ret_list(sub_list, msg_list->msg_type,
+						  data, srun_agent);
+			(void) list_pop(sub_list);
+			if (thread_state == DSH_DONE)
+				thread_state = state;
+		}
+		list_iterator_destroy(data_itr);
+		ret_data_info->err = thread_state;
+	}
+	list_iterator_destroy(itr);
+	list_destroy(sub_list);
+
+	return thread_state;
+}
+
+/*
+ * _process_ret_list - act on the responses to an RPC, recording the
+ *	resulting state of each node in its ret_data_info->err
+ * IN ret_list - ret_data_info_t for every node the RPC was sent to
+ * IN msg_type - RPC that was issued
+ * IN msg_args - RPC data that was sent
+ * IN srun_agent - set if the RPC was sent to srun rather than slurmd
+ * RET state of the last response processed, DSH_NO_RESP if none
+ */
+static state_t _process_ret_list(List ret_list, slurm_msg_type_t msg_type,
+				 void *msg_args, bool srun_agent)
+{
+	int rc;
 	state_t thread_state = DSH_NO_RESP;
-	slurm_msg_type_t msg_type = task_ptr->msg_type;
-	bool is_kill_msg, srun_agent;
-	List ret_list = NULL;
+	bool is_kill_msg;
 	ListIterator itr;
 	ret_data_info_t *ret_data_info = NULL;
-	int sig_array[2] = {SIGUSR1, 0};
 	/* Locks: Write job, write node */
 	slurmctld_lock_t job_write_lock = {
 		NO_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK };
@@ -831,90 +929,13 @@ static void *_thread_per_group_rpc(void *args)
 	slurmctld_lock_t node_write_lock = {
 		NO_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK };
 
-	xassert(args != NULL);
-	xsignal(SIGUSR1, _sig_handler);
-	xsignal_unblock(sig_array);
+	if (msg_type == REQUEST_NODE_MSG_LIST)
+		return _process_node_msg_list(ret_list, msg_args, srun_agent);
+
 	is_kill_msg = (	(msg_type == REQUEST_KILL_TIMELIMIT)	||
 			(msg_type == REQUEST_KILL_PREEMPTED)	||
 			(msg_type == REQUEST_TERMINATE_JOB) );
-	srun_agent = (	(msg_type == SRUN_PING)			||
-			(msg_type == SRUN_EXEC)			||
-			(msg_type == SRUN_JOB_COMPLETE)		||
-			(msg_type == SRUN_STEP_MISSING)		||
-			(msg_type == SRUN_STEP_SIGNAL)		||
-			(msg_type == SRUN_TIMEOUT)		||
-			(msg_type == SRUN_USER_MSG)		||
-			(msg_type == RESPONSE_RESOURCE_ALLOCATION) ||
-			(msg_type == SRUN_NODE_FAIL) );
-
-	thread_ptr->start_time = time(NULL);
-
-	slurm_mutex_lock(thread_mutex_ptr);
-	thread_ptr->state = DSH_ACTIVE;
-	thread_ptr->end_time = thread_ptr->start_time + message_timeout;
-	slurm_mutex_unlock(thread_mutex_ptr);
-
-	/* send request message */
-	slurm_msg_t_init(&msg);
-
-	if (task_ptr->protocol_version)
-		msg.protocol_version = task_ptr->protocol_version;
-
-	msg.msg_type = msg_type;
-	msg.data     = task_ptr->msg_args_ptr;
-#if 0
- 	info("sending message type %u to %s", msg_type, thread_ptr->nodelist);
-#endif
-	if (task_ptr->get_reply) {
-		if (thread_ptr->addr) {
-			msg.address = *thread_ptr->addr;
-
-			if (!(ret_list = slurm_send_addr_recv_msgs(
-				     &msg, thread_ptr->nodelist, 0))) {
-				error("_thread_per_group_rpc: "
-				      "no ret_list given");
-				goto cleanup;
-			}
-
-
-		} else {
-			if (!(ret_list = slurm_send_recv_msgs(
-				     thread_ptr->nodelist,
-				     &msg, 0, true))) {
-				error("_thread_per_group_rpc: "
-				      "no ret_list given");
-				goto cleanup;
-			}
-		}
-	} else {
-		if (thread_ptr->addr) {
-			//info("got the address");
-			msg.address = *thread_ptr->addr;
-		} else {
-			//info("no address given");
-			if (slurm_conf_get_addr(thread_ptr->nodelist,
-					       &msg.address) == SLURM_ERROR) {
-				error("_thread_per_group_rpc: "
-				      "can't find address for host %s, "
-				      "check slurm.conf",
-				      thread_ptr->nodelist);
-				goto cleanup;
-			}
-		}
-		//info("sending %u to %s", msg_type, thread_ptr->nodelist);
-		if (slurm_send_only_node_msg(&msg) == SLURM_SUCCESS) {
-			thread_state = DSH_DONE;
-		} else {
-			if (!srun_agent) {
-				lock_slurmctld(node_read_lock);
-				_comm_err(thread_ptr->nodelist, msg_type);
-				unlock_slurmctld(node_read_lock);
-			}
-		}
-		goto cleanup;
-	}
 
-	//info("got %d messages back", list_count(ret_list));
 	itr = list_iterator_create(ret_list);
 	while ((ret_data_info = list_next(itr)) != NULL) {
 		rc = slurm_get_return_code(ret_data_info->type,
@@ -934,7 +955,7 @@ static void *_thread_per_group_rpc(void *args)
 		    (rc == ESLURMD_KILL_JOB_ALREADY_COMPLETE)) {
 			kill_job_msg_t *kill_job;
 			kill_job = (kill_job_msg_t *)
-				task_ptr->msg_args_ptr;
+				msg_args;
 			rc = SLURM_SUCCESS;
 			lock_slurmctld(job_write_lock);
 			if (job_epilog_complete(kill_job->job_id,
@@ -959,7 +980,7 @@ static void *_thread_per_group_rpc(void *args)
 		    (rc != SLURM_SUCCESS) && (rc != ESLURMD_PROLOG_FAILED) &&
 		    (ret_data_info->type != RESPONSE_FORWARD_FAILED)) {
 			batch_job_launch_msg_t *launch_msg_ptr =
-				task_ptr->msg_args_ptr;
+				msg_args;
 			uint32_t job_id = launch_msg_ptr->job_id;
 			info("Killing non-startable batch job %u: %s",
 			     job_id, slurm_strerror(rc));
@@ -1040,6 +1061,123 @@ static void *_thread_per_group_rpc(void *args)
 	}
 	list_iterator_destroy(itr);
 
+	return thread_state;
+}
+
+/*
+ * _thread_per_group_rpc - thread to issue an RPC for a group of nodes
+ *                         sending message out to one and forwarding it to
+ *                         others if necessary.
+ * IN/OUT args - pointer to task_info_t, xfree'd on completion
+ */
+static void *_thread_per_group_rpc(void *args)
+{
+	slurm_msg_t msg;
+	task_info_t *task_ptr = (task_info_t *) args;
+	/* we cache some pointers from task_info_t because we need
+	 * to xfree args before being finished with their use. xfree
+	 * is required for timely termination of this pthread because
+	 * xfree could lock it at the end, preventing a timely
+	 * thread_exit */
+	pthread_mutex_t *thread_mutex_ptr   = task_ptr->thread_mutex_ptr;
+	pthread_cond_t  *thread_cond_ptr    = task_ptr->thread_cond_ptr;
+	uint32_t        *threads_active_ptr = task_ptr->threads_active_ptr;
+	thd_t           *thread_ptr         = task_ptr->thread_struct_ptr;
+	state_t thread_state = DSH_NO_RESP;
+	slurm_msg_type_t msg_type = task_ptr->msg_type;
+	bool srun_agent;
+	List ret_list = NULL;
+	int sig_array[2] = {SIGUSR1, 0};
+	/* Lock: Read node */
+	slurmctld_lock_t node_read_lock = {
+		NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK };
+
+	xassert(args != NULL);
+	xsignal(SIGUSR1, _sig_handler);
+	xsignal_unblock(sig_array);
+	srun_agent = (	(msg_type == SRUN_PING)			||
+			(msg_type == SRUN_EXEC)			||
+			(msg_type == SRUN_JOB_COMPLETE)		||
+			(msg_type == SRUN_STEP_MISSING)		||
+			(msg_type == SRUN_STEP_SIGNAL)		||
+			(msg_type == SRUN_TIMEOUT)		||
+			(msg_type == SRUN_USER_MSG)		||
+			(msg_type == RESPONSE_RESOURCE_ALLOCATION) ||
+			(msg_type == SRUN_NODE_FAIL) );
+
+	thread_ptr->start_time = time(NULL);
+
+	slurm_mutex_lock(thread_mutex_ptr);
+	thread_ptr->state = DSH_ACTIVE;
+	thread_ptr->end_time = thread_ptr->start_time + message_timeout;
+	slurm_mutex_unlock(thread_mutex_ptr);
+
+	/* send request message */
+	slurm_msg_t_init(&msg);
+
+	if (task_ptr->protocol_version)
+		msg.protocol_version = task_ptr->protocol_version;
+
+	msg.msg_type = msg_type;
+	msg.data     = task_ptr->msg_args_ptr;
+	if ((msg_type == REQUEST_PING) && _ping_tree())
+		msg.flags |= SLURM_MSG_AGGR_RESP;
+#if 0
+ 	info("sending message type %u to %s", msg_type, thread_ptr->nodelist);
+#endif
+	if (task_ptr->get_reply) {
+		if (thread_ptr->addr) {
+			msg.address = *thread_ptr->addr;
+
+			if (!(ret_list = slurm_send_addr_recv_msgs(
+				     &msg, thread_ptr->nodelist, 0))) {
+				error("_thread_per_group_rpc: "
+				      "no ret_list given");
+				goto cleanup;
+			}
+
+
+		} else {
+			if (!(ret_list = slurm_send_recv_msgs(
+				     thread_ptr->nodelist,
+				     &msg, 0, true))) {
+				error("_thread_per_group_rpc: "
+				      "no ret_list given");
+				goto cleanup;
+			}
+		}
+	} else {
+		if (thread_ptr->addr) {
+			//info("got the address");
+			msg.address = *thread_ptr->addr;
+		} else {
+			//info("no address given");
+			if (slurm_conf_get_addr(thread_ptr->nodelist,
+					       &msg.address) == SLURM_ERROR) {
+				error("_thread_per_group_rpc: "
+				      "can't find address for host %s, "
+				      "check slurm.conf",
+				      thread_ptr->nodelist);
+				goto cleanup;
+			}
+		}
+		//info("sending %u to %s", msg_type, thread_ptr->nodelist);
+		if (slurm_send_only_node_msg(&msg) == SLURM_SUCCESS) {
+			thread_state = DSH_DONE;
+		} else {
+			if (!srun_agent) {
+				lock_slurmctld(node_read_lock);
+				_comm_err(thread_ptr->nodelist, msg_type);
+				unlock_slurmctld(node_read_lock);
+			}
+		}
+		goto cleanup;
+	}
+
+	//info("got %d messages back", list_count(ret_list));
+	thread_state = _process_ret_list(ret_list, msg_type,
+					 task_ptr->msg_args_ptr, srun_agent);
+
 cleanup:
 	xfree(args);
 
@@ -1302,6 +1440,390 @@ extern int agent_retry (int min_wait, bool mail_too)
 	return list_size;
 }
 
+/*
+ * Multiplexed agent
+ *
+ * Frequent RPCs sent to every node of a job or of the cluster (job
+ * termination and node pings) are not given an agent thread of their own
+ * when CommunicationParameters=mux_agent is configured. Each request's
+ * message is sent directly to every node through the forwarding engine
+ * (see forward_msg_nodes()), whose single poll() loop drives the
+ * connections of every request with a MessageTimeout deadline each and
+ * packs the message as each connection opens so that its credential is
+ * fresh. Responses are interpreted and reported to slurmctld by one
+ * completion thread so the engine's threads never wait on slurmctld locks.
+ * Requests are started as they arrive, bypassing retry_list and the
+ * MAX_AGENT_CNT limit; failed nodes are retried through retry_list as
+ * with any other agent.
+ */
+typedef struct mux_req {
+	agent_arg_t *agent_arg_ptr;	/* request being processed */
+	agent_info_t *agent_info_ptr;	/* one thd_t per node */
+	slurm_msg_t msg;		/* message sent to every node */
+	uint32_t pending;		/* nodes with no final state */
+	time_t begin_time;		/* time request was queued */
+} mux_req_t;
+
+typedef struct mux_resp {
+	mux_req_t *req;			/* request sent */
+	thd_t *thread_ptr;		/* node's state */
+	List ret_list;			/* node's response or failure */
+} mux_resp_t;
+
+static pthread_mutex_t mux_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  mux_done_cond = PTHREAD_COND_INITIALIZER;
+static List mux_done_list = NULL;	/* mux_resp_t to be processed */
+static bool mux_started = false;
+
+/* Return true if the multiplexed agent should send this request */
+static bool _mux_agent_eligible(agent_arg_t *agent_arg_ptr)
+{
+	slurm_msg_type_t msg_type = agent_arg_ptr->msg_type;
+
+	if (agent_arg_ptr->addr)
+		return false;
+	if (msg_type == REQUEST_NODE_MSG_LIST)
+		msg_type = ((node_msg_list_t *) agent_arg_ptr->msg_args)->
+			   msg_type;
+	if ((msg_type != REQUEST_TERMINATE_JOB)			&&
+	    (msg_type != REQUEST_KILL_TIMELIMIT)			&&
+	    (msg_type != REQUEST_KILL_PREEMPTED)			&&
+	    (msg_type != REQUEST_NODE_REGISTRATION_STATUS)		&&
+	    (msg_type != REQUEST_PING))
+		return false;
+
+	if ((msg_type == REQUEST_PING) && _ping_tree())
+		return false;
+
+	return (slurm_get_comm_flags() & COMM_FLAG_MUX_AGENT);
+}
+
+/* Return true if pings should travel down the forwarding tree, each slurmd
+ * merging the replies of its subtree into one RESPONSE_PING_SLURMD_LIST */
+static bool _ping_tree(void)
+{
+	return (slurm_get_comm_flags() & COMM_FLAG_PING_TREE);
+}
+
+/* forward_msg_nodes() callback, queue a node's response for _mux_complete() */
+static void _mux_node_done(int node_inx, List ret_list, void *arg)
+{
+	mux_req_t *req = (mux_req_t *) arg;
+	mux_resp_t *resp = xmalloc(sizeof(mux_resp_t));
+
+	resp->req = req;
+	resp->thread_ptr = &req->agent_info_ptr->thread_struct[node_inx];
+	resp->ret_list = ret_list;
+
+	slurm_mutex_lock(&mux_mutex);
+	list_append(mux_done_list, resp);
+	pthread_cond_signal(&mux_done_cond);
+	slurm_mutex_unlock(&mux_mutex);
+}
+
+/* Record the response, or failure, of one node of a multiplexed request */
+static void _mux_resp_finish(mux_resp_t *resp)
+{
+	mux_req_t *req = resp->req;
+	thd_t *thread_ptr = resp->thread_ptr;
+
+	thread_ptr->ret_list = resp->ret_list;
+	thread_ptr->state = _process_ret_list(resp->ret_list,
+					      req->agent_info_ptr->msg_type,
+					      req->agent_arg_ptr->msg_args,
+					      false);
+	thread_ptr->end_time = (time_t) difftime(time(NULL),
+						 thread_ptr->start_time);
+}
+
+/* Report the results of a multiplexed request to slurmctld and free it */
+static void _mux_req_finish(mux_req_t *req)
+{
+	agent_info_t *agent_ptr = req->agent_info_ptr;
+	thd_t *thread_ptr = agent_ptr->thread_struct;
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	int i, delay, no_resp_cnt = 0;
+
+	for (i = 0; i < agent_ptr->thread_count; i++) {
+		itr = list_iterator_create(thread_ptr[i].ret_list);
+		while ((ret_data_info = list_next(itr))) {
+			if (ret_data_info->err == DSH_NO_RESP)
+				no_resp_cnt++;
+		}
+		list_iterator_destroy(itr);
+	}
+	_notify_slurmctld_nodes(agent_ptr, no_resp_cnt, no_resp_cnt);
+
+	delay = (int) difftime(time(NULL), req->begin_time);
+	if (delay > (slurm_get_msg_timeout() * 2)) {
+		info("agent msg_type=%u ran for %d seconds",
+		     agent_ptr->msg_type, delay);
+	}
+
+	for (i = 0; i < agent_ptr->thread_count; i++) {
+		list_destroy(thread_ptr[i].ret_list);
+		xfree(thread_ptr[i].nodelist);
+	}
+	destroy_forward(&req->msg.forward);
+	_purge_agent_args(req->agent_arg_ptr);
+	slurm_mutex_destroy(&agent_ptr->thread_mutex);
+	pthread_cond_destroy(&agent_ptr->thread_cond);
+	xfree(agent_ptr->thread_struct);
+	xfree(agent_ptr);
+	xfree(req);
+}
+
+/*
+ * _mux_complete - Multiplexed agent completion thread. Interprets the
+ *	responses gathered by the forwarding engine and notifies slurmctld
+ *	once all nodes of a request have completed.
+ */
+static void *_mux_complete(void *args)
+{
+	mux_resp_t *resp;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "slurmctld_muxc", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m",
+		      __func__, "slurmctld_muxc");
+	}
+#endif
+	while (1) {
+		slurm_mutex_lock(&mux_mutex);
+		while (!(resp = list_dequeue(mux_done_list)))
+			pthread_cond_wait(&mux_done_cond, &mux_mutex);
+		slurm_mutex_unlock(&mux_mutex);
+
+		_mux_resp_finish(resp);
+		if (--resp->req->pending == 0)
+			_mux_req_finish(resp->req);
+		xfree(resp);
+	}
+
+	return NULL;
+}
+
+/* Start the multiplexed agent's thread, mux_mutex must be locked */
+static void _mux_start(void)
+{
+	pthread_attr_t attr;
+	pthread_t thread_id;
+
+	mux_done_list = list_create(NULL);
+
+	slurm_attr_init(&attr);
+	if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED))
+		error("pthread_attr_setdetachstate error %m");
+	if (pthread_create(&thread_id, &attr, _mux_complete, NULL))
+		fatal("%s: pthread_create error %m", __func__);
+	slurm_attr_destroy(&attr);
+	mux_started = true;
+}
+
+/*
+ * _mux_queue_request - Send a request through the multiplexed agent
+ * IN agent_arg_ptr - the request, xfree'd upon completion
+ */
+static void _mux_queue_request(agent_arg_t *agent_arg_ptr)
+{
+	mux_req_t *req;
+	thd_t *thread_ptr;
+	char **node_names;
+	int i;
+
+	if (_valid_agent_arg(agent_arg_ptr)) {
+		_purge_agent_args(agent_arg_ptr);
+		return;
+	}
+
+	req = xmalloc(sizeof(mux_req_t));
+	slurm_msg_t_init(&req->msg);
+	if (agent_arg_ptr->protocol_version)
+		req->msg.protocol_version = agent_arg_ptr->protocol_version;
+	req->msg.msg_type   = agent_arg_ptr->msg_type;
+	req->msg.data       = agent_arg_ptr->msg_args;
+	req->agent_arg_ptr  = agent_arg_ptr;
+	req->agent_info_ptr = _make_agent_info(agent_arg_ptr, true);
+	req->pending        = req->agent_info_ptr->thread_count;
+	req->begin_time     = time(NULL);
+	debug2("Queue RPC msg_type=%s, nodes=%u for multiplexed agent",
+	       rpc_num2string(agent_arg_ptr->msg_type), req->pending);
+
+	slurm_mutex_lock(&mux_mutex);
+	if (!mux_started)
+		_mux_start();
+	slurm_mutex_unlock(&mux_mutex);
+
+	thread_ptr = req->agent_info_ptr->thread_struct;
+	node_names = xmalloc(sizeof(char *) * req->pending);
+	for (i = 0; i < req->pending; i++) {
+		thread_ptr[i].state = DSH_ACTIVE;
+		thread_ptr[i].start_time = req->begin_time;
+		node_names[i] = thread_ptr[i].nodelist;
+	}
+	forward_msg_nodes(node_names, req->pending, &req->msg, 0,
+			  _mux_node_done, req);
+	xfree(node_names);
+}
+
+/*
+ * Coalescing of node messages
+ *
+ * With CommunicationParameters=agent_coalesce, requests which are cheap
+ * for slurmd to process are held for up to AGENT_COALESCE_MSEC. Those of the same type bound for exactly the same
+ * nodes in that time are merged into one REQUEST_NODE_MSG_LIST, so that
+ * thousands of short jobs ending at once cost an RPC per node rather than
+ * one per job.
+ */
+typedef struct coalesce_req {
+	agent_arg_t *agent_arg_ptr;	/* first request, others merged in */
+	char *host_str;			/* nodes of the request */
+	node_msg_list_t *msg_list;	/* merged messages, NULL if only one */
+	struct timeval queued;		/* time first request was queued */
+} coalesce_req_t;
+
+static pthread_mutex_t coalesce_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  coalesce_cond  = PTHREAD_COND_INITIALIZER;
+static List coalesce_list = NULL;	/* coalesce_req_t, oldest first */
+static bool coalesce_started = false;
+
+/* Return true if the request may be merged with others like it */
+static bool _coalesce_eligible(agent_arg_t *agent_arg_ptr)
+{
+	if (agent_arg_ptr->addr || !agent_arg_ptr->msg_args)
+		return false;
+	if (agent_arg_ptr->protocol_version &&
+	    (agent_arg_ptr->protocol_version < SLURM_PROTOCOL_VERSION))
+		return false;
+	if ((agent_arg_ptr->msg_type != REQUEST_TERMINATE_JOB) &&
+	    (agent_arg_ptr->msg_type != REQUEST_SIGNAL_TASKS))
+		return false;
+
+	return (slurm_get_comm_flags() & COMM_FLAG_AGENT_COALESCE);
+}
+
+/* Queue the request, with any messages merged into it, and free req */
+static void _coalesce_release(coalesce_req_t *req)
+{
+	agent_arg_t *agent_arg_ptr = req->agent_arg_ptr;
+
+	if (req->msg_list) {
+		debug2("Coalesced %d %s RPCs to %s",
+		       list_count(req->msg_list->data_list),
+		       rpc_num2string(req->msg_list->msg_type), req->host_str);
+		agent_arg_ptr->msg_type = REQUEST_NODE_MSG_LIST;
+		agent_arg_ptr->msg_args = req->msg_list;
+	}
+	xfree(req->host_str);
+	xfree(req);
+	_agent_queue_now(agent_arg_ptr);
+}
+
+/* _coalesce_flush - thread releasing requests once their time is up */
+static void *_coalesce_flush(void *args)
+{
+	coalesce_req_t *req;
+	struct timeval now;
+	struct timespec ts;
+	long usec;
+
+	while (1) {
+		slurm_mutex_lock(&coalesce_mutex);
+		while (!(req = list_peek(coalesce_list)))
+			pthread_cond_wait(&coalesce_cond, &coalesce_mutex);
+		gettimeofday(&now, NULL);
+		usec = (now.tv_sec - req->queued.tv_sec) * 1000000 +
+		       (now.tv_usec - req->queued.tv_usec);
+		if (usec < AGENT_COALESCE_MSEC * 1000) {
+			usec = req->queued.tv_usec + AGENT_COALESCE_MSEC * 1000;
+			ts.tv_sec  = req->queued.tv_sec + usec / 1000000;
+			ts.tv_nsec = (usec % 1000000) * 1000;
+			pthread_cond_timedwait(&coalesce_cond, &coalesce_mutex,
+					       &ts);
+			slurm_mutex_unlock(&coalesce_mutex);
+			continue;
+		}
+		(void) list_dequeue(coalesce_list);
+		slurm_mutex_unlock(&coalesce_mutex);
+
+		_coalesce_release(req);
+	}
+
+	return NULL;
+}
+
+/*
+ * _coalesce_request - Hold a request to merge it with any others of the
+ *	same type for the same nodes
+ * IN agent_arg_ptr - the request, xfree'd upon completion
+ */
+static void _coalesce_request(agent_arg_t *agent_arg_ptr)
+{
+	coalesce_req_t *req;
+	ListIterator itr;
+	char *host_str;
+	pthread_attr_t attr;
+	pthread_t thread_id;
+
+	host_str = hostlist_ranged_string_xmalloc(agent_arg_ptr->hostlist);
+
+	slurm_mutex_lock(&coalesce_mutex);
+	if (!coalesce_started) {
+		coalesce_list = list_create(NULL);
+		slurm_attr_init(&attr);
+		if (pthread_attr_setdetachstate(&attr,
+						PTHREAD_CREATE_DETACHED))
+			error("pthread_attr_setdetachstate error %m");
+		if (pthread_create(&thread_id, &attr, _coalesce_flush, NULL))
+			fatal("%s: pthread_create error %m", __func__);
+		slurm_attr_destroy(&attr);
+		coalesce_started = true;
+	}
+
+	itr = list_iterator_create(coalesce_list);
+	while ((req = list_next(itr))) {
+		if ((req->agent_arg_ptr->msg_type == agent_arg_ptr->msg_type) &&
+		    (req->agent_arg_ptr->protocol_version ==
+		     agent_arg_ptr->protocol_version) &&
+		    (req->agent_arg_ptr->retry == agent_arg_ptr->retry) &&
+		    !strcmp(req->host_str, host_str))
+			break;
+	}
+	if (!req) {
+		list_iterator_destroy(itr);
+		req = xmalloc(sizeof(coalesce_req_t));
+		req->agent_arg_ptr = agent_arg_ptr;
+		req->host_str = host_str;
+		gettimeofday(&req->queued, NULL);
+		list_append(coalesce_list, req);
+		pthread_cond_signal(&coalesce_cond);
+		slurm_mutex_unlock(&coalesce_mutex);
+		return;
+	}
+
+	if (!req->msg_list) {
+		req->msg_list = xmalloc(sizeof(node_msg_list_t));
+		req->msg_list->msg_type = req->agent_arg_ptr->msg_type;
+		req->msg_list->data_list = list_create(NULL);
+		list_append(req->msg_list->data_list,
+			    req->agent_arg_ptr->msg_args);
+	}
+	list_append(req->msg_list->data_list, agent_arg_ptr->msg_args);
+	agent_arg_ptr->msg_args = NULL;
+	if (list_count(req->msg_list->data_list) >= AGENT_COALESCE_MAX)
+		list_remove(itr);	/* Send it now */
+	else
+		req = NULL;
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&coalesce_mutex);
+
+	xfree(host_str);
+	_purge_agent_args(agent_arg_ptr);
+	if (req)
+		_coalesce_release(req);
+}
+
 /*
  * agent_queue_request - put a new request on the queue for execution or
  * 	execute now if not too busy
@@ -1309,12 +1831,21 @@ extern int agent_retry (int min_wait, bool mail_too)
  */
 void agent_queue_request(agent_arg_t *agent_arg_ptr)
 {
-	queued_request_t *queued_req_ptr = NULL;
-
 	if (message_timeout == (uint16_t) NO_VAL) {
 		message_timeout = MAX(slurm_get_msg_timeout(), 30);
 	}
 
+	if (_coalesce_eligible(agent_arg_ptr))
+		_coalesce_request(agent_arg_ptr);
+	else
+		_agent_queue_now(agent_arg_ptr);
+}
+
+/* Queue a request, bypassing the coalescing stage */
+static void _agent_queue_now(agent_arg_t *agent_arg_ptr)
+{
+	queued_request_t *queued_req_ptr = NULL;
+
 	if (agent_arg_ptr->msg_type == REQUEST_SHUTDOWN) {
 		/* execute now */
 		pthread_attr_t attr_agent;
@@ -1333,6 +1864,11 @@ void agent_queue_request(agent_arg_t *agent_arg_ptr)
 		}
 	}
 
+	if (_mux_agent_eligible(agent_arg_ptr)) {
+		_mux_queue_request(agent_arg_ptr);
+		return;
+	}
+
 	queued_req_ptr = xmalloc(sizeof(queued_request_t));
 	queued_req_ptr->agent_arg_ptr = agent_arg_ptr;
 /*	queued_req_ptr->last_attempt  = 0; Implicit */
@@ -1362,6 +1898,11 @@ static void _spawn_retry_agent(agent_arg_t * agent_arg_ptr)
 	if (agent_arg_ptr == NULL)
 		return;
 
+	if (_mux_agent_eligible(agent_arg_ptr)) {
+		_mux_queue_request(agent_arg_ptr);
+		return;
+	}
+
 	debug2("Spawning RPC agent for msg_type %s",
 	       rpc_num2string(agent_arg_ptr->msg_type));
 	slurm_attr_init(&attr_agent);
@@ -1457,6 +1998,8 @@ static void _purge_agent_args(agent_arg_t *agent_arg_ptr)
 			slurm_free_job_notify_msg(agent_arg_ptr->msg_args);
 		else if (agent_arg_ptr->msg_type == REQUEST_SUSPEND_INT)
 			slurm_free_suspend_int_msg(agent_arg_ptr->msg_args);
+		else if (agent_arg_ptr->msg_type == REQUEST_NODE_MSG_LIST)
+			slurm_free_node_msg_list(agent_arg_ptr->msg_args);
 		else
 			xfree(agent_arg_ptr->msg_args);
 	}
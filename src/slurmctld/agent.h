@@ -51,6 +51,11 @@
 					 *   total thread count is product of
 					 *   MAX_AGENT_CNT and
 					 *   (AGENT_THREAD_COUNT + 2) */
+#define AGENT_COALESCE_MSEC	20	/* time to hold requests to merge
+					 * them with others for the same
+					 * nodes */
+#define AGENT_COALESCE_MAX	256	/* maximum messages merged into one
+					 * REQUEST_NODE_MSG_LIST */
 #define LOTS_OF_AGENTS_CNT 50
 #define LOTS_OF_AGENTS ((get_agent_count() <= LOTS_OF_AGENTS_CNT) ? 0 : 1)
 
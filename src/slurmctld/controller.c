@@ -52,11 +52,13 @@
 
 #include <grp.h>
 #include <errno.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/resource.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -71,6 +73,7 @@
 #include "src/common/layouts_mgr.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
+#include "src/common/net.h"
 #include "src/common/node_select.h"
 #include "src/common/pack.h"
 #include "src/common/power.h"
@@ -193,6 +196,7 @@ static char *	debug_logfile = NULL;
 static bool	dump_core = false;
 static int      job_sched_cnt = 0;
 static uint32_t max_server_threads = MAX_SERVER_THREADS;
+static uint32_t persist_conn_cnt = 0;
 static time_t	next_stats_reset = 0;
 static int	new_nice = 0;
 static char	node_name[MAX_SLURM_NAME];
@@ -228,6 +232,9 @@ static void         _remove_qos(slurmdb_qos_rec_t *rec);
 static void         _update_assoc(slurmdb_assoc_rec_t *rec);
 static void         _update_qos(slurmdb_qos_rec_t *rec);
 inline static int   _report_locks_set(void);
+static bool         _persist_conn_add(void);
+static void         _persist_conn_del(void);
+static bool         _persist_conn_wait(slurm_fd_t fd);
 static void *       _service_connection(void *arg);
 static void         _set_work_dir(void);
 static int          _shutdown_backup_controller(int wait_time);
@@ -1069,6 +1076,9 @@ static void *_service_connection(void *arg)
 	connection_arg_t *conn = (connection_arg_t *) arg;
 	void *return_code = NULL;
 	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+	bool persist = false;
+	void *session_cred = NULL;
+	time_t session_time = 0;
 
 #if HAVE_SYS_PRCTL_H
 	if (prctl(PR_SET_NAME, "slurmctld_srvcn", NULL, NULL, NULL) < 0) {
@@ -1077,11 +1087,13 @@ static void *_service_connection(void *arg)
 	}
 #endif
 	slurm_msg_t_init(msg);
+next_msg:
 	/*
 	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
 	 * possibility for slurmctld_req() to close accepted connection.
 	 */
-	if (slurm_receive_msg(conn->newsockfd, msg, 0) != 0) {
+	if (slurm_receive_session_msg(conn->newsockfd, msg, 0, session_cred)
+	    != 0) {
 		error("slurm_receive_msg: %m");
 		/* close the new socket */
 		slurm_close(conn->newsockfd);
@@ -1094,20 +1106,121 @@ static void *_service_connection(void *arg)
 		} else
 			info("_service_connection/slurm_receive_msg %m");
 	} else {
+		/* The client asked to keep the connection open for more
+		 * requests, grant that only while we have threads to spare */
+		if ((msg->flags & SLURM_MSG_KEEP_CONN) && !persist &&
+		    (persist = _persist_conn_add()))
+			net_set_nodelay(conn->newsockfd);
+		if (!persist)
+			msg->flags &= ~SLURM_MSG_KEEP_CONN;
+
+		/* The last credential verified on a persistent connection
+		 * authenticates the requests sent on it without one */
+		if (persist && (msg->auth_cred != session_cred)) {
+			if (session_cred)
+				(void) g_slurm_auth_destroy(session_cred);
+			session_cred = msg->auth_cred;
+			session_time = time(NULL);
+		}
+
 		/* process the request */
 		slurmctld_req(msg, conn);
+
+		if (persist && (msg->flags & SLURM_MSG_KEEP_CONN) &&
+		    (msg->conn_fd >= 0) &&
+		    (g_slurm_auth_errno(msg->auth_cred) == SLURM_SUCCESS) &&
+		    _persist_conn_wait(conn->newsockfd)) {
+			slurm_msg_t_init(msg);
+			/* The client sends a new credential well before
+			 * this, without one the connection is refused */
+			if (difftime(time(NULL), session_time) >=
+			    PERSIST_CONN_SESSION_TTL) {
+				debug("%s: session of connection %d expired",
+				      __func__, conn->newsockfd);
+				(void) g_slurm_auth_destroy(session_cred);
+				session_cred = NULL;
+			}
+			goto next_msg;
+		}
 	}
 	if ((conn->newsockfd >= 0)
 	    && slurm_close(conn->newsockfd) < 0)
 		error ("close(%d): %m",  conn->newsockfd);
 
 cleanup:
+	if (persist)
+		_persist_conn_del();
+	if (msg->auth_cred == session_cred)
+		msg->auth_cred = NULL;
+	if (session_cred)
+		(void) g_slurm_auth_destroy(session_cred);
 	slurm_free_msg(msg);
 	xfree(arg);
 	_free_server_thread();
 	return return_code;
 }
 
+/* Reserve a server thread for a persistent client connection,
+ * RET false if too many threads are already held by such connections */
+static bool _persist_conn_add(void)
+{
+	bool rc = false;
+
+	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
+	if (persist_conn_cnt < (max_server_threads / 2)) {
+		persist_conn_cnt++;
+		rc = true;
+	}
+	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
+
+	return rc;
+}
+
+static void _persist_conn_del(void)
+{
+	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
+	if (persist_conn_cnt > 0)
+		persist_conn_cnt--;
+	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
+}
+
+/*
+ * Wait for the next request on a persistent client connection.
+ * RET true if a request is ready to be read, false if the connection should
+ *	be closed: the client closed it, it was idle for PERSIST_CONN_IDLE
+ *	seconds, other connections are waiting for a server thread or we
+ *	are shutting down
+ */
+static bool _persist_conn_wait(slurm_fd_t fd)
+{
+	struct pollfd pfd;
+	char peek;
+	int i, rc;
+
+	for (i = 0; i < PERSIST_CONN_IDLE; i++) {
+		if (slurmctld_config.shutdown_time)
+			return false;
+		if (slurmctld_config.server_thread_count >= max_server_threads)
+			return false;
+
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		rc = poll(&pfd, 1, 1000);
+		if (rc == 0)
+			continue;
+		if ((rc < 0) && (errno == EINTR))
+			continue;
+		if (rc < 0)
+			return false;
+		/* Readable with no data means the client closed it */
+		rc = recv(fd, &peek, 1, MSG_PEEK | MSG_DONTWAIT);
+		return (rc > 0);
+	}
+
+	return false;
+}
+
 /* Increment slurmctld_config.server_thread_count and don't return
  * until its value is no larger than MAX_SERVER_THREADS,
  * RET true unless shutdown in progress */
@@ -2030,12 +2030,16 @@ extern int update_node_record_acct_gather_data(
  *	if not set state to down, in any case update last_response
  * IN reg_msg - node registration message
  * IN protocol_version - Version of Slurm on this node
+ * IN gres_conf - reg_msg's gres data already unpacked by
+ *	gres_plugin_node_config_unpack_list(), or NULL to unpack it here;
+ *	consumed
  * OUT newly_up - set if node newly brought into service
  * RET 0 if no error, ENOENT if no such node, EINVAL if values too low
  * NOTE: READ lock_slurmctld config before entry
  */
 extern int validate_node_specs(slurm_node_registration_status_msg_t *reg_msg,
-			       uint16_t protocol_version, bool *newly_up)
+			       uint16_t protocol_version, List gres_conf,
+			       bool *newly_up)
 {
 	int error_code, i, node_inx;
 	struct config_record *config_ptr;
@@ -2049,8 +2053,10 @@ extern int validate_node_specs(slurm_node_registration_status_msg_t *reg_msg,
 	int *cpu_spec_array;
 
 	node_ptr = find_node_record (reg_msg->node_name);
-	if (node_ptr == NULL)
+	if (node_ptr == NULL) {
+		FREE_NULL_LIST(gres_conf);
 		return ENOENT;
+	}
 	node_inx = node_ptr - node_record_table_ptr;
 	orig_node_avail = bit_test(avail_node_bitmap, node_inx);
 
@@ -2072,15 +2078,20 @@ extern int validate_node_specs(slurm_node_registration_status_msg_t *reg_msg,
 	if (slurm_get_preempt_mode() != PREEMPT_MODE_OFF)
 		gang_flag = true;
 
-	if (gres_plugin_node_config_unpack(reg_msg->gres_info,
-					   node_ptr->name) != SLURM_SUCCESS) {
+	if (gres_conf) {
+		gres_plugin_node_config_load_list(gres_conf);
+	} else if (gres_plugin_node_config_unpack(reg_msg->gres_info,
+						  node_ptr->name) !=
+		   SLURM_SUCCESS) {
 		error_code = SLURM_ERROR;
 		xstrcat(reason_down, "Could not unpack gres data");
-	} else if (gres_plugin_node_config_validate(
+	}
+	if ((error_code == SLURM_SUCCESS) &&
+	    (gres_plugin_node_config_validate(
 			   node_ptr->name, config_ptr->gres,
 			   &node_ptr->gres, &node_ptr->gres_list,
 			   slurmctld_conf.fast_schedule, &reason_down)
-		   != SLURM_SUCCESS) {
+	     != SLURM_SUCCESS)) {
 		error_code = EINVAL;
 		/* reason_down set in function above */
 	}
@@ -2904,6 +2915,52 @@ void node_did_resp (char *name)
 	debug2("node_did_resp %s",name);
 }
 
+/*
+ * node_list_did_resp - record that every node of an aggregated ping
+ *	reply is responding, along with its CPU load
+ * IN ping_resp - reply naming the nodes, cpu_load in node_list order
+ * NOTE: READ lock_slurmctld config and WRITE node before entry
+ */
+extern void node_list_did_resp(ping_slurmd_resp_list_msg_t *ping_resp)
+{
+#ifdef HAVE_FRONT_END
+	front_end_record_t *node_ptr;
+#else
+	struct node_record *node_ptr;
+#endif
+	hostlist_t hl;
+	hostlist_iterator_t itr;
+	char name[MAX_SLURM_NAME];
+	time_t now = time(NULL);
+	uint32_t i = 0;
+
+	if (!ping_resp->node_list)
+		return;
+	hl = hostlist_create(ping_resp->node_list);
+	itr = hostlist_iterator_create(hl);
+	while (hostlist_next_buf(itr, 0, name, sizeof(name))) {
+#ifdef HAVE_FRONT_END
+		node_ptr = find_front_end_record(name);
+#else
+		node_ptr = find_node_record(name);
+#endif
+		if (node_ptr == NULL) {
+			error("node_list_did_resp unable to find node %s",
+			      name);
+			i++;
+			continue;
+		}
+		_node_did_resp(node_ptr);
+		if (i < ping_resp->node_cnt)
+			reset_node_load(name, ping_resp->cpu_load[i]);
+		i++;
+	}
+	hostlist_iterator_destroy(itr);
+	hostlist_destroy(hl);
+	last_node_update = now;
+	debug2("node_list_did_resp %s", ping_resp->node_list);
+}
+
 /*
  * node_not_resp - record that the specified node is not responding
  * IN name - name of the node
@@ -106,10 +106,34 @@ static uint32_t *rpc_user_id = NULL;
 static uint32_t *rpc_user_cnt = NULL;
 static uint64_t *rpc_user_time = NULL;
 
+static pthread_mutex_t comp_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int comp_size = 0;	/* Size of comp_* arrays */
+static slurm_addr_t *comp_addr = NULL;	/* message aggregation collectors */
+static uint32_t *comp_batch_cnt = NULL;
+static uint32_t *comp_msg_cnt = NULL;
+static uint32_t *comp_batch_max = NULL;
+
+/* Node registrations waiting to be validated together */
+#define NODE_REG_BATCH_MAX 256
+#define NODE_REG_LOCK_MAX  32	/* registrations validated per lock hold */
+typedef struct {
+	slurm_msg_t *msg;
+	List gres_conf;		/* gres data unpacked ahead of validation */
+	int error_code;
+	bool newly_up;
+	bool done;
+} node_reg_t;
+static pthread_mutex_t node_reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t node_reg_cond = PTHREAD_COND_INITIALIZER;
+static List node_reg_list = NULL;
+static bool node_reg_active = false;
+
 static pthread_mutex_t throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t throttle_cond = PTHREAD_COND_INITIALIZER;
 
 static void         _fill_ctld_conf(slurm_ctl_conf_t * build_ptr);
+static void         _node_reg_batch(node_reg_t *node_reg);
+static void         _node_reg_validate(List batch);
 static void         _kill_job_on_msg_fail(uint32_t job_id);
 static int          _is_prolog_finished(uint32_t job_id);
 static int	    _launch_batch_step(job_desc_msg_t *job_desc_msg,
@@ -182,7 +206,8 @@ inline static void  _slurm_rpc_set_schedlog_level(slurm_msg_t *msg);
 inline static void  _slurm_rpc_shutdown_controller(slurm_msg_t * msg);
 inline static void  _slurm_rpc_shutdown_controller_immediate(slurm_msg_t *
 							     msg);
-inline static void  _slurm_rpc_step_complete(slurm_msg_t * msg);
+inline static void  _slurm_rpc_step_complete(slurm_msg_t * msg,
+					     bool running_composite);
 inline static void  _slurm_rpc_step_layout(slurm_msg_t * msg);
 inline static void  _slurm_rpc_step_update(slurm_msg_t * msg);
 inline static void  _slurm_rpc_submit_batch_job(slurm_msg_t * msg);
@@ -490,7 +515,7 @@ void slurmctld_req(slurm_msg_t *msg, connection_arg_t *arg)
 		/* No body to free */
 		break;
 	case REQUEST_STEP_COMPLETE:
-		_slurm_rpc_step_complete(msg);
+		_slurm_rpc_step_complete(msg, 0);
 		slurm_free_step_complete_msg(msg->data);
 		break;
 	case REQUEST_STEP_LAYOUT:
@@ -683,6 +708,7 @@ static void _fill_ctld_conf(slurm_ctl_conf_t * conf_ptr)
 	conf_ptr->checkpoint_type     = xstrdup(conf->checkpoint_type);
 	conf_ptr->chos_loc            = xstrdup(conf->chos_loc);
 	conf_ptr->cluster_name        = xstrdup(conf->cluster_name);
+	conf_ptr->comm_params         = xstrdup(conf->comm_params);
 	conf_ptr->complete_wait       = conf->complete_wait;
 	conf_ptr->control_addr        = xstrdup(conf->control_addr);
 	conf_ptr->control_machine     = xstrdup(conf->control_machine);
@@ -2508,9 +2534,6 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 	bool newly_up = false;
 	slurm_node_registration_status_msg_t *node_reg_stat_msg =
 		(slurm_node_registration_status_msg_t *) msg->data;
-	/* Locks: Read config, write job, write node */
-	slurmctld_lock_t job_write_lock = {
-		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
 
 	START_TIMER;
@@ -2539,20 +2562,37 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 			      "set DebugFlags=NO_CONF_HASH in your slurm.conf.",
 			      node_reg_stat_msg->node_name);
 		}
-		if (!running_composite)
-			lock_slurmctld(job_write_lock);
+		if (running_composite) {
 #ifdef HAVE_FRONT_END		/* Operates only on front-end */
-		error_code = validate_nodes_via_front_end(node_reg_stat_msg,
-							  msg->protocol_version,
-							  &newly_up);
+			error_code = validate_nodes_via_front_end(
+				node_reg_stat_msg, msg->protocol_version,
+				&newly_up);
 #else
-		validate_jobs_on_node(node_reg_stat_msg);
-		error_code = validate_node_specs(node_reg_stat_msg,
-						 msg->protocol_version,
-						 &newly_up);
+			validate_jobs_on_node(node_reg_stat_msg);
+			error_code = validate_node_specs(node_reg_stat_msg,
+							 msg->protocol_version,
+							 NULL, &newly_up);
 #endif
-		if (!running_composite)
-			unlock_slurmctld(job_write_lock);
+		} else {
+			node_reg_t node_reg;
+
+			memset(&node_reg, 0, sizeof(node_reg_t));
+			node_reg.msg = msg;
+#ifndef HAVE_FRONT_END
+			/* Unpack gres data before queuing, outside of the
+			 * slurmctld locks (the gres plugins still serialize
+			 * this on their own lock) */
+			if (gres_plugin_node_config_unpack_list(
+				    node_reg_stat_msg->gres_info,
+				    node_reg_stat_msg->node_name,
+				    &node_reg.gres_conf) != SLURM_SUCCESS)
+				/* Unpack again to report the error */
+				set_buf_offset(node_reg_stat_msg->gres_info, 0);
+#endif
+			_node_reg_batch(&node_reg);
+			error_code = node_reg.error_code;
+			newly_up = node_reg.newly_up;
+		}
 		END_TIMER2("_slurm_rpc_node_registration");
 		if (newly_up) {
 			queue_job_scheduler();
@@ -2572,6 +2612,106 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg,
 	}
 }
 
+/*
+ * _node_reg_batch - queue a node registration for validation and wait until
+ *	it has been validated. Registrations arriving while others are being
+ *	validated accumulate and the first of their threads to run validates
+ *	all of them, taking the job and node write locks once per
+ *	NODE_REG_LOCK_MAX registrations rather than once each.
+ */
+static void _node_reg_batch(node_reg_t *node_reg)
+{
+	List batch;
+	int cnt;
+
+	slurm_mutex_lock(&node_reg_mutex);
+	if (!node_reg_list)
+		node_reg_list = list_create(NULL);
+	list_append(node_reg_list, node_reg);
+	while (!node_reg->done) {
+		if (node_reg_active) {
+			pthread_cond_wait(&node_reg_cond, &node_reg_mutex);
+			continue;
+		}
+		node_reg_active = true;
+		batch = list_create(NULL);
+		for (cnt = 0; cnt < NODE_REG_BATCH_MAX; cnt++) {
+			node_reg_t *next = list_dequeue(node_reg_list);
+			if (!next)
+				break;
+			list_append(batch, next);
+		}
+		slurm_mutex_unlock(&node_reg_mutex);
+
+		_node_reg_validate(batch);
+
+		slurm_mutex_lock(&node_reg_mutex);
+		list_destroy(batch);
+		node_reg_active = false;
+		pthread_cond_broadcast(&node_reg_cond);
+	}
+	slurm_mutex_unlock(&node_reg_mutex);
+}
+
+/* Validate a batch of queued node registrations, see _node_reg_batch().
+ * The locks are released every NODE_REG_LOCK_MAX registrations so that a
+ * full batch does not keep other RPCs waiting. */
+static void _node_reg_validate(List batch)
+{
+	/* Locks: Read config, write job, write node */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK };
+	static int active_rpc_cnt = 0;
+	ListIterator itr;
+	node_reg_t *node_reg;
+	slurm_node_registration_status_msg_t *reg_msg;
+	int cnt = 0;
+	DEF_TIMERS;
+
+	START_TIMER;
+	itr = list_iterator_create(batch);
+	while ((node_reg = list_next(itr))) {
+		if ((cnt % NODE_REG_LOCK_MAX) == 0) {
+			if (cnt) {
+				unlock_slurmctld(job_write_lock);
+				_throttle_fini(&active_rpc_cnt);
+			}
+			_throttle_start(&active_rpc_cnt);
+			lock_slurmctld(job_write_lock);
+		}
+		cnt++;
+		reg_msg = node_reg->msg->data;
+#ifdef HAVE_FRONT_END		/* Operates only on front-end */
+		node_reg->error_code = validate_nodes_via_front_end(
+			reg_msg, node_reg->msg->protocol_version,
+			&node_reg->newly_up);
+#else
+		validate_jobs_on_node(reg_msg);
+		node_reg->error_code = validate_node_specs(
+			reg_msg, node_reg->msg->protocol_version,
+			node_reg->gres_conf, &node_reg->newly_up);
+		node_reg->gres_conf = NULL;
+#endif
+	}
+	list_iterator_destroy(itr);
+	if (cnt) {
+		unlock_slurmctld(job_write_lock);
+		_throttle_fini(&active_rpc_cnt);
+	}
+	END_TIMER2("_node_reg_validate");
+
+	/* Mark done only once no longer referenced, the waiting threads
+	 * reply and release their node_reg_t */
+	slurm_mutex_lock(&node_reg_mutex);
+	itr = list_iterator_create(batch);
+	while ((node_reg = list_next(itr)))
+		node_reg->done = true;
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&node_reg_mutex);
+	debug2("_node_reg_validate: validated %d node registrations %s",
+	       cnt, TIME_STR);
+}
+
 /* _slurm_rpc_job_alloc_info - process RPC to get details on existing job */
 static void _slurm_rpc_job_alloc_info(slurm_msg_t * msg)
 {
@@ -3081,7 +3221,7 @@ static void _slurm_rpc_shutdown_controller_immediate(slurm_msg_t * msg)
  *      completion of a job step on at least some nodes.
  *	If the job step is complete, it may
  *	represent the termination of an entire job */
-static void _slurm_rpc_step_complete(slurm_msg_t *msg)
+static void _slurm_rpc_step_complete(slurm_msg_t *msg, bool running_composite)
 {
 	static int active_rpc_cnt = 0;
 	int error_code = SLURM_SUCCESS, rc, rem;
@@ -3102,14 +3242,20 @@ static void _slurm_rpc_step_complete(slurm_msg_t *msg)
 		     req->job_id, req->job_step_id, req->range_first,
 		     req->range_last, req->step_rc, uid);
 
-	_throttle_start(&active_rpc_cnt);
-	lock_slurmctld(job_write_lock);
+	/* Only throttle on none composite messages, the lock should
+	 * already be set earlier. */
+	if (!running_composite) {
+		_throttle_start(&active_rpc_cnt);
+		lock_slurmctld(job_write_lock);
+	}
 	rc = step_partial_comp(req, uid, &rem, &step_rc);
 
 	if (rc || rem) {	/* some error or not totally done */
 		/* Note: Error printed within step_partial_comp */
-		unlock_slurmctld(job_write_lock);
-		_throttle_fini(&active_rpc_cnt);
+		if (!running_composite) {
+			unlock_slurmctld(job_write_lock);
+			_throttle_fini(&active_rpc_cnt);
+		}
 		slurm_send_rc_msg(msg, rc);
 		if (!rc)	/* partition completion */
 			schedule_job_save();	/* Has own locking */
@@ -3120,8 +3266,10 @@ static void _slurm_rpc_step_complete(slurm_msg_t *msg)
 		/* FIXME: test for error, possibly cause batch job requeue */
 		error_code = job_complete(req->job_id, uid, false,
 					  false, step_rc);
-		unlock_slurmctld(job_write_lock);
-		_throttle_fini(&active_rpc_cnt);
+		if (!running_composite) {
+			unlock_slurmctld(job_write_lock);
+			_throttle_fini(&active_rpc_cnt);
+		}
 		END_TIMER2("_slurm_rpc_step_complete");
 
 		/* return result */
@@ -3140,8 +3288,10 @@ static void _slurm_rpc_step_complete(slurm_msg_t *msg)
 	} else {
 		error_code = job_step_complete(req->job_id, req->job_step_id,
 					       uid, false, step_rc);
-		unlock_slurmctld(job_write_lock);
-		_throttle_fini(&active_rpc_cnt);
+		if (!running_composite) {
+			unlock_slurmctld(job_write_lock);
+			_throttle_fini(&active_rpc_cnt);
+		}
 		END_TIMER2("_slurm_rpc_step_complete");
 
 		/* return result */
@@ -5356,6 +5506,80 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
 
+static void _clear_comp_stats(void)
+{
+	int i;
+
+	slurm_mutex_lock(&comp_mutex);
+	for (i = 0; i < comp_size; i++) {
+		comp_batch_cnt[i] = 0;
+		comp_msg_cnt[i] = 0;
+		comp_batch_max[i] = 0;
+	}
+	slurm_mutex_unlock(&comp_mutex);
+}
+
+static void _pack_comp_stats(char **buffer_ptr, int *buffer_size,
+			     uint16_t protocol_version)
+{
+	char **addr = NULL, addrbuf[64];
+	uint32_t i, cnt;
+	Buf buffer;
+
+	if (protocol_version < SLURM_15_08_PROTOCOL_VERSION)
+		return;
+
+	slurm_mutex_lock(&comp_mutex);
+	for (cnt = 0; cnt < comp_size; cnt++) {
+		if (comp_batch_cnt[cnt] == 0)
+			break;
+	}
+	if (cnt)
+		addr = xmalloc(sizeof(char *) * cnt);
+	for (i = 0; i < cnt; i++) {
+		slurm_print_slurm_addr(&comp_addr[i], addrbuf,
+				       sizeof(addrbuf));
+		addr[i] = xstrdup(addrbuf);
+	}
+
+	buffer = create_buf(*buffer_ptr, *buffer_size);
+	set_buf_offset(buffer, *buffer_size);
+	packstr_array(addr, cnt, buffer);
+	pack32_array(comp_batch_cnt, cnt, buffer);
+	pack32_array(comp_msg_cnt,   cnt, buffer);
+	pack32_array(comp_batch_max, cnt, buffer);
+	slurm_mutex_unlock(&comp_mutex);
+
+	for (i = 0; i < cnt; i++)
+		xfree(addr[i]);
+	xfree(addr);
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
+static void _pack_auth_stats(char **buffer_ptr, int *buffer_size,
+			     uint16_t protocol_version)
+{
+	slurm_auth_stats_t stats;
+	Buf buffer;
+
+	if (protocol_version < SLURM_15_08_PROTOCOL_VERSION)
+		return;
+
+	slurm_auth_get_stats(&stats);
+	buffer = create_buf(*buffer_ptr, *buffer_size);
+	set_buf_offset(buffer, *buffer_size);
+	pack32(stats.create_cnt,  buffer);
+	pack64(stats.create_time, buffer);
+	pack32(stats.verify_cnt,  buffer);
+	pack64(stats.verify_time, buffer);
+	pack32(stats.verify_max,  buffer);
+	pack32(stats.session_cnt, buffer);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
 /* _slurm_rpc_dump_stats - process RPC for statistics information */
 inline static void _slurm_rpc_dump_stats(slurm_msg_t * msg)
 {
@@ -5386,13 +5610,19 @@ inline static void _slurm_rpc_dump_stats(slurm_msg_t * msg)
 	if (request_msg->command_id == STAT_COMMAND_RESET) {
 		reset_stats(1);
 		_clear_rpc_stats();
+		slurm_auth_reset_stats();
+		_clear_comp_stats();
 		pack_all_stat(0, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(0, &dump, &dump_size, msg->protocol_version);
+		_pack_auth_stats(&dump, &dump_size, msg->protocol_version);
+		_pack_comp_stats(&dump, &dump_size, msg->protocol_version);
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 	} else {
 		pack_all_stat(1, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(1, &dump, &dump_size, msg->protocol_version);
+		_pack_auth_stats(&dump, &dump_size, msg->protocol_version);
+		_pack_comp_stats(&dump, &dump_size, msg->protocol_version);
 		response_msg.data = dump;
 		response_msg.data_size = dump_size;
 	}
@@ -5526,6 +5756,50 @@ static int _delta_tv(struct timeval *tv)
 	return delta_t;
 }
 
+/* Record the size of a batch of aggregated messages sent by the
+ * collector comp_msg->sender. Messages embedded in a MESSAGE_COMPOSITE
+ * from a lower level collector are counted against that collector. */
+static void _update_comp_stats(composite_msg_t *comp_msg)
+{
+	ListIterator itr;
+	slurm_msg_t *next_msg;
+	uint32_t count = 0;
+	int i;
+
+	if (!comp_msg->msg_list)
+		return;
+	itr = list_iterator_create(comp_msg->msg_list);
+	while ((next_msg = list_next(itr))) {
+		if (next_msg->msg_type != MESSAGE_COMPOSITE)
+			count++;
+	}
+	list_iterator_destroy(itr);
+	if (!count)
+		return;
+
+	slurm_mutex_lock(&comp_mutex);
+	if (comp_size == 0) {
+		comp_size = 200;  /* Capture info for first 200 collectors */
+		comp_addr      = xmalloc(sizeof(slurm_addr_t) * comp_size);
+		comp_batch_cnt = xmalloc(sizeof(uint32_t) * comp_size);
+		comp_msg_cnt   = xmalloc(sizeof(uint32_t) * comp_size);
+		comp_batch_max = xmalloc(sizeof(uint32_t) * comp_size);
+	}
+	for (i = 0; i < comp_size; i++) {
+		if (comp_batch_cnt[i] == 0)
+			comp_addr[i] = comp_msg->sender;
+		else if ((comp_addr[i].sin_addr.s_addr !=
+			  comp_msg->sender.sin_addr.s_addr) ||
+			 (comp_addr[i].sin_port != comp_msg->sender.sin_port))
+			continue;
+		comp_batch_cnt[i]++;
+		comp_msg_cnt[i] += count;
+		comp_batch_max[i] = MAX(comp_batch_max[i], count);
+		break;
+	}
+	slurm_mutex_unlock(&comp_mutex);
+}
+
 static void  _slurm_rpc_composite_msg(slurm_msg_t *msg)
 {
 	static time_t config_update = 0;
@@ -5588,7 +5862,8 @@ static void  _slurm_rpc_composite_msg(slurm_msg_t *msg)
 	if (list_count(comp_resp_msg.msg_list)) {
 		slurm_msg_t resp_msg;
 		slurm_msg_t_init(&resp_msg);
-		resp_msg.flags    = msg->flags;
+		resp_msg.flags    = msg->flags & ~(SLURM_MSG_KEEP_CONN |
+						   SLURM_MSG_SESSION_AUTH);
 		resp_msg.protocol_version = msg->protocol_version;
 		memcpy(&resp_msg.address, &comp_msg->sender,
 		       sizeof(slurm_addr_t));
@@ -5632,6 +5907,7 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 
 	START_TIMER;
 
+	_update_comp_stats(comp_msg);
 	itr = list_iterator_create(comp_msg->msg_list);
 	while ((next_msg = list_next(itr))) {
 		if (_delta_tv(start_tv) >= timeout) {
@@ -5697,6 +5973,9 @@ static void  _slurm_rpc_comp_msg_list(composite_msg_t * comp_msg,
 		case MESSAGE_NODE_REGISTRATION_STATUS:
 			_slurm_rpc_node_registration(next_msg, 1);
 			break;
+		case REQUEST_STEP_COMPLETE:
+			_slurm_rpc_step_complete(next_msg, 1);
+			break;
 		default:
 			error("_slurm_rpc_comp_msg_list: invalid msg type");
 			break;
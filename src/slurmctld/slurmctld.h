@@ -92,6 +92,10 @@
 #define MAX_SERVER_THREADS 256
 #endif
 
+/* Close a persistent client connection after it has been idle for
+ * PERSIST_CONN_IDLE seconds, see CommunicationParameters=persist_conn */
+#define PERSIST_CONN_IDLE 60
+
 /* Perform full slurmctld's state every PERIODIC_CHECKPOINT seconds */
 #ifndef PERIODIC_CHECKPOINT
 #define	PERIODIC_CHECKPOINT	300
@@ -1630,6 +1634,11 @@ extern void node_fini (void);
  * IN name - name of the node */
 extern void node_did_resp (char *name);
 
+/* node_list_did_resp - record that every node of an aggregated ping reply
+ *	is responding and set its CPU load
+ * IN ping_resp - reply naming the nodes, cpu_load in node_list order */
+extern void node_list_did_resp(ping_slurmd_resp_list_msg_t *ping_resp);
+
 /*
  * node_not_resp - record that the specified node is not responding
  * IN name - name of the node
@@ -2228,12 +2237,16 @@ extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
  *	if not set state to down, in any case update last_response
  * IN reg_msg - node registration message
  * IN protocol_version - Version of Slurm on this node
+ * IN gres_conf - reg_msg's gres data already unpacked by
+ *	gres_plugin_node_config_unpack_list(), or NULL to unpack it here;
+ *	consumed
  * OUT newly_up - set if node newly brought into service
  * RET 0 if no error, ENOENT if no such node, EINVAL if values too low
  * NOTE: READ lock_slurmctld config before entry
  */
 extern int validate_node_specs(slurm_node_registration_status_msg_t *reg_msg,
-			       uint16_t protocol_version, bool *newly_up);
+			       uint16_t protocol_version, List gres_conf,
+			       bool *newly_up);
 
 /*
  * validate_nodes_via_front_end - validate all nodes on a cluster as having
@@ -40,9 +40,13 @@
 #  include "config.h"
 #endif
 
+#include <libgen.h>
 #include <poll.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <sys/errno.h>
 #include <string.h>
@@ -50,6 +54,8 @@
 
 #include "slurm/slurm_errno.h"
 #include "src/common/list.h"
+#include "src/common/macros.h"
+#include "src/common/timers.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -96,28 +102,173 @@ int waitpid_timeout (const char *name, pid_t pid, int *pstatus, int timeout)
 	return (0);
 }
 
+/* Maximum number of scripts matched by one pattern run at the same time */
+#define MAX_PARALLEL_SCRIPTS 16
+
+/* Glob results of a pattern, see _script_list_create() */
+typedef struct script_cache {
+	char *pattern;
+	time_t dir_mtime;
+	List scripts;
+} script_cache_t;
+
+static List script_cache = NULL;
+static pthread_mutex_t script_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Maximum number of scripts run at the same time by all run_script() calls */
+#define MAX_RUNNING_SCRIPTS 64
+
 /*
- * Run a prolog or epilog script (does NOT drop privileges)
+ * Upper limits of the script timing histogram buckets in msec, the last
+ * bucket holds everything longer than that.
+ */
+#define SCRIPT_HIST_BUCKETS 6
+static const long script_hist_limit[SCRIPT_HIST_BUCKETS - 1] = {
+	10, 100, 1000, 10000, 100000
+};
+static const char *script_hist_label[SCRIPT_HIST_BUCKETS] = {
+	"<10ms", "<100ms", "<1s", "<10s", "<100s", ">=100s"
+};
+
+/* Timing of one class of scripts (prolog, epilog, etc.) */
+typedef struct script_stats {
+	char *name;
+	uint32_t wait_hist[SCRIPT_HIST_BUCKETS]; /* time waiting for a slot */
+	uint32_t run_hist[SCRIPT_HIST_BUCKETS];	 /* time the script ran */
+} script_stats_t;
+
+static int scripts_running = 0;
+static List script_stats = NULL;
+static pthread_mutex_t script_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t script_pool_cond = PTHREAD_COND_INITIALIZER;
+
+/*
+ * Take one of the MAX_RUNNING_SCRIPTS slots, waiting for one to be freed
+ * if block is set.
+ * RET true if a slot was taken
+ */
+static bool _script_slot_get(bool block)
+{
+	bool rc = true;
+
+	slurm_mutex_lock(&script_pool_lock);
+	while (scripts_running >= MAX_RUNNING_SCRIPTS) {
+		if (!block) {
+			rc = false;
+			break;
+		}
+		pthread_cond_wait(&script_pool_cond, &script_pool_lock);
+	}
+	if (rc)
+		scripts_running++;
+	slurm_mutex_unlock(&script_pool_lock);
+
+	return rc;
+}
+
+static void _script_slot_put(void)
+{
+	slurm_mutex_lock(&script_pool_lock);
+	scripts_running--;
+	pthread_cond_signal(&script_pool_cond);
+	slurm_mutex_unlock(&script_pool_lock);
+}
+
+static void _script_stats_free(void *x)
+{
+	script_stats_t *stats = (script_stats_t *) x;
+
+	xfree(stats->name);
+	xfree(stats);
+}
+
+static int _script_stats_find(void *x, void *key)
+{
+	return !strcmp(((script_stats_t *) x)->name, (char *) key);
+}
+
+/*
+ * Count the time elapsed since start in the histogram of the scripts of
+ * class name, the run histogram if run is set, the wait one otherwise.
+ */
+static void _script_stats_add(const char *name, struct timeval *start,
+			      bool run)
+{
+	script_stats_t *stats;
+	struct timeval now;
+	long delta_t;
+	int i;
+
+	gettimeofday(&now, NULL);
+	delta_t = (now.tv_sec - start->tv_sec) * 1000 +
+		  (now.tv_usec - start->tv_usec) / 1000;
+	for (i = 0; i < (SCRIPT_HIST_BUCKETS - 1); i++) {
+		if (delta_t < script_hist_limit[i])
+			break;
+	}
+
+	slurm_mutex_lock(&script_pool_lock);
+	if (!script_stats)
+		script_stats = list_create(_script_stats_free);
+	if (!(stats = list_find_first(script_stats, _script_stats_find,
+				      (void *) name))) {
+		stats = xmalloc(sizeof(script_stats_t));
+		stats->name = xstrdup(name);
+		list_append(script_stats, stats);
+	}
+	if (run)
+		stats->run_hist[i]++;
+	else
+		stats->wait_hist[i]++;
+	slurm_mutex_unlock(&script_pool_lock);
+}
+
+static void _script_hist_str(char **str, const char *stage, uint32_t *hist)
+{
+	int i;
+
+	xstrfmtcat(*str, "\n  %s", stage);
+	for (i = 0; i < SCRIPT_HIST_BUCKETS; i++)
+		xstrfmtcat(*str, " %s=%u", script_hist_label[i], hist[i]);
+}
+
+extern char *run_script_stats(void)
+{
+	script_stats_t *stats;
+	ListIterator iter;
+	char *str = NULL;
+
+	slurm_mutex_lock(&script_pool_lock);
+	xstrfmtcat(str, "Running=%d MaxRunning=%d", scripts_running,
+		   MAX_RUNNING_SCRIPTS);
+	if (script_stats) {
+		iter = list_iterator_create(script_stats);
+		while ((stats = list_next(iter))) {
+			xstrfmtcat(str, "\n%s:", stats->name);
+			_script_hist_str(&str, "wait", stats->wait_hist);
+			_script_hist_str(&str, "run ", stats->run_hist);
+		}
+		list_iterator_destroy(iter);
+	}
+	slurm_mutex_unlock(&script_pool_lock);
+
+	return str;
+}
+
+/*
+ * Start a prolog or epilog script (does NOT drop privileges)
  * name IN: class of program (prolog, epilog, etc.),
  * path IN: pathname of program to run
  * job_id IN: info on associated job
- * max_wait IN: maximum time to wait in seconds, -1 for no limit
- * env IN: environment variables to use on exec, sets minimal environment
- *	if NULL
- * uid IN: user ID of job owner
- * RET 0 on success, -1 on failure.
+ * env IN: environment variables to use on exec
+ * RET pid of the script's process or -1 on failure.
  */
-static int
-_run_one_script(const char *name, const char *path, uint32_t job_id,
-		int max_wait, char **env, uid_t uid)
+static pid_t
+_start_one_script(const char *name, const char *path, uint32_t job_id,
+		  char **env)
 {
-	int status;
 	pid_t cpid;
 
-	xassert(env);
-	if (path == NULL || path[0] == '\0')
-		return 0;
-
 	if (job_id) {
 		debug("[job %u] attempting to run %s [%s]",
 			job_id, name, path);
@@ -159,11 +310,151 @@ _run_one_script(const char *name, const char *path, uint32_t job_id,
 		exit(127);
 	}
 
-	if (waitpid_timeout(name, cpid, &status, max_wait) < 0)
+	return cpid;
+}
+
+/*
+ * Run a prolog or epilog script (does NOT drop privileges)
+ * name IN: class of program (prolog, epilog, etc.),
+ * path IN: pathname of program to run
+ * job_id IN: info on associated job
+ * max_wait IN: maximum time to wait in seconds, -1 for no limit
+ * env IN: environment variables to use on exec, sets minimal environment
+ *	if NULL
+ * uid IN: user ID of job owner
+ * RET 0 on success, -1 on failure.
+ */
+static int
+_run_one_script(const char *name, const char *path, uint32_t job_id,
+		int max_wait, char **env, uid_t uid)
+{
+	DEF_TIMERS;
+	struct timeval queued, started;
+	int status, rc;
+	pid_t cpid;
+
+	xassert(env);
+	if (path == NULL || path[0] == '\0')
+		return 0;
+
+	gettimeofday(&queued, NULL);
+	_script_slot_get(true);
+	_script_stats_add(name, &queued, false);
+	START_TIMER;
+	gettimeofday(&started, NULL);
+	if ((cpid = _start_one_script(name, path, job_id, env)) < 0) {
+		_script_slot_put();
 		return (-1);
+	}
+	rc = waitpid_timeout(name, cpid, &status, max_wait);
+	_script_slot_put();
+	if (rc < 0)
+		return (-1);
+	_script_stats_add(name, &started, true);
+	END_TIMER;
+	debug2("%s [%s] ran for %s", name, path, TIME_STR);
 	return status;
 }
 
+/*
+ * Run all the scripts in list l at the same time, up to
+ * MAX_PARALLEL_SCRIPTS of them and as many as the MAX_RUNNING_SCRIPTS
+ * slots allow, each one for at most max_wait seconds.
+ * No more scripts are started once one has failed.
+ * RET status of the first script that failed or 0
+ */
+static int
+_run_parallel_scripts(const char *name, List l, uint32_t job_id,
+		      int max_wait, char **env)
+{
+	struct {
+		char *path;
+		pid_t pid;
+		struct timeval start;
+		bool killed;
+	} run[MAX_PARALLEL_SCRIPTS];
+	struct timeval now, queued;
+	ListIterator iter = list_iterator_create(l);
+	char *path = NULL, tv_str[20];
+	int i, running = 0, status, rc = 0;
+	int delay = 10, max_delay = 100;
+	long delta_t;
+	pid_t pid;
+
+	while (1) {
+		while (!rc && (running < MAX_PARALLEL_SCRIPTS)) {
+			if (!path) {
+				if (!(path = list_next(iter)))
+					break;
+				gettimeofday(&queued, NULL);
+			}
+			/* Only wait for a slot if we hold none */
+			if (!_script_slot_get(running == 0))
+				break;
+			_script_stats_add(name, &queued, false);
+			run[running].path = path;
+			gettimeofday(&run[running].start, NULL);
+			run[running].killed = false;
+			if ((run[running].pid = _start_one_script(
+				     name, path, job_id, env)) < 0) {
+				_script_slot_put();
+				rc = -1;
+			} else
+				running++;
+			path = NULL;
+		}
+		if (running == 0)
+			break;
+
+		gettimeofday(&now, NULL);
+		for (i = 0; i < running; ) {
+			pid = waitpid(run[i].pid, &status, WNOHANG);
+			if ((pid < 0) && (errno == EINTR))
+				continue;
+			delta_t = (now.tv_sec - run[i].start.tv_sec) * 1000 +
+				  (now.tv_usec - run[i].start.tv_usec) / 1000;
+			if (pid == 0) {
+				if ((max_wait > 0) && !run[i].killed &&
+				    (delta_t >= (max_wait * 1000))) {
+					info("%s: timeout after %ds: "
+					     "killing pgid %d", name,
+					     max_wait, run[i].pid);
+					killpg(run[i].pid, SIGKILL);
+					run[i].killed = true;
+				}
+				i++;
+				continue;
+			}
+			if (pid < 0) {
+				error("waitpid: %m");
+				status = -1;
+			}
+			killpg(run[i].pid, SIGKILL);  /* kill children too */
+			_script_slot_put();
+			_script_stats_add(name, &run[i].start, true);
+			slurm_diff_tv_str(&run[i].start, &now, tv_str,
+					  sizeof(tv_str), NULL, 0, &delta_t);
+			debug2("%s [%s] ran for %s", name, run[i].path, tv_str);
+			if (status) {
+				error("%s: exited with status 0x%04x\n",
+				      run[i].path, status);
+				if (!rc)
+					rc = status;
+			}
+			run[i] = run[--running];
+			delay = 10;
+		}
+
+		if (running) {
+			poll(NULL, 0, delay);
+			delay = MIN(max_delay, delay * 2);
+		}
+	}
+	list_iterator_destroy(iter);
+
+	return rc;
+}
+
 static void _xfree_f (void *x)
 {
 	xfree (x);
@@ -175,7 +466,7 @@ static int _ef (const char *p, int errnum)
 	return error ("run_script: glob: %s: %s", p, strerror (errno));
 }
 
-static List _script_list_create (const char *pattern)
+static List _script_list_glob (const char *pattern)
 {
 	glob_t gl;
 	size_t i;
@@ -209,8 +500,89 @@ static List _script_list_create (const char *pattern)
 	return l;
 }
 
+static void _script_cache_free(void *x)
+{
+	script_cache_t *cache = (script_cache_t *) x;
+
+	xfree(cache->pattern);
+	if (cache->scripts)
+		list_destroy(cache->scripts);
+	xfree(cache);
+}
+
+static int _script_cache_find(void *x, void *key)
+{
+	return !strcmp(((script_cache_t *) x)->pattern, (char *) key);
+}
+
+static List _script_list_copy(List l)
+{
+	List copy;
+	ListIterator iter;
+	char *s;
+
+	if (!l)
+		return NULL;
+	copy = list_create((ListDelF) _xfree_f);
+	iter = list_iterator_create(l);
+	while ((s = list_next(iter)))
+		list_append(copy, xstrdup(s));
+	list_iterator_destroy(iter);
+	return copy;
+}
+
+/*
+ * Return the list of scripts matching pattern. A pattern with wildcards
+ * is only expanded again once the directory holding the scripts has
+ * changed, rather than reading that directory for every job.
+ */
+static List _script_list_create (const char *pattern)
+{
+	script_cache_t *cache;
+	struct stat stat_buf;
+	char *dir_copy, *dir;
+	List l;
+
+	if (!strpbrk(pattern, "*?["))
+		return _script_list_glob(pattern);
+
+	dir_copy = xstrdup(pattern);
+	dir = dirname(dir_copy);
+	/* Changes within the last second may not show in the mtime */
+	if (strpbrk(dir, "*?[") || (stat(dir, &stat_buf) < 0) ||
+	    (stat_buf.st_mtime >= (time(NULL) - 1))) {
+		xfree(dir_copy);
+		return _script_list_glob(pattern);
+	}
+	xfree(dir_copy);
+
+	slurm_mutex_lock(&script_cache_lock);
+	if (!script_cache)
+		script_cache = list_create(_script_cache_free);
+	cache = list_find_first(script_cache, _script_cache_find,
+				(void *) pattern);
+	if (!cache) {
+		cache = xmalloc(sizeof(script_cache_t));
+		cache->pattern = xstrdup(pattern);
+		list_append(script_cache, cache);
+	} else if (cache->dir_mtime != stat_buf.st_mtime) {
+		if (cache->scripts)
+			list_destroy(cache->scripts);
+		cache->scripts = NULL;
+		cache->dir_mtime = 0;
+	}
+	if (!cache->dir_mtime) {
+		cache->scripts = _script_list_glob(pattern);
+		cache->dir_mtime = stat_buf.st_mtime;
+	}
+	l = _script_list_copy(cache->scripts);
+	slurm_mutex_unlock(&script_cache_lock);
+
+	return l;
+}
+
 int run_script(const char *name, const char *pattern, uint32_t job_id,
-	       int max_wait, char **env, uid_t uid)
+	       int max_wait, char **env, uid_t uid, bool parallel)
 {
 	int rc = 0;
 	List l;
@@ -224,6 +596,13 @@ int run_script(const char *name, const char *pattern, uint32_t job_id,
 	if (l == NULL)
 		return error ("Unable to run %s [%s]", name, pattern);
 
+	if (parallel && (list_count(l) > 1)) {
+		xassert(env);
+		rc = _run_parallel_scripts(name, l, job_id, max_wait, env);
+		list_destroy(l);
+		return rc;
+	}
+
 	i = list_iterator_create (l);
 	while ((s = list_next (i))) {
 		rc = _run_one_script (name, s, job_id, max_wait, env, uid);
@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <inttypes.h>
+#include <stdbool.h>
 
 /*
  *  Same as waitpid(2) but kill process group for pid after timeout secs.
@@ -63,9 +64,18 @@ int waitpid_timeout (const char *name, pid_t pid, int *pstatus, int timeout);
  * env IN: environment variables to use on exec, sets minimal environment 
  *	if NULL
  * uid IN: user ID of job owner
+ * parallel IN: run all the scripts matching path at the same time
  * RET 0 on success, -1 on failure.
  */
 int run_script(const char *name, const char *path, uint32_t jobid, 
-	       int max_wait, char **env, uid_t uid);
+	       int max_wait, char **env, uid_t uid, bool parallel);
+
+/*
+ * Return a description of the scripts run by run_script(): how many of
+ * them run now and, for each class of script, histograms of the time they
+ * waited for one of the slots and of the time they ran.
+ * Free the returned string with xfree().
+ */
+extern char *run_script_stats(void);
 
 #endif /* _RUN_SCRIPT_H */
@@ -50,6 +50,7 @@
 #include <string.h>
 #include <sys/param.h>
 #include <sys/poll.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -169,6 +170,7 @@ static void _rpc_batch_job(slurm_msg_t *msg, bool new_msg);
 static void _rpc_prolog(slurm_msg_t *msg);
 static void _rpc_job_notify(slurm_msg_t *);
 static void _rpc_signal_tasks(slurm_msg_t *);
+static int  _signal_tasks(slurm_msg_t *);
 static void _rpc_checkpoint_tasks(slurm_msg_t *);
 static void _rpc_complete_batch(slurm_msg_t *);
 static void _rpc_terminate_tasks(slurm_msg_t *);
@@ -177,6 +179,7 @@ static void _rpc_reattach_tasks(slurm_msg_t *);
 static void _rpc_signal_job(slurm_msg_t *);
 static void _rpc_suspend_job(slurm_msg_t *msg);
 static void _rpc_terminate_job(slurm_msg_t *);
+static void _rpc_node_msg_list(slurm_msg_t *);
 static void _rpc_update_time(slurm_msg_t *);
 static void _rpc_shutdown(slurm_msg_t *msg);
 static void _rpc_reconfig(slurm_msg_t *msg);
@@ -184,6 +187,7 @@ static void _rpc_reboot(slurm_msg_t *msg);
 static void _rpc_pid2jid(slurm_msg_t *msg);
 static int  _rpc_file_bcast(slurm_msg_t *msg);
 static int  _rpc_ping(slurm_msg_t *);
+static void _send_ping_resp_list(slurm_msg_t *msg);
 static int  _rpc_health_check(slurm_msg_t *);
 static int  _rpc_acct_gather_update(slurm_msg_t *);
 static int  _rpc_acct_gather_energy(slurm_msg_t *);
@@ -222,6 +226,7 @@ static void _add_job_running_prolog(uint32_t job_id);
 static void _remove_job_running_prolog(uint32_t job_id);
 static int  _match_jobid(void *s0, void *s1);
 static void _wait_for_job_running_prolog(uint32_t job_id);
+static void _zygote_stop(void);
 
 /*
  *  List of threads waiting for jobs to complete
@@ -258,6 +263,11 @@ static uint32_t active_job_id[JOB_STATE_CNT];
 
 static pthread_mutex_t prolog_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* slurmstepd zygote, see LaunchParameters=slurmstepd_zygote */
+static pthread_mutex_t zygote_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int zygote_fd = -1;
+static pid_t zygote_pid = -1;
+
 void
 slurmd_req(slurm_msg_t *msg)
 {
@@ -277,6 +287,9 @@ slurmd_req(slurm_msg_t *msg)
 			job_limits_loaded = false;
 		}
 		slurm_mutex_unlock(&job_limits_mutex);
+		slurm_mutex_lock(&zygote_mutex);
+		_zygote_stop();
+		slurm_mutex_unlock(&zygote_mutex);
 		return;
 	}
 
@@ -358,6 +371,12 @@ slurmd_req(slurm_msg_t *msg)
 		_rpc_terminate_job(msg);
 		slurm_free_kill_job_msg(msg->data);
 		break;
+	case REQUEST_NODE_MSG_LIST:
+		debug2("Processing RPC: REQUEST_NODE_MSG_LIST");
+		last_slurmctld_msg = time(NULL);
+		_rpc_node_msg_list(msg);
+		slurm_free_node_msg_list(msg->data);
+		break;
 	case REQUEST_COMPLETE_BATCH_SCRIPT:
 		debug2("Processing RPC: REQUEST_COMPLETE_BATCH_SCRIPT");
 		_rpc_complete_batch(msg);
@@ -729,6 +748,121 @@ rwfail:
 }
 
 
+/* Return true if new slurmstepds should be forked by the zygote */
+static bool _zygote_enabled(void)
+{
+	char *launch_params;
+	bool rc = false;
+
+#ifndef SLURMSTEPD_MEMCHECK
+	if (conf->chos_loc)
+		return false;
+	launch_params = slurm_get_launch_params();
+	if (launch_params && strstr(launch_params, "slurmstepd_zygote"))
+		rc = true;
+	xfree(launch_params);
+#endif
+	return rc;
+}
+
+/* Start the slurmstepd zygote. Call with zygote_mutex locked. */
+static int _zygote_start(void)
+{
+	char *const argv[3] = { (char *)conf->stepd_loc, "zygote", NULL};
+	int sock[2];
+	pid_t pid;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sock) < 0) {
+		error("%s: socketpair: %m", __func__);
+		return SLURM_ERROR;
+	}
+	if ((pid = fork()) < 0) {
+		error("%s: fork: %m", __func__);
+		close(sock[0]);
+		close(sock[1]);
+		return SLURM_ERROR;
+	} else if (pid == 0) {
+		setenv("SLURM_CONF", conf->conffile, 1);
+		if (sock[1] != conf->lfd)
+			slurm_shutdown_msg_engine(conf->lfd);
+		(void) close(sock[0]);
+		if ((dup2(sock[1], STDIN_FILENO) == -1) ||
+		    (dup2(devnull, STDOUT_FILENO) == -1) ||
+		    (dup2(devnull, STDERR_FILENO) == -1)) {
+			error("%s: dup2: %m", __func__);
+			exit(1);
+		}
+		fd_set_noclose_on_exec(STDIN_FILENO);
+		fd_set_noclose_on_exec(STDOUT_FILENO);
+		fd_set_noclose_on_exec(STDERR_FILENO);
+		log_fini();
+		execvp(argv[0], argv);
+		error("exec of slurmstepd zygote failed: %m");
+		exit(2);
+	}
+
+	close(sock[1]);
+	fd_set_close_on_exec(sock[0]);
+	zygote_fd = sock[0];
+	zygote_pid = pid;
+	debug("started slurmstepd zygote pid %d", (int) pid);
+	return SLURM_SUCCESS;
+}
+
+/* Stop the slurmstepd zygote. Call with zygote_mutex locked. */
+static void _zygote_stop(void)
+{
+	if (zygote_fd < 0)
+		return;
+	/* The zygote exits once it reads EOF */
+	close(zygote_fd);
+	if (waitpid(zygote_pid, NULL, 0) < 0)
+		error("Unable to reap slurmstepd zygote: %m");
+	zygote_fd = -1;
+	zygote_pid = -1;
+}
+
+/*
+ * Stop the slurmstepd zygote, if any, so that the next step launch starts
+ * a new one with the current configuration and plugins.
+ */
+extern void stop_stepd_zygote(void)
+{
+	slurm_mutex_lock(&zygote_mutex);
+	_zygote_stop();
+	slurm_mutex_unlock(&zygote_mutex);
+}
+
+/*
+ * Have the slurmstepd zygote fork a new slurmstepd reading from to_stepd
+ * and writing to to_slurmd, starting the zygote if needed.
+ * RET SLURM_SUCCESS or SLURM_ERROR if slurmstepd must be exec'd instead
+ */
+static int _zygote_fork(int *to_stepd, int *to_slurmd)
+{
+	int fds[2] = { to_stepd[0], to_slurmd[1] };
+	int i, rc = SLURM_ERROR;
+
+	if (!_zygote_enabled())
+		return SLURM_ERROR;
+
+	slurm_mutex_lock(&zygote_mutex);
+	/* Restart the zygote once if it has gone away */
+	for (i = 0; (i < 2) && (rc != SLURM_SUCCESS); i++) {
+		if ((zygote_fd < 0) && (_zygote_start() != SLURM_SUCCESS))
+			break;
+		if (fd_send_fds(zygote_fd, fds, 2) == 0) {
+			rc = SLURM_SUCCESS;
+		} else {
+			error("Unable to reach slurmstepd zygote: %m");
+			_zygote_stop();
+		}
+	}
+	slurm_mutex_unlock(&zygote_mutex);
+
+	return rc;
+}
+
 /*
  * Fork and exec the slurmstepd, then send the slurmstepd its
  * initialization data.  Then wait for slurmstepd to send an "ok"
@@ -745,9 +879,10 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		     slurm_addr_t *cli, slurm_addr_t *self,
 		     const hostset_t step_hset, uint16_t protocol_version)
 {
-	pid_t pid;
+	pid_t pid = 0;
 	int to_stepd[2] = {-1, -1};
 	int to_slurmd[2] = {-1, -1};
+	bool zygote;
 
 	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
 		error("_forkexec_slurmstepd pipe failed: %m");
@@ -759,7 +894,8 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		return SLURM_FAILURE;
 	}
 
-	if ((pid = fork()) < 0) {
+	zygote = (_zygote_fork(to_stepd, to_slurmd) == SLURM_SUCCESS);
+	if (!zygote && ((pid = fork()) < 0)) {
 		error("_forkexec_slurmstepd: fork: %m");
 		close(to_stepd[0]);
 		close(to_stepd[1]);
@@ -767,7 +903,7 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		close(to_slurmd[1]);
 		_remove_starting_step(type, req);
 		return SLURM_FAILURE;
-	} else if (pid > 0) {
+	} else if (zygote || (pid > 0)) {
 		int rc = 0;
 #ifndef SLURMSTEPD_MEMCHECK
 		int i;
@@ -814,8 +950,8 @@ _forkexec_slurmstepd(uint16_t type, void *req,
 		if (_remove_starting_step(type, req))
 			error("Error cleaning up starting_step list");
 
-		/* Reap child */
-		if (waitpid(pid, NULL, 0) < 0)
+		/* Reap child, the zygote reaps its own */
+		if (!zygote && (waitpid(pid, NULL, 0) < 0))
 			error("Unable to reap slurmd child process");
 		if (close(to_stepd[1]) < 0)
 			error("close write to_stepd in parent: %m");
@@ -2072,6 +2208,10 @@ _launch_job_fail(uint32_t job_id, uint32_t slurm_rc)
 	return slurm_send_recv_controller_rc_msg(&resp_msg, &rc);
 }
 
+/*
+ *  Tell slurmctld that a step failed to launch on this node.
+ *  If enabled, use message aggregation.
+ */
 static int
 _abort_step(uint32_t job_id, uint32_t step_id)
 {
@@ -2080,6 +2220,25 @@ _abort_step(uint32_t job_id, uint32_t step_id)
 	slurm_msg_t_init(&resp_msg);
 	int rc, rc2;
 
+	if (conf->msg_aggr_window_msgs > 1) {
+		/* message aggregation is enabled, the RPC return code is
+		 * ignored below so there is no need to wait for it */
+		slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+		step_complete_msg_t *req =
+			xmalloc(sizeof(step_complete_msg_t));
+
+		slurm_msg_t_init(msg);
+		req->job_id      = job_id;
+		req->job_step_id = step_id;
+		req->step_rc     = 1;
+		req->jobacct     = jobacctinfo_create(NULL);
+		msg->msg_type    = REQUEST_STEP_COMPLETE;
+		msg->data        = req;
+
+		msg_aggr_add_msg(msg, 0);
+		return SLURM_SUCCESS;
+	}
+
 	resp.job_id       = job_id;
 	resp.job_step_id  = step_id;
 	resp.range_first  = 0;
@@ -2430,6 +2589,77 @@ _enforce_job_mem_limit(void)
 	xfree(job_mem_info_ptr);
 }
 
+/*
+ * Reply to a ping forwarded down a tree with a single message naming every
+ * node of our subtree that answered, rather than one reply per node.
+ * Replies of other types (e.g. failed forwards) are sent along unchanged.
+ */
+static void
+_send_ping_resp_list(slurm_msg_t *msg)
+{
+	slurm_msg_t resp_msg;
+	ping_slurmd_resp_list_msg_t ping_resp;
+	ping_slurmd_resp_msg_t *node_resp;
+	ping_slurmd_resp_list_msg_t *list_resp;
+	ret_data_info_t *ret_data_info;
+	ListIterator itr;
+	hostlist_t hl;
+	uint32_t cpu_load;
+	int load_size = 16;
+
+	forward_wait(msg);
+
+	hl = hostlist_create(conf->node_name);
+	ping_resp.node_cnt = 1;
+	ping_resp.cpu_load = xmalloc(sizeof(uint32_t) * load_size);
+	get_cpu_load(&cpu_load);
+	ping_resp.cpu_load[0] = cpu_load;
+	if (msg->ret_list) {
+		itr = list_iterator_create(msg->ret_list);
+		while ((ret_data_info = list_next(itr))) {
+			if (ret_data_info->type == RESPONSE_PING_SLURMD) {
+				node_resp = ret_data_info->data;
+				hostlist_push_host(hl,
+						   ret_data_info->node_name);
+				cpu_load = node_resp->cpu_load;
+				if (ping_resp.node_cnt >= load_size) {
+					load_size *= 2;
+					xrealloc(ping_resp.cpu_load,
+						 sizeof(uint32_t) * load_size);
+				}
+				ping_resp.cpu_load[ping_resp.node_cnt++] =
+					cpu_load;
+			} else if (ret_data_info->type ==
+				   RESPONSE_PING_SLURMD_LIST) {
+				list_resp = ret_data_info->data;
+				hostlist_push(hl, list_resp->node_list);
+				while ((ping_resp.node_cnt + list_resp->node_cnt)
+				       > load_size)
+					load_size *= 2;
+				xrealloc(ping_resp.cpu_load,
+					 sizeof(uint32_t) * load_size);
+				memcpy(ping_resp.cpu_load + ping_resp.node_cnt,
+				       list_resp->cpu_load,
+				       sizeof(uint32_t) * list_resp->node_cnt);
+				ping_resp.node_cnt += list_resp->node_cnt;
+			} else
+				continue;
+			list_delete_item(itr);
+		}
+		list_iterator_destroy(itr);
+	}
+	ping_resp.node_list = hostlist_ranged_string_xmalloc(hl);
+	hostlist_destroy(hl);
+
+	slurm_msg_t_copy(&resp_msg, msg);
+	resp_msg.msg_type = RESPONSE_PING_SLURMD_LIST;
+	resp_msg.data     = &ping_resp;
+	slurm_send_node_msg(msg->conn_fd, &resp_msg);
+
+	xfree(ping_resp.node_list);
+	xfree(ping_resp.cpu_load);
+}
+
 static int
 _rpc_ping(slurm_msg_t *msg)
 {
@@ -2461,6 +2691,8 @@ _rpc_ping(slurm_msg_t *msg)
 			error("Error responding to ping: %m");
 			send_registration_msg(SLURM_SUCCESS, false);
 		}
+	} else if (msg->flags & SLURM_MSG_AGGR_RESP) {
+		_send_ping_resp_list(msg);
 	} else {
 		slurm_msg_t resp_msg;
 		ping_slurmd_resp_msg_t ping_resp;
@@ -2504,7 +2736,7 @@ _rpc_health_check(slurm_msg_t *msg)
 	if ((rc == SLURM_SUCCESS) && (conf->health_check_program)) {
 		char *env[1] = { NULL };
 		rc = run_script("health_check", conf->health_check_program,
-				0, 60, env, 0);
+				0, 60, env, 0, false);
 	}
 
 	/* Take this opportunity to enforce any job memory limits */
@@ -2692,6 +2924,12 @@ done2:
 
 static void
 _rpc_signal_tasks(slurm_msg_t *msg)
+{
+	slurm_send_rc_msg(msg, _signal_tasks(msg));
+}
+
+static int
+_signal_tasks(slurm_msg_t *msg)
 {
 	int               rc = SLURM_SUCCESS;
 	uid_t             req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
@@ -2712,7 +2950,7 @@ _rpc_signal_tasks(slurm_msg_t *msg)
 		rc = _signal_jobstep(req->job_id, req->job_step_id, req_uid,
 				     req->signal);
 	}
-	slurm_send_rc_msg(msg, rc);
+	return rc;
 }
 
 static void
@@ -2916,6 +3154,7 @@ _rpc_daemon_status(slurm_msg_t *msg)
 	resp->step_list          = _get_step_list();
 	resp->last_slurmctld_msg = last_slurmctld_msg;
 	resp->pid                = conf->pid;
+	resp->script_stats       = run_script_stats();
 	resp->slurmd_debug       = conf->debug_level;
 	resp->slurmd_logfile     = xstrdup(conf->logfile);
 	resp->version            = xstrdup(SLURM_VERSION_STRING);
@@ -4780,6 +5019,102 @@ _rpc_terminate_job(slurm_msg_t *msg)
 	_epilog_complete(req->job_id, rc);
 }
 
+static void *_node_msg_terminate_job(void *arg)
+{
+	_rpc_terminate_job((slurm_msg_t *) arg);
+	return NULL;
+}
+
+/*
+ * Process messages of a single type which slurmctld coalesced into one
+ * RPC. Every message is handled as if it arrived alone, except that their
+ * return codes are sent back together. Job terminations can block for as
+ * long as KillWait and the epilog take, so they run in parallel after the
+ * reply and report to slurmctld through their epilog complete messages.
+ */
+static void
+_rpc_node_msg_list(slurm_msg_t *msg)
+{
+	node_msg_list_t *req = msg->data;
+	node_msg_list_resp_msg_t resp;
+	slurm_msg_t resp_msg, *sub_msgs;
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	pthread_attr_t attr;
+	pthread_t *threads;
+	ListIterator itr;
+	int i, cnt;
+
+	if (!_slurm_authorized_user(uid)) {
+		error("Security violation: node_msg_list from uid %d", uid);
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return;
+	}
+
+	cnt = list_count(req->data_list);
+	debug2("Processing %d coalesced %s RPCs", cnt,
+	       rpc_num2string(req->msg_type));
+	resp.rc_cnt = cnt;
+	resp.rc_array = xmalloc(sizeof(uint32_t) * cnt);
+	sub_msgs = xmalloc(sizeof(slurm_msg_t) * cnt);
+	threads = xmalloc(sizeof(pthread_t) * cnt);
+
+	itr = list_iterator_create(req->data_list);
+	for (i = 0; i < cnt; i++) {
+		memcpy(&sub_msgs[i], msg, sizeof(slurm_msg_t));
+		sub_msgs[i].msg_type = req->msg_type;
+		sub_msgs[i].data = list_next(itr);
+		sub_msgs[i].conn_fd = -1;
+		sub_msgs[i].forward_struct = NULL;
+		sub_msgs[i].ret_list = NULL;
+		forward_init(&sub_msgs[i].forward, NULL);
+
+		switch (req->msg_type) {
+		case REQUEST_SIGNAL_TASKS:
+			resp.rc_array[i] = _signal_tasks(&sub_msgs[i]);
+			break;
+		case REQUEST_TERMINATE_JOB:
+			resp.rc_array[i] = SLURM_SUCCESS;
+			break;
+		default:
+			error("%s: invalid request msg type %u", __func__,
+			      req->msg_type);
+			resp.rc_array[i] = EINVAL;
+			break;
+		}
+	}
+	list_iterator_destroy(itr);
+
+	slurm_msg_t_copy(&resp_msg, msg);
+	resp_msg.msg_type = RESPONSE_NODE_MSG_LIST;
+	resp_msg.data = &resp;
+	slurm_send_node_msg(msg->conn_fd, &resp_msg);
+	xfree(resp.rc_array);
+
+	if (req->msg_type == REQUEST_TERMINATE_JOB) {
+		if (slurm_close(msg->conn_fd) < 0)
+			error("%s: close(%d): %m", __func__, msg->conn_fd);
+		msg->conn_fd = -1;
+
+		slurm_attr_init(&attr);
+		for (i = 0; i < cnt; i++) {
+			if (pthread_create(&threads[i], &attr,
+					   _node_msg_terminate_job,
+					   &sub_msgs[i])) {
+				error("%s: pthread_create: %m", __func__);
+				threads[i] = 0;
+				_rpc_terminate_job(&sub_msgs[i]);
+			}
+		}
+		slurm_attr_destroy(&attr);
+		for (i = 0; i < cnt; i++) {
+			if (threads[i])
+				pthread_join(threads[i], NULL);
+		}
+	}
+	xfree(threads);
+	xfree(sub_msgs);
+}
+
 /* On a parallel job, every slurmd may send the EPILOG_COMPLETE
  * message to the slurmctld at the same time, resulting in lost
  * messages. We add a delay here to spead out the message traffic
@@ -5139,7 +5474,9 @@ static int _run_job_script(const char *name, const char *path,
 	 */
 	if (conf->plugstack && (stat(conf->plugstack, &stat_buf) == 0))
 		status = _run_spank_job_script(name, env, jobid, uid);
-	if ((rc = run_script(name, path, jobid, timeout, env, uid)))
+	if ((rc = run_script(name, path, jobid, timeout, env, uid,
+			     slurmctld_conf.prolog_flags &
+			     PROLOG_FLAG_PARALLEL)))
 		status = rc;
 	return (status);
 }
@@ -55,4 +55,7 @@ int init_gids_cache(int cache);
 /* Add record for every launched job so we know they are ready for suspend */
 extern void record_launched_jobs(void);
 
+/* Stop the slurmstepd zygote, it is restarted by the next step launch */
+extern void stop_stepd_zygote(void);
+
 #endif
@@ -52,6 +52,7 @@
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <grp.h>
+#include <poll.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
@@ -90,6 +91,7 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_jobacct_gather.h"
 #include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_pack.h"
 #include "src/common/slurm_route.h"
 #include "src/common/slurm_strcasestr.h"
 #include "src/common/slurm_topology.h"
@@ -118,6 +120,11 @@
 #endif
 
 #define MAX_THREADS		256
+#define MAX_CONNS		1024	/* connections being read at once */
+#define WORKER_MIN		4	/* idle workers always kept */
+#define WORKER_IDLE_TIME	60	/* seconds before extra workers exit */
+#define WORKER_RESERVE		32	/* workers kept for urgent messages */
+#define MAX_MSG_SIZE		(1024*1024*1024)
 
 #define _free_and_set(__dst, __src) \
 	xfree(__dst); __dst = __src
@@ -138,8 +145,27 @@ static pthread_mutex_t fork_mutex     = PTHREAD_MUTEX_INITIALIZER;
 typedef struct connection {
 	slurm_fd_t fd;
 	slurm_addr_t *cli_addr;
+	uint32_t len;		/* message length, network order at first */
+	uint32_t offset;	/* bytes read of length or message */
+	char *data;		/* message, without its length */
+	time_t deadline;	/* time by which message must be read */
+	bool urgent;		/* job launch or termination message */
 } conn_t;
 
+/*
+ * Messages read by _msg_engine() waiting for a worker thread. Urgent
+ * messages are serviced first and only they may use the last
+ * WORKER_RESERVE workers, so slurmd keeps launching and terminating jobs
+ * while flooded with pings and messages to forward.
+ */
+static List            urgent_conn_list = NULL;
+static List            other_conn_list  = NULL;
+static int             worker_cnt       = 0;	/* worker threads */
+static int             worker_idle      = 0;	/* workers waiting for work */
+static int             worker_other     = 0;	/* workers on other_conn_list */
+static pthread_mutex_t worker_mutex     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  worker_cond      = PTHREAD_COND_INITIALIZER;
+
 /*
  * Global data for resource specialization
  */
@@ -170,7 +196,11 @@ static void      _destroy_conf(void);
 static int       _drain_node(char *reason);
 static void      _fill_registration_msg(slurm_node_registration_status_msg_t *);
 static uint64_t  _get_int(const char *my_str);
-static void      _handle_connection(slurm_fd_t fd, slurm_addr_t *client);
+static void      _conn_destroy(conn_t *con);
+static int       _conn_recv(conn_t *con);
+static bool      _conn_urgent(conn_t *con);
+static conn_t   *_next_conn(void);
+static void      _queue_connection(conn_t *con);
 static void      _hup_handler(int);
 static void      _increment_thd_count(void);
 static void      _init_conf(void);
@@ -190,7 +220,7 @@ static void      _resource_spec_fini(void);
 static int       _resource_spec_init(void);
 static int       _restore_cred_state(slurm_cred_ctx_t ctx);
 static void      _select_spec_cores(void);
-static void     *_service_connection(void *);
+static void      _service_connection(conn_t *con);
 static void      _set_msg_aggr_params(void);
 static int       _set_slurmd_spooldir(void);
 static int       _set_topo_info(void);
@@ -198,6 +228,7 @@ static int       _slurmd_init(void);
 static int       _slurmd_fini(void);
 static void      _spawn_registration_engine(void);
 static void      _term_handler(int);
+static void     *_worker(void *arg);
 static void      _update_logging(void);
 static void      _update_nice(void);
 static void      _usage(void);
@@ -439,14 +470,25 @@ _registration_engine(void *arg)
 	return NULL;
 }
 
+/*
+ * _msg_engine - Accept connections and read their message without a thread
+ *	per connection, then queue the message for a worker thread.
+ */
 static void
 _msg_engine(void)
 {
 	slurm_addr_t *cli;
 	slurm_fd_t sock;
+	conn_t **conns, *con;
+	struct pollfd *pfds;
+	time_t now;
+	int conn_cnt = 0, i, rc;
 
 	msg_pthread = pthread_self();
 	slurmd_req(NULL);	/* initialize timer */
+	conns = xmalloc(sizeof(conn_t *) * MAX_CONNS);
+	pfds  = xmalloc(sizeof(struct pollfd) * (MAX_CONNS + 1));
+	fd_set_nonblocking(conf->lfd);
 	while (!_shutdown) {
 		if (_reconfig) {
 			verbose("got reconfigure request");
@@ -454,24 +496,245 @@ _msg_engine(void)
 			_reconfigure();
 		}
 
-		cli = xmalloc (sizeof (slurm_addr_t));
-		if ((sock = slurm_accept_msg_conn(conf->lfd, cli)) >= 0) {
-			_handle_connection(sock, cli);
+		/* Stop accepting while at the limit of connections */
+		pfds[0].fd = (conn_cnt < MAX_CONNS) ? conf->lfd : -1;
+		pfds[0].events = POLLIN;
+		pfds[0].revents = 0;
+		for (i = 0; i < conn_cnt; i++) {
+			pfds[i + 1].fd = conns[i]->fd;
+			pfds[i + 1].events = POLLIN;
+			pfds[i + 1].revents = 0;
+		}
+		if ((poll(pfds, conn_cnt + 1, 1000) < 0) && (errno != EINTR)) {
+			error("poll: %m");
 			continue;
 		}
-		/*
-		 *  Otherwise, accept() failed.
-		 */
-		xfree (cli);
-		if (errno == EINTR)
+
+		now = time(NULL);
+		for (i = 0; i < conn_cnt; ) {
+			con = conns[i];
+			rc = 0;
+			if (pfds[i + 1].revents)
+				rc = _conn_recv(con);
+			if ((rc == 0) && (now >= con->deadline)) {
+				error("service_connection: slurm_receive_msg: "
+				      "%s", slurm_strerror(
+					      SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT));
+				rc = -1;
+			}
+			if (rc == 0) {
+				i++;
+				continue;
+			}
+			/* Move the last connection and its events here */
+			conns[i] = conns[--conn_cnt];
+			pfds[i + 1] = pfds[conn_cnt + 1];
+			if (rc < 0)
+				_conn_destroy(con);
+			else
+				_queue_connection(con);
+		}
+
+		if (!(pfds[0].revents & POLLIN))
 			continue;
-		error("accept: %m");
+		while (conn_cnt < MAX_CONNS) {
+			cli = xmalloc(sizeof(slurm_addr_t));
+			if ((sock = slurm_accept_msg_conn(conf->lfd, cli)) < 0) {
+				xfree(cli);
+				if ((errno != EAGAIN) && (errno != EWOULDBLOCK) &&
+				    (errno != EINTR))
+					error("accept: %m");
+				break;
+			}
+			fd_set_nonblocking(sock);
+			fd_set_close_on_exec(sock);
+			con = xmalloc(sizeof(conn_t));
+			con->fd       = sock;
+			con->cli_addr = cli;
+			con->deadline = now + slurm_get_msg_timeout();
+			conns[conn_cnt++] = con;
+		}
 	}
 	verbose("got shutdown request");
+	for (i = 0; i < conn_cnt; i++)
+		_conn_destroy(conns[i]);
+	xfree(conns);
+	xfree(pfds);
+	slurm_mutex_lock(&worker_mutex);
+	pthread_cond_broadcast(&worker_cond);
+	slurm_mutex_unlock(&worker_mutex);
 	slurm_shutdown_msg_engine(conf->lfd);
 	return;
 }
 
+/*
+ * Read as much of a connection's message as is available
+ * RET 1 if the message is complete, 0 if more is needed, -1 on error
+ */
+static int
+_conn_recv(conn_t *con)
+{
+	ssize_t n;
+
+	while (!con->data) {
+		n = recv(con->fd, (char *) &con->len + con->offset,
+			 sizeof(con->len) - con->offset, 0);
+		if ((n < 0) && ((errno == EINTR) || (errno == EAGAIN) ||
+				(errno == EWOULDBLOCK)))
+			return 0;
+		if (n <= 0) {
+			if (n < 0)
+				error("service_connection: recv: %m");
+			return -1;
+		}
+		con->offset += n;
+		if (con->offset < sizeof(con->len))
+			continue;
+		con->len = ntohl(con->len);
+		if (con->len > MAX_MSG_SIZE) {
+			error("service_connection: slurm_receive_msg: %s",
+			      slurm_strerror(SLURM_PROTOCOL_INSANE_MSG_LENGTH));
+			return -1;
+		}
+		con->data = xmalloc_nz(con->len ? con->len : 1);
+		con->offset = 0;
+	}
+
+	while (con->offset < con->len) {
+		n = recv(con->fd, con->data + con->offset,
+			 con->len - con->offset, 0);
+		if ((n < 0) && ((errno == EINTR) || (errno == EAGAIN) ||
+				(errno == EWOULDBLOCK)))
+			return 0;
+		if (n <= 0) {
+			if (n < 0)
+				error("service_connection: recv: %m");
+			return -1;
+		}
+		con->offset += n;
+	}
+	return 1;
+}
+
+static void
+_conn_destroy(conn_t *con)
+{
+	if ((con->fd >= 0) && (slurm_close(con->fd) < 0))
+		error ("close(%d): %m", con->fd);
+	xfree(con->cli_addr);
+	xfree(con->data);
+	xfree(con);
+}
+
+/* Return true if the connection's message launches or terminates jobs */
+static bool
+_conn_urgent(conn_t *con)
+{
+	uint16_t msg_type;
+
+	if (peek_header_msg_type(&msg_type, con->data, con->len))
+		return false;
+	switch (msg_type) {
+	case REQUEST_LAUNCH_PROLOG:
+	case REQUEST_BATCH_JOB_LAUNCH:
+	case REQUEST_LAUNCH_TASKS:
+	case REQUEST_SIGNAL_TASKS:
+	case REQUEST_TERMINATE_TASKS:
+	case REQUEST_KILL_PREEMPTED:
+	case REQUEST_KILL_TIMELIMIT:
+	case REQUEST_ABORT_JOB:
+	case REQUEST_TERMINATE_JOB:
+	case REQUEST_NODE_MSG_LIST:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Queue a connection whose message has been read for a worker thread */
+static void
+_queue_connection(conn_t *con)
+{
+	pthread_attr_t attr;
+	pthread_t id;
+	int queued;
+
+	fd_set_blocking(con->fd);
+	con->urgent = _conn_urgent(con);
+
+	slurm_mutex_lock(&worker_mutex);
+	if (!urgent_conn_list) {
+		urgent_conn_list = list_create(NULL);
+		other_conn_list  = list_create(NULL);
+	}
+	list_append(con->urgent ? urgent_conn_list : other_conn_list, con);
+	queued = list_count(urgent_conn_list) + list_count(other_conn_list);
+	if ((queued > worker_idle) && (worker_cnt < MAX_THREADS)) {
+		slurm_attr_init(&attr);
+		if (pthread_attr_setdetachstate(&attr,
+						PTHREAD_CREATE_DETACHED) ||
+		    pthread_create(&id, &attr, _worker, NULL))
+			error("msg_engine: pthread_create: %m");
+		else
+			worker_cnt++;
+		slurm_attr_destroy(&attr);
+	}
+	pthread_cond_signal(&worker_cond);
+	slurm_mutex_unlock(&worker_mutex);
+}
+
+/* Return the next queued connection a worker may service, NULL if none.
+ * Call with worker_mutex locked. */
+static conn_t *
+_next_conn(void)
+{
+	conn_t *con = NULL;
+
+	if (urgent_conn_list)
+		con = list_dequeue(urgent_conn_list);
+	if (!con && other_conn_list &&
+	    (worker_other < (MAX_THREADS - WORKER_RESERVE)) &&
+	    (con = list_dequeue(other_conn_list)))
+		worker_other++;
+	return con;
+}
+
+/* Worker thread servicing queued connections */
+static void *
+_worker(void *arg)
+{
+	struct timespec ts;
+	conn_t *con;
+	bool urgent;
+	int rc;
+
+	slurm_mutex_lock(&worker_mutex);
+	while (!_shutdown) {
+		if (!(con = _next_conn())) {
+			worker_idle++;
+			ts.tv_sec  = time(NULL) + WORKER_IDLE_TIME;
+			ts.tv_nsec = 0;
+			rc = pthread_cond_timedwait(&worker_cond,
+						    &worker_mutex, &ts);
+			worker_idle--;
+			if ((rc == ETIMEDOUT) && (worker_cnt > WORKER_MIN))
+				break;
+			continue;
+		}
+		urgent = con->urgent;
+		slurm_mutex_unlock(&worker_mutex);
+
+		_service_connection(con);
+
+		slurm_mutex_lock(&worker_mutex);
+		if (!urgent)
+			worker_other--;
+	}
+	worker_cnt--;
+	slurm_mutex_unlock(&worker_mutex);
+	return NULL;
+}
+
 static void
 _decrement_thd_count(void)
 {
@@ -529,58 +792,18 @@ _wait_for_all_threads(int secs)
 }
 
 static void
-_handle_connection(slurm_fd_t fd, slurm_addr_t *cli)
-{
-	int            rc;
-	pthread_attr_t attr;
-	pthread_t      id;
-	conn_t         *arg = xmalloc(sizeof(conn_t));
-	int            retries = 0;
-
-	arg->fd       = fd;
-	arg->cli_addr = cli;
-
-	slurm_attr_init(&attr);
-	rc = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
-	if (rc != 0) {
-		errno = rc;
-		xfree(arg);
-		error("Unable to set detachstate on attr: %m");
-		slurm_attr_destroy(&attr);
-		return;
-	}
-
-	fd_set_close_on_exec(fd);
-
-	_increment_thd_count();
-	while (pthread_create(&id, &attr, &_service_connection, (void *)arg)) {
-		error("msg_engine: pthread_create: %m");
-		if (++retries > 3) {
-			error("running service_connection without starting "
-			      "a new thread slurmd will be "
-			      "unresponsive until done");
-
-			_service_connection((void *) arg);
-			info("slurmd should be responsive now");
-			break;
-		}
-		usleep(10);	/* sleep and again */
-	}
-
-	return;
-}
-
-static void *
-_service_connection(void *arg)
+_service_connection(conn_t *con)
 {
-	conn_t *con = (conn_t *) arg;
 	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
 	int rc = SLURM_SUCCESS;
 
+	_increment_thd_count();
 	debug3("in the service_connection");
 	slurm_msg_t_init(msg);
-	if ((rc = slurm_receive_msg_and_forward(con->fd, con->cli_addr, msg, 0))
-	   != SLURM_SUCCESS) {
+	rc = slurm_receive_buf_msg_and_forward(con->fd, con->cli_addr, msg,
+					       con->data, con->len);
+	con->data = NULL;	/* consumed */
+	if (rc != SLURM_SUCCESS) {
 		error("service_connection: slurm_receive_msg: %m");
 		/* if this fails we need to make sure the nodes we forward
 		   to are taken care of and sent back. This way the control
@@ -594,14 +817,12 @@ _service_connection(void *arg)
 		slurmd_req(msg);
 
 cleanup:
-	if ((msg->conn_fd >= 0) && slurm_close(msg->conn_fd) < 0)
-		error ("close(%d): %m", con->fd);
-
-	xfree(con->cli_addr);
-	xfree(con);
+	/* slurmd_req() may have closed the connection already */
+	if (msg->conn_fd < 0)
+		con->fd = -1;
+	_conn_destroy(con);
 	slurm_free_msg(msg);
 	_decrement_thd_count();
-	return NULL;
 }
 
 extern int
@@ -1040,6 +1261,11 @@ _reconfigure(void)
 
 	_print_conf();
 
+	/*
+	 * Pick up the new configuration in newly launched slurmstepds
+	 */
+	stop_stepd_zygote();
+
 	/*
 	 * Make best effort at changing to new public key
 	 */
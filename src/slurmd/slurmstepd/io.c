@@ -68,6 +68,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -92,6 +93,9 @@
 #include "src/slurmd/slurmstepd/fname.h"
 #include "src/slurmd/slurmstepd/slurmstepd.h"
 
+/* Maximum number of messages _client_write() sends with a single writev() */
+#define CLIENT_WRITE_MAX_MSGS 64
+
 /**********************************************************************
  * IO client socket declarations
  **********************************************************************/
@@ -441,14 +445,19 @@ _client_read(eio_obj_t *obj, List objs)
 }
 
 /*
- * Write outgoing packed messages to the client socket.
+ * Write outgoing packed messages to the client socket. Up to
+ * CLIENT_WRITE_MAX_MSGS of the queued messages are gathered into a single
+ * writev(), so many small task writes leave in one network send.
  */
 static int
 _client_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
-	void *buf;
-	int n;
+	struct iovec iov[CLIENT_WRITE_MAX_MSGS];
+	struct io_buf *msg;
+	ListIterator msgs;
+	int iovcnt = 0;
+	ssize_t n;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
 
@@ -472,12 +481,26 @@ _client_write(eio_obj_t *obj, List objs)
 	debug5("  client->out_remaining = %d", client->out_remaining);
 
 	/*
-	 * Write message to socket.
+	 * Gather the rest of the current message and the messages
+	 * queued behind it.
 	 */
-	buf = client->out_msg->data +
+	iov[0].iov_base = client->out_msg->data +
 		(client->out_msg->length - client->out_remaining);
+	iov[0].iov_len = client->out_remaining;
+	iovcnt = 1;
+	msgs = list_iterator_create(client->msg_queue);
+	while ((iovcnt < CLIENT_WRITE_MAX_MSGS) && (msg = list_next(msgs))) {
+		iov[iovcnt].iov_base = msg->data;
+		iov[iovcnt].iov_len = msg->length;
+		iovcnt++;
+	}
+	list_iterator_destroy(msgs);
+
+	/*
+	 * Write messages to socket.
+	 */
 again:
-	if ((n = write(obj->fd, buf, client->out_remaining)) < 0) {
+	if ((n = writev(obj->fd, iov, iovcnt)) < 0) {
 		if (errno == EINTR) {
 			goto again;
 		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
@@ -489,17 +512,22 @@ again:
 			return SLURM_SUCCESS;
 		}
 	}
-	if (n < client->out_remaining) {
-		error("Only wrote %d of %d bytes to socket",
-		      n, client->out_remaining);
-	} else
-		debug5("Wrote %d bytes to socket", n);
-	client->out_remaining -= n;
-	if (client->out_remaining > 0)
-		return SLURM_SUCCESS;
+	debug5("Wrote %zd bytes in %d messages to socket", n, iovcnt);
 
-	_free_outgoing_msg(client->out_msg, client->job);
-	client->out_msg = NULL;
+	/*
+	 * Release every message written in full. The first one not
+	 * written in full becomes the current message.
+	 */
+	while (client->out_msg && (n >= client->out_remaining)) {
+		n -= client->out_remaining;
+		_free_outgoing_msg(client->out_msg, client->job);
+		client->out_msg = NULL;
+		if ((--iovcnt > 0) &&
+		    (client->out_msg = list_dequeue(client->msg_queue)))
+			client->out_remaining = client->out_msg->length;
+	}
+	if (client->out_msg)
+		client->out_remaining -= n;
 
 	return SLURM_SUCCESS;
 }
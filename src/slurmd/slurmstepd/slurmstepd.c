@@ -46,8 +46,10 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <sys/wait.h>
 
 #include "src/common/cpu_frequency.h"
+#include "src/common/fd.h"
 #include "src/common/gres.h"
 #include "src/common/slurm_jobacct_gather.h"
 #include "src/common/slurm_acct_gather_profile.h"
@@ -82,6 +84,9 @@ static stepd_step_rec_t *_step_setup(slurm_addr_t *cli, slurm_addr_t *self,
 static void _step_cleanup(stepd_step_rec_t *job, slurm_msg_t *msg, int rc);
 #endif
 static int _process_cmdline (int argc, char *argv[]);
+static void _zygote(char **argv);
+
+static bool zygote = false;
 
 int slurmstepd_blocked_signals[] = {
 	SIGPIPE, 0
@@ -113,6 +118,10 @@ main (int argc, char *argv[])
 	if (slurm_select_init(1) != SLURM_SUCCESS )
 		fatal( "failed to initialize node selection plugin" );
 
+	/* Only returns in a newly forked slurmstepd */
+	if (zygote)
+		_zygote(argv);
+
 	/* Receive job parameters from the slurmd */
 	_init_from_slurmd(STDIN_FILENO, argv, &cli, &self, &msg,
 			  &ngids, &gids);
@@ -330,9 +339,68 @@ static int _process_cmdline (int argc, char *argv[])
 			exit (1);
 		exit (0);
 	}
+	if ((argc == 2) && (strcmp(argv[1], "zygote") == 0))
+		zygote = true;
 	return (0);
 }
 
+/*
+ * Serve as the slurmstepd zygote of slurmd. The plugins every step needs
+ * are loaded once here, then slurmd passes the pair of pipes it would have
+ * given an exec'd slurmstepd over STDIN_FILENO and we fork a slurmstepd
+ * which is already initialized. Only returns in the new slurmstepd, with
+ * the pipes on STDIN_FILENO and STDOUT_FILENO. Exits when slurmd closes
+ * its end of STDIN_FILENO.
+ */
+static void _zygote(char **argv)
+{
+	log_options_t lopts = LOG_OPTS_INITIALIZER;
+	int fds[2], rc;
+	pid_t pid;
+
+	log_init(argv[0], lopts, LOG_DAEMON, NULL);
+	setproctitle("zygote");
+
+	/* The same plugins as loaded by job_manager(), which are initialized
+	 * only once per process */
+	acct_gather_conf_init();
+	if ((switch_init() != SLURM_SUCCESS) ||
+	    (slurm_proctrack_init() != SLURM_SUCCESS) ||
+	    (jobacct_gather_init() != SLURM_SUCCESS))
+		fatal("slurmstepd zygote: failed to initialize plugins");
+
+	while (fd_recv_fds(STDIN_FILENO, fds, 2) == 0) {
+		if ((pid = fork()) == 0) {
+			/* Fork again, just like slurmd does, so the
+			 * slurmstepd's parent process will be init */
+			if ((setsid() < 0) || ((pid = fork()) < 0)) {
+				rc = errno;
+				(void) write(fds[1], &rc, sizeof(int));
+				_exit(1);
+			} else if (pid > 0)
+				_exit(0);
+
+			/* Replaces our end of the socket to slurmd */
+			if ((dup2(fds[0], STDIN_FILENO) < 0) ||
+			    (dup2(fds[1], STDOUT_FILENO) < 0))
+				_exit(1);
+			(void) close(fds[0]);
+			(void) close(fds[1]);
+			return;
+		}
+
+		if (pid < 0) {
+			rc = errno;
+			(void) write(fds[1], &rc, sizeof(int));
+		} else if (waitpid(pid, NULL, 0) < 0)
+			error("slurmstepd zygote: waitpid: %m");
+		(void) close(fds[0]);
+		(void) close(fds[1]);
+	}
+
+	exit(0);
+}
+
 
 static void
 _send_ok_to_slurmd(int sock)
@@ -52,6 +52,22 @@
 #include "src/slurmdbd/slurmdbd.h"
 #include "src/slurmctld/slurmctld.h"
 
+/* Maximum number of read-only queries (sacct, sacctmgr show, sreport...)
+ * serviced at once.  Each connection thread already has its own database
+ * connection, so these run in parallel with each other and with the
+ * slurmctld writes; the cap just keeps a flood of user queries from
+ * swamping the database the slurmctlds are writing job records to. */
+#define MAX_READ_RPC_COUNT 16
+
+static int             read_rpc_count = 0;
+static pthread_cond_t  read_rpc_cond  = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t read_rpc_lock  = PTHREAD_MUTEX_INITIALIZER;
+
+/* Target size of each DBD_GOT_JOBS page sent in response to
+ * DBD_GET_JOBS_PAGED and DBD_GET_JOBS_NEXT.  A page always holds at
+ * least one job, so this is exceeded by at most one job record. */
+#define JOBS_PAGE_SIZE (1024 * 1024)
+
 /* Local functions */
 static int   _add_accounts(slurmdbd_conn_t *slurmdbd_conn,
 			   Buf in_buffer, Buf *out_buffer, uint32_t *uid);
@@ -93,6 +109,10 @@ static int   _get_events(slurmdbd_conn_t *slurmdbd_conn,
 			 Buf in_buffer, Buf *out_buffer, uint32_t *uid);
 static int   _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn,
 			    Buf in_buffer, Buf *out_buffer, uint32_t *uid);
+static int   _get_jobs_next(slurmdbd_conn_t *slurmdbd_conn,
+			    Buf in_buffer, Buf *out_buffer, uint32_t *uid);
+static int   _get_jobs_paged(slurmdbd_conn_t *slurmdbd_conn,
+			     Buf in_buffer, Buf *out_buffer, uint32_t *uid);
 static int   _get_probs(slurmdbd_conn_t *slurmdbd_conn,
 			Buf in_buffer, Buf *out_buffer, uint32_t *uid);
 static int   _get_qos(slurmdbd_conn_t *slurmdbd_conn,
@@ -181,6 +201,43 @@ static int   _step_complete(slurmdbd_conn_t *slurmdbd_conn,
 static int   _step_start(slurmdbd_conn_t *slurmdbd_conn,
 			 Buf in_buffer, Buf *out_buffer, uint32_t *uid);
 
+/* Return true if msg_type is a read-only query which can be serviced
+ * concurrently with any other request */
+static bool _read_only_rpc(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case DBD_GET_ASSOCS:
+	case DBD_GET_ASSOC_USAGE:
+	case DBD_GET_CLUSTER_USAGE:
+	case DBD_GET_EVENTS:
+	case DBD_GET_JOBS_COND:
+	case DBD_GET_JOBS_PAGED:
+	case DBD_GET_PROBS:
+	case DBD_GET_RESVS:
+	case DBD_GET_TXN:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void _read_rpc_begin(void)
+{
+	slurm_mutex_lock(&read_rpc_lock);
+	while (read_rpc_count >= MAX_READ_RPC_COUNT)
+		pthread_cond_wait(&read_rpc_cond, &read_rpc_lock);
+	read_rpc_count++;
+	slurm_mutex_unlock(&read_rpc_lock);
+}
+
+static void _read_rpc_end(void)
+{
+	slurm_mutex_lock(&read_rpc_lock);
+	read_rpc_count--;
+	pthread_cond_signal(&read_rpc_cond);
+	slurm_mutex_unlock(&read_rpc_lock);
+}
+
 /* Process an incoming RPC
  * slurmdbd_conn IN/OUT - in will that the newsockfd set before
  *       calling and db_conn and rpc_version will be filled in with the init.
@@ -199,6 +256,7 @@ proc_req(slurmdbd_conn_t *slurmdbd_conn,
 	uint16_t msg_type;
 	Buf in_buffer;
 	char *comment = NULL;
+	bool read_rpc = false;
 
 	in_buffer = create_buf(msg, msg_size); /* puts msg into buffer struct */
 	safe_unpack16(&msg_type, in_buffer);
@@ -212,6 +270,13 @@ proc_req(slurmdbd_conn_t *slurmdbd_conn,
 		*out_buffer = make_dbd_rc_msg(slurmdbd_conn->rpc_version,
 					      rc, comment, DBD_INIT);
 	} else {
+		/* Queries from the slurmctld (e.g. loading associations
+		 * at startup) never wait behind the user queries. */
+		if (!slurmdbd_conn->ctld_port && _read_only_rpc(msg_type)) {
+			_read_rpc_begin();
+			read_rpc = true;
+		}
+
 		switch (msg_type) {
 		case DBD_ADD_ACCOUNTS:
 			rc = _add_accounts(slurmdbd_conn,
@@ -298,6 +363,14 @@ proc_req(slurmdbd_conn_t *slurmdbd_conn,
 			rc = _get_jobs_cond(slurmdbd_conn,
 					    in_buffer, out_buffer, uid);
 			break;
+		case DBD_GET_JOBS_NEXT:
+			rc = _get_jobs_next(slurmdbd_conn,
+					    in_buffer, out_buffer, uid);
+			break;
+		case DBD_GET_JOBS_PAGED:
+			rc = _get_jobs_paged(slurmdbd_conn,
+					     in_buffer, out_buffer, uid);
+			break;
 		case DBD_GET_PROBS:
 			rc = _get_probs(slurmdbd_conn,
 					in_buffer, out_buffer, uid);
@@ -474,18 +547,34 @@ proc_req(slurmdbd_conn_t *slurmdbd_conn,
 			break;
 		}
 
+		if (read_rpc)
+			_read_rpc_end();
+
 		if (rc == ESLURM_ACCESS_DENIED)
 			error("CONN:%u Security violation, %s",
 			      slurmdbd_conn->newsockfd,
 			      slurmdbd_msg_type_2_str(msg_type, 1));
 		else if (slurmdbd_conn->ctld_port
+			 && !slurmdbd_conn->in_mult_msg
+			 && (msg_type != DBD_SEND_MULT_MSG)
 			 && !slurmdbd_conf->commit_delay) {
 			/* If we are dealing with the slurmctld do the
 			   commit (SUCCESS or NOT) afterwards since we
 			   do transactions for performance reasons.
 			   (don't ever use autocommit with innodb)
+			   Queued writes are only sent now, so if that
+			   fails the reply has to say so.
 			*/
-			acct_storage_g_commit(slurmdbd_conn->db_conn, 1);
+			if ((acct_storage_g_commit(slurmdbd_conn->db_conn, 1)
+			     != SLURM_SUCCESS) && (rc == SLURM_SUCCESS)) {
+				comment = "Failed to commit";
+				rc = SLURM_ERROR;
+				if (*out_buffer)
+					free_buf(*out_buffer);
+				*out_buffer = make_dbd_rc_msg(
+					slurmdbd_conn->rpc_version, rc,
+					comment, msg_type);
+			}
 		}
 
 	}
@@ -1371,6 +1460,107 @@ static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn,
 	return rc;
 }
 
+/* Pack the next page of slurmdbd_conn->job_list as a DBD_GOT_JOBS
+ * message, removing the jobs sent.  The page is the same as a
+ * DBD_GOT_JOBS list message holding only the jobs packed, and holds no
+ * jobs once the list is drained. */
+static Buf _pack_jobs_page(slurmdbd_conn_t *slurmdbd_conn)
+{
+	slurmdb_job_rec_t *job;
+	uint32_t count = 0, count_offset, end_offset;
+	Buf buffer = init_buf(1024);
+
+	pack16((uint16_t) DBD_GOT_JOBS, buffer);
+	count_offset = get_buf_offset(buffer);
+	pack32(count, buffer);
+	while ((get_buf_offset(buffer) < JOBS_PAGE_SIZE) &&
+	       (job = list_pop(slurmdbd_conn->job_list))) {
+		slurmdb_pack_job_rec(job, slurmdbd_conn->rpc_version, buffer);
+		slurmdb_destroy_job_rec(job);
+		count++;
+	}
+	end_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, count_offset);
+	pack32(count, buffer);
+	set_buf_offset(buffer, end_offset);
+	pack32((uint32_t) SLURM_SUCCESS, buffer);
+
+	return buffer;
+}
+
+static int _get_jobs_next(slurmdbd_conn_t *slurmdbd_conn,
+			  Buf in_buffer, Buf *out_buffer, uint32_t *uid)
+{
+	char *comment = NULL;
+	bool done;
+
+	debug2("DBD_GET_JOBS_NEXT: called");
+	if (!slurmdbd_conn->job_list) {
+		comment = "No DBD_GET_JOBS_PAGED in progress";
+		error("CONN:%u %s", slurmdbd_conn->newsockfd, comment);
+		*out_buffer = make_dbd_rc_msg(slurmdbd_conn->rpc_version,
+					      SLURM_ERROR, comment,
+					      DBD_GET_JOBS_NEXT);
+		return SLURM_ERROR;
+	}
+
+	/* Once the empty page marking the end is sent the query is done */
+	done = !list_count(slurmdbd_conn->job_list);
+	*out_buffer = _pack_jobs_page(slurmdbd_conn);
+	if (done)
+		FREE_NULL_LIST(slurmdbd_conn->job_list);
+
+	return SLURM_SUCCESS;
+}
+
+/* Same as DBD_GET_JOBS_COND, but only the first page of jobs is sent
+ * back.  The rest are held on the connection and sent one page per
+ * DBD_GET_JOBS_NEXT, so the response size no longer grows with the
+ * number of jobs matched. */
+static int _get_jobs_paged(slurmdbd_conn_t *slurmdbd_conn,
+			   Buf in_buffer, Buf *out_buffer, uint32_t *uid)
+{
+	dbd_cond_msg_t *cond_msg = NULL;
+	List job_list;
+	char *comment = NULL;
+	int rc = SLURM_SUCCESS;
+
+	debug2("DBD_GET_JOBS_PAGED: called");
+	if (slurmdbd_unpack_cond_msg(&cond_msg, slurmdbd_conn->rpc_version,
+				     DBD_GET_JOBS_PAGED, in_buffer) !=
+	    SLURM_SUCCESS) {
+		comment = "Failed to unpack DBD_GET_JOBS_PAGED message";
+		error("CONN:%u %s", slurmdbd_conn->newsockfd, comment);
+		*out_buffer = make_dbd_rc_msg(slurmdbd_conn->rpc_version,
+					      SLURM_ERROR, comment,
+					      DBD_GET_JOBS_PAGED);
+		return SLURM_ERROR;
+	}
+
+	/* A new query abandons any earlier one not read to the end */
+	FREE_NULL_LIST(slurmdbd_conn->job_list);
+
+	job_list = jobacct_storage_g_get_jobs_cond(
+		slurmdbd_conn->db_conn, *uid, cond_msg->cond);
+
+	if (!errno) {
+		if (!job_list)
+			job_list = list_create(slurmdb_destroy_job_rec);
+		slurmdbd_conn->job_list = job_list;
+		*out_buffer = _pack_jobs_page(slurmdbd_conn);
+	} else {
+		FREE_NULL_LIST(job_list);
+		*out_buffer = make_dbd_rc_msg(slurmdbd_conn->rpc_version,
+					      errno, slurm_strerror(errno),
+					      DBD_GET_JOBS_PAGED);
+		rc = SLURM_ERROR;
+	}
+
+	slurmdbd_free_cond_msg(cond_msg, DBD_GET_JOBS_PAGED);
+
+	return rc;
+}
+
 static int _get_probs(slurmdbd_conn_t *slurmdbd_conn,
 		      Buf in_buffer, Buf *out_buffer, uint32_t *uid)
 {
@@ -1857,6 +2047,10 @@ end_it:
 	slurmdbd_free_init_msg(init_msg);
 	*out_buffer = make_dbd_rc_msg(slurmdbd_conn->rpc_version,
 				      rc, comment, DBD_INIT);
+	/* Tell the agent we read pipelined requests correctly, older
+	 * agents ignore what follows the reply */
+	if (rc == SLURM_SUCCESS)
+		pack16(SLURM_PROTOCOL_VERSION, *out_buffer);
 
 	return rc;
 }
@@ -3599,6 +3793,8 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
 	/* START_TIMER; */
+	/* Commit once for the lot instead of after every message */
+	slurmdbd_conn->in_mult_msg = true;
 	itr = list_iterator_create(get_msg->my_list);
 	while ((req_buf = list_next(itr))) {
 		ret_buf = NULL;
@@ -3610,11 +3806,37 @@ static int   _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn,
 			break;
 	}
 	list_iterator_destroy(itr);
+	slurmdbd_conn->in_mult_msg = false;
 	/* END_TIMER; */
 	/* info("%d multi took %s", list_count(get_msg->my_list), TIME_STR); */
 
 	slurmdbd_free_list_msg(get_msg);
 
+	if (slurmdbd_conn->ctld_port && !slurmdbd_conf->commit_delay &&
+	    (acct_storage_g_commit(slurmdbd_conn->db_conn, 1) !=
+	     SLURM_SUCCESS)) {
+		/* Have the slurmctld send every message again. In a
+		 * transaction none of them was stored. Without one, each
+		 * batch of queued writes was committed as it was flushed,
+		 * so some may be stored already. Resending those is
+		 * harmless: job starts without a db_index find their row
+		 * through its unique key, the other records are updates or
+		 * inserts on duplicate key, and a resent suspend or resume
+		 * finds the state already set. */
+		int cnt = list_count(list_msg.my_list);
+
+		comment = "Failed to commit";
+		error("CONN:%u DBD_SEND_MULT_MSG: %s %d messages",
+		      slurmdbd_conn->newsockfd, comment, cnt);
+		list_flush(list_msg.my_list);
+		while (cnt--) {
+			list_append(list_msg.my_list,
+				    make_dbd_rc_msg(slurmdbd_conn->rpc_version,
+						    SLURM_ERROR, comment,
+						    DBD_SEND_MULT_MSG));
+		}
+	}
+
 	*out_buffer = init_buf(1024);
 	pack16((uint16_t) DBD_GOT_MULT_MSG, *out_buffer);
 	slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->rpc_version,
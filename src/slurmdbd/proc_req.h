@@ -39,6 +39,7 @@
 #ifndef _PROC_REQ_H
 #define _PROC_REQ_H
 
+#include "src/common/list.h"
 #include "src/common/macros.h"
 #include "src/common/pack.h"
 #include "src/common/slurm_protocol_defs.h"
@@ -46,7 +47,9 @@
 typedef struct {
 	char *cluster_name;
 	uint16_t ctld_port; /* slurmctld_port */
+	bool in_mult_msg; /* processing a DBD_SEND_MULT_MSG, commit after */
 	void *db_conn; /* database connection */
+	List job_list; /* jobs left to send for DBD_GET_JOBS_NEXT */
 	char ip[32];
 	slurm_fd_t newsockfd; /* socket connection descriptor */
 	uint16_t orig_port;
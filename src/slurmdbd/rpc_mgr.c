@@ -287,6 +287,7 @@ static void * _service_connection(void *arg)
 	else
 		debug2("Closed connection %d uid(%d)", conn->newsockfd, uid);
 
+	FREE_NULL_LIST(conn->job_list);
 	xfree(conn->tres_str);
 	xfree(conn->cluster_name);
 	xfree(conn);
@@ -433,9 +434,11 @@ extern bool fd_writeable(slurm_fd_t fd)
 		 * If not then exit out and notify the sender.  This
  		 * is here since a write doesn't always tell you the
 		 * socket is gone, but getting 0 back from a
-		 * nonblocking read means just that.
+		 * nonblocking read means just that. Only peek, the
+		 * client may already have sent its next request.
 		 */
-		if (ufds.revents & POLLHUP || (recv(fd, &temp, 1, 0) == 0)) {
+		if (ufds.revents & POLLHUP ||
+		    (recv(fd, &temp, 1, MSG_PEEK) == 0)) {
 			debug3("Write connection %d closed", fd);
 			return false;
 		}
@@ -256,8 +256,14 @@ int main(int argc, char *argv[])
 		acct_storage_g_commit(db_conn, 1);
 
 		/* this is only ran if not backup */
-		if (rollup_handler_thread)
+		if (rollup_handler_thread) {
 			pthread_join(rollup_handler_thread, NULL);
+			/* The id can be reused by a connection thread,
+			 * don't let _rollup_handler_cancel() hit it */
+			slurm_mutex_lock(&rollup_lock);
+			rollup_handler_thread = 0;
+			slurm_mutex_unlock(&rollup_lock);
+		}
 		if (rpc_handler_thread)
 			pthread_join(rpc_handler_thread, NULL);
 
@@ -0,0 +1,134 @@
+/*****************************************************************************\
+ *  launch-bench.c - measure the latency of launching short batch jobs
+ *****************************************************************************
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Usage: launch-bench [count [nodes]]
+ *
+ * Submit count (default 100) batch jobs running "/bin/true" on nodes
+ * (default 1) nodes, one after the other, and report the time from
+ * submission until each job has finished. Run it once with and once
+ * without LaunchParameters=slurmstepd_zygote to compare the cost of
+ * exec'ing a new slurmstepd for every job.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <slurm/slurm.h>
+
+#define POLL_USEC 2000
+
+static long _delta_usec(struct timeval *start, struct timeval *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000 +
+	       (end->tv_usec - start->tv_usec);
+}
+
+/* Wait for job_id to finish, return its final state or -1 on error */
+static int _wait_job(uint32_t job_id)
+{
+	job_info_msg_t *job_info_msg_ptr = NULL;
+	uint16_t state;
+
+	while (1) {
+		if (slurm_load_job(&job_info_msg_ptr, job_id, SHOW_ALL)) {
+			slurm_perror("slurm_load_job");
+			return -1;
+		}
+		state = job_info_msg_ptr->job_array[0].job_state;
+		slurm_free_job_info_msg(job_info_msg_ptr);
+		if (((state & JOB_STATE_BASE) > JOB_SUSPENDED) &&
+		    !(state & JOB_COMPLETING))
+			return (state & JOB_STATE_BASE);
+		usleep(POLL_USEC);
+	}
+}
+
+/* main is used here for testing purposes only */
+int
+main (int argc, char *argv[])
+{
+	job_desc_msg_t job_mesg;
+	submit_response_msg_t *resp_msg;
+	struct timeval begin, start, end;
+	long usec, min_usec = -1, max_usec = 0, total_usec = 0;
+	char *env[1] = { "PATH=/bin:/usr/bin" };
+	int i, count = 100, nodes = 1, state, failures = 0;
+
+	if (argc > 1)
+		count = atoi(argv[1]);
+	if (argc > 2)
+		nodes = atoi(argv[2]);
+	if ((count < 1) || (nodes < 1)) {
+		fprintf(stderr, "Usage: %s [count [nodes]]\n", argv[0]);
+		return 1;
+	}
+
+	gettimeofday(&begin, NULL);
+	for (i = 0; i < count; i++) {
+		slurm_init_job_desc_msg(&job_mesg);
+		job_mesg.name = "launch-bench";
+		job_mesg.min_nodes = nodes;
+		job_mesg.max_nodes = nodes;
+		job_mesg.user_id = getuid();
+		job_mesg.group_id = getgid();
+		job_mesg.script = "#!/bin/sh\n/bin/true\n";
+		job_mesg.std_out = "/dev/null";
+		job_mesg.std_err = "/dev/null";
+		job_mesg.work_dir = "/tmp";
+		job_mesg.env_size = 1;
+		job_mesg.environment = env;
+
+		gettimeofday(&start, NULL);
+		if (slurm_submit_batch_job(&job_mesg, &resp_msg)) {
+			slurm_perror("slurm_submit_batch_job");
+			failures++;
+			break;
+		}
+		state = _wait_job(resp_msg->job_id);
+		gettimeofday(&end, NULL);
+		if (state != JOB_COMPLETE) {
+			fprintf(stderr, "job %u failed\n", resp_msg->job_id);
+			failures++;
+		}
+		slurm_free_submit_response_response_msg(resp_msg);
+
+		usec = _delta_usec(&start, &end);
+		total_usec += usec;
+		if ((min_usec < 0) || (usec < min_usec))
+			min_usec = usec;
+		if (usec > max_usec)
+			max_usec = usec;
+	}
+	gettimeofday(&end, NULL);
+
+	printf("%d jobs on %d nodes in %.3f sec, %d failed\n",
+	       i, nodes, _delta_usec(&begin, &end) / 1000000.0, failures);
+	if (i > 0) {
+		printf("submit to finish usec: avg %.1f min %ld max %ld\n",
+		       (double) total_usec / i, min_usec, max_usec);
+	}
+
+	return (failures != 0);
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************\
+ *  load_job-bench.c - measure the latency of sequential slurm_load_job calls
+ *****************************************************************************
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Usage: load_job-bench [job_id [count]]
+ *
+ * Issue count (default 10000) sequential slurm_load_job() calls for job_id
+ * (default is the first job known to slurmctld) and report the latency.
+ * Run it once with and once without CommunicationParameters=persist_conn
+ * to compare the cost of a new connection per request.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <slurm/slurm.h>
+
+static long _delta_usec(struct timeval *start, struct timeval *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000000 +
+	       (end->tv_usec - start->tv_usec);
+}
+
+/* main is used here for testing purposes only */
+int
+main (int argc, char *argv[])
+{
+	job_info_msg_t *job_info_msg_ptr = NULL;
+	struct timeval begin, start, end;
+	long usec, min_usec = -1, max_usec = 0, total_usec;
+	uint32_t job_id = 0;
+	int i, count = 10000, failures = 0;
+
+	if (argc > 1)
+		job_id = strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		count = atoi(argv[2]);
+	if (count < 1) {
+		fprintf(stderr, "Usage: %s [job_id [count]]\n", argv[0]);
+		return 1;
+	}
+
+	if (job_id == 0) {
+		if (slurm_load_jobs((time_t) 0, &job_info_msg_ptr, 0)) {
+			slurm_perror("slurm_load_jobs");
+			return 1;
+		}
+		if (job_info_msg_ptr->record_count == 0) {
+			fprintf(stderr, "No jobs found, submit one first\n");
+			return 1;
+		}
+		job_id = job_info_msg_ptr->job_array[0].job_id;
+		slurm_free_job_info_msg(job_info_msg_ptr);
+	}
+
+	gettimeofday(&begin, NULL);
+	for (i = 0; i < count; i++) {
+		gettimeofday(&start, NULL);
+		if (slurm_load_job(&job_info_msg_ptr, job_id, 0)) {
+			failures++;
+			continue;
+		}
+		gettimeofday(&end, NULL);
+		slurm_free_job_info_msg(job_info_msg_ptr);
+
+		usec = _delta_usec(&start, &end);
+		if ((min_usec < 0) || (usec < min_usec))
+			min_usec = usec;
+		if (usec > max_usec)
+			max_usec = usec;
+	}
+	gettimeofday(&end, NULL);
+	total_usec = _delta_usec(&begin, &end);
+
+	printf("job %u: %d calls in %.3f sec, %d failed\n",
+	       job_id, count, total_usec / 1000000.0, failures);
+	printf("latency usec: avg %.1f min %ld max %ld\n",
+	       (double) total_usec / count, min_usec, max_usec);
+
+	return (failures != 0);
+}
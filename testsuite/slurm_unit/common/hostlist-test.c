@@ -0,0 +1,223 @@
+/* Test of src/common/hostlist.c
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <src/common/hostlist.h>
+#include <src/common/xmalloc.h>
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NHOSTS 100000
+
+static long _delta_usec(struct timeval *start)
+{
+	struct timeval end;
+
+	gettimeofday(&end, NULL);
+	return (end.tv_sec - start->tv_sec) * 1000000 +
+	       (end.tv_usec - start->tv_usec);
+}
+
+/* Return a permutation of 0..n-1 */
+static int *_shuffle(int n)
+{
+	int i, j, tmp, *order = xmalloc(sizeof(int) * n);
+
+	for (i = 0; i < n; i++)
+		order[i] = i;
+	srand(1);
+	for (i = n - 1; i > 0; i--) {
+		j = rand() % (i + 1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+	return order;
+}
+
+static int _ranged_equal(hostlist_t hl, char *expect)
+{
+	char *str = hostlist_ranged_string_xmalloc(hl);
+	int rc = !strcmp(str, expect);
+
+	if (!rc)
+		note("got \"%s\", expected \"%s\"", str, expect);
+	xfree(str);
+	return rc;
+}
+
+static int _set_equal(hostset_t set, char *expect)
+{
+	char buf[1024];
+
+	hostset_ranged_string(set, sizeof(buf), buf);
+	if (strcmp(buf, expect)) {
+		note("got \"%s\", expected \"%s\"", buf, expect);
+		return 0;
+	}
+	return 1;
+}
+
+int
+main(int argc, char *argv[])
+{
+	note("Testing hostset insert");
+	{
+		hostset_t set = hostset_create("tux[0-3,12-20]");
+
+		TEST(hostset_insert(set, "tux[5-10]") == 6, "insert 6 hosts");
+		TEST(_set_equal(set, "tux[0-3,5-10,12-20]"), "insert between");
+		TEST(hostset_insert(set, "tux[2-6]") == 1, "insert overlap");
+		TEST(_set_equal(set, "tux[0-10,12-20]"), "join ranges");
+		TEST(hostset_insert(set, "tux11") == 1, "insert single");
+		TEST(_set_equal(set, "tux[0-20]"), "join single");
+		TEST(hostset_insert(set, "tux[0-20]") == 0, "insert dups");
+		TEST(hostset_insert(set, "abc[1-2],zed,tux[021-022]") == 5,
+		     "insert prefixes");
+		TEST(_set_equal(set, "abc[1-2],tux[0-20,021-022],zed"),
+		     "sorted by prefix");
+		TEST(hostset_count(set) == 26, "count");
+		hostset_destroy(set);
+	}
+
+	note("Testing hostset find/within");
+	{
+		hostset_t set = hostset_create("tux[0-9,20-29],lx[1-3],io");
+
+		TEST(hostset_within(set, "tux[0-5,22]"), "within");
+		TEST(hostset_within(set, "lx2,io,tux29"), "within mixed");
+		TEST(!hostset_within(set, "tux[8-20]"), "not within gap");
+		TEST(!hostset_within(set, "tux30"), "not within end");
+		TEST(!hostset_within(set, "lx[1-4]"), "not within prefix");
+		TEST(!hostset_within(set, "ion"), "not within name");
+		TEST(hostset_intersects(set, "tux[15-20]"), "intersects");
+		TEST(!hostset_intersects(set, "tux[10-19]"), "no intersection");
+		TEST(hostset_find(set, "io") == 0, "find single");
+		TEST(hostset_find(set, "tux0") == 4, "find range");
+		TEST(hostset_find(set, "tux21") == 15, "find second range");
+		TEST(hostset_find(set, "tux15") == -1, "find in gap");
+		hostset_destroy(set);
+
+		set = hostset_create("nid0000[2-7],nid00[100-199]");
+		TEST(hostset_within(set, "nid00003"), "within digit prefix");
+		TEST(hostset_within(set, "nid[00004-00007,00150]"),
+		     "within digit prefix range");
+		TEST(!hostset_within(set, "nid00008"), "not within digit prefix");
+		hostset_destroy(set);
+	}
+
+	note("Testing hostlist push");
+	{
+		hostlist_t hl = hostlist_create(NULL);
+
+		hostlist_push_host(hl, "tux01");
+		hostlist_push_host(hl, "tux02");
+		hostlist_push_host(hl, "tux3");
+		hostlist_push_host(hl, "tux5");
+		hostlist_push_host(hl, "tux6");
+		hostlist_push_host(hl, "lx6");
+		hostlist_push_host(hl, "lx7");
+		hostlist_push_host(hl, "io");
+		TEST(hostlist_count(hl) == 8, "count");
+		TEST(_ranged_equal(hl, "tux[01-02,3,5-6],lx[6-7],io"),
+		     "push hosts");
+		TEST(hostlist_find(hl, "lx7") == 6, "find");
+		hostlist_destroy(hl);
+	}
+
+	note("Timing %d host operations", NHOSTS);
+	{
+		struct timeval start;
+		char name[32];
+		int i, found, *order = _shuffle(NHOSTS);
+		hostlist_t hl;
+		hostset_t set;
+		hostlist_iterator_t iter;
+		char *host;
+
+		gettimeofday(&start, NULL);
+		hl = hostlist_create(NULL);
+		for (i = 0; i < NHOSTS; i++) {
+			snprintf(name, sizeof(name), "tux%d", i);
+			hostlist_push_host(hl, name);
+		}
+		TEST(_ranged_equal(hl, "tux[0-99999]"), "push in order");
+		note("hostlist_push_host in order: %ld usec",
+		     _delta_usec(&start));
+
+		gettimeofday(&start, NULL);
+		iter = hostlist_iterator_create(hl);
+		for (i = 0; (host = hostlist_next(iter)); i++)
+			free(host);
+		hostlist_iterator_destroy(iter);
+		TEST(i == NHOSTS, "iterate");
+		note("hostlist_next: %ld usec", _delta_usec(&start));
+
+		gettimeofday(&start, NULL);
+		iter = hostlist_iterator_create(hl);
+		for (i = 0; hostlist_next_buf(iter, 0, name, sizeof(name)); i++)
+			;
+		hostlist_iterator_destroy(iter);
+		TEST(i == NHOSTS, "iterate to buffer");
+		TEST(!strcmp(name, "tux99999"), "last host");
+		note("hostlist_next_buf: %ld usec", _delta_usec(&start));
+		hostlist_destroy(hl);
+
+		gettimeofday(&start, NULL);
+		set = hostset_create(NULL);
+		for (i = 0; i < NHOSTS; i++) {
+			snprintf(name, sizeof(name), "tux%d", order[i]);
+			hostset_insert(set, name);
+		}
+		TEST(hostset_count(set) == NHOSTS, "insert shuffled count");
+		TEST(_set_equal(set, "tux[0-99999]"), "insert shuffled");
+		note("hostset_insert shuffled: %ld usec", _delta_usec(&start));
+		hostset_destroy(set);
+
+		set = hostset_create(NULL);
+		for (i = 0; i < NHOSTS; i++) {
+			if (order[i] & 1)
+				continue;
+			snprintf(name, sizeof(name), "tux%d", order[i]);
+			hostset_insert(set, name);
+		}
+		TEST(hostset_count(set) == NHOSTS / 2, "sparse set count");
+		gettimeofday(&start, NULL);
+		for (i = 0, found = 0; i < NHOSTS; i++) {
+			snprintf(name, sizeof(name), "tux%d", order[i]);
+			if (hostset_within(set, name))
+				found++;
+		}
+		TEST(found == NHOSTS / 2, "within sparse set");
+		note("hostset_within on %d ranges: %ld usec",
+		     NHOSTS / 2, _delta_usec(&start));
+
+		gettimeofday(&start, NULL);
+		hl = hostlist_create(NULL);
+		for (i = 0; i < NHOSTS; i += 2) {
+			snprintf(name, sizeof(name), "tux%d", i);
+			hostlist_push_host(hl, name);
+		}
+		host = hostlist_ranged_string_xmalloc(hl);
+		TEST(hostset_within(set, host), "within many ranges");
+		xfree(host);
+		hostlist_destroy(hl);
+		note("hostset_within of %d ranges: %ld usec",
+		     NHOSTS / 2, _delta_usec(&start));
+		hostset_destroy(set);
+		xfree(order);
+	}
+
+	totals();
+	return failed;
+}
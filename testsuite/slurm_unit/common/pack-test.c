@@ -29,6 +29,73 @@
 		pass( _msg );       \
 } while (0)
 
+typedef struct {
+	uint32_t a32;
+	uint8_t  b8;
+	uint16_t c16;
+	time_t   d_time;
+	uint64_t e64;
+} field_test_t;
+
+#define FIELD_TEST_FIELDS(X)	\
+	X(U32,  a32)		\
+	X(U8,   b8)		\
+	X(U16,  c16)		\
+	X(TIME, d_time)		\
+	X(U64,  e64)
+PACK_DEFINE_FIELDS(field_test, field_test_t, FIELD_TEST_FIELDS)
+
+static void _test_fields(void)
+{
+	Buf buffer;
+	field_test_t in, out;
+	uint32_t out32;
+	uint16_t out16;
+	uint8_t out8;
+	time_t out_time;
+	uint64_t out64;
+	char *data;
+	int data_size;
+
+	in.a32 = 0x01020304;
+	in.b8 = 0x7f;
+	in.c16 = 0xbeef;
+	in.d_time = (time_t) 1437000000;
+	in.e64 = 0x0102030405060708ULL;
+
+	/* Schema packing must produce the same wire format as packN() */
+	buffer = init_buf(0);
+	field_test_pack(&in, buffer);
+	data_size = get_buf_offset(buffer);
+	TEST(data_size != 23, "pack_fields size");
+	data = xfer_buf_data(buffer);
+	buffer = create_buf(data, data_size);
+	unpack32(&out32, buffer);
+	unpack8(&out8, buffer);
+	unpack16(&out16, buffer);
+	unpack_time(&out_time, buffer);
+	unpack64(&out64, buffer);
+	TEST((out32 != in.a32) || (out8 != in.b8) || (out16 != in.c16) ||
+	     (out_time != in.d_time) || (out64 != in.e64),
+	     "pack_fields matches packN wire format");
+
+	/* Schema unpacking of the same buffer */
+	set_buf_offset(buffer, 0);
+	memset(&out, 0, sizeof(out));
+	TEST(field_test_unpack(&out, buffer) ||
+	     (out.a32 != in.a32) || (out.b8 != in.b8) ||
+	     (out.c16 != in.c16) || (out.d_time != in.d_time) ||
+	     (out.e64 != in.e64), "unpack_fields");
+
+	/* A truncated buffer must fail without consuming or modifying */
+	set_buf_offset(buffer, 1);
+	memset(&out, 0, sizeof(out));
+	TEST((field_test_unpack(&out, buffer) != SLURM_ERROR) ||
+	     (get_buf_offset(buffer) != 1) ||
+	     (out.a32 != 0), "unpack_fields on short buffer");
+	free_buf(buffer);
+}
+
 int main (int argc, char *argv[])
 {
 	Buf buffer;
@@ -95,6 +162,9 @@ int main (int argc, char *argv[])
 	xfree(outstring);
 
 	free_buf(buffer);
+
+	_test_fields();
+
 	totals();
 	return failed;
 